@@ -0,0 +1,199 @@
+/**
+ *
+ *  @file Benchmark.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+// The benchmarks are written against the Google Benchmark API. When it isn't
+// installed, this header provides the subset they use: BENCHMARK(...)->Arg(),
+// range-for over State, range(), SetBytesProcessed(), SetItemsProcessed(),
+// DoNotOptimize() and ClobberMemory(), and --benchmark_filter=<regex>.
+
+#pragma once
+
+#ifdef TRANTOR_HAVE_GOOGLE_BENCHMARK
+#include <benchmark/benchmark.h>
+#else
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace benchmark
+{
+class State
+{
+  public:
+    State(int64_t maxIterations, std::vector<int64_t> args)
+        : maxIterations_(maxIterations), args_(std::move(args))
+    {
+    }
+
+    struct Value
+    {
+    };
+    class Iterator
+    {
+      public:
+        explicit Iterator(State *state) : state_(state)
+        {
+        }
+        Value operator*() const
+        {
+            return Value();
+        }
+        Iterator &operator++()
+        {
+            ++state_->iterations_;
+            return *this;
+        }
+        bool operator!=(const Iterator &) const
+        {
+            if (state_->iterations_ < state_->maxIterations_)
+                return true;
+            state_->finish();
+            return false;
+        }
+
+      private:
+        State *state_;
+    };
+    Iterator begin()
+    {
+        start_ = std::chrono::steady_clock::now();
+        return Iterator(this);
+    }
+    Iterator end()
+    {
+        return Iterator(this);
+    }
+
+    int64_t range(size_t index = 0) const
+    {
+        return index < args_.size() ? args_[index] : 0;
+    }
+    int64_t iterations() const
+    {
+        return iterations_;
+    }
+    void SetBytesProcessed(int64_t bytes)
+    {
+        bytesProcessed_ = bytes;
+    }
+    void SetItemsProcessed(int64_t items)
+    {
+        itemsProcessed_ = items;
+    }
+
+    double elapsedSeconds() const
+    {
+        return std::chrono::duration<double>(stop_ - start_).count();
+    }
+    int64_t bytesProcessed() const
+    {
+        return bytesProcessed_;
+    }
+    int64_t itemsProcessed() const
+    {
+        return itemsProcessed_;
+    }
+
+  private:
+    void finish()
+    {
+        stop_ = std::chrono::steady_clock::now();
+    }
+
+    int64_t maxIterations_;
+    int64_t iterations_{0};
+    std::vector<int64_t> args_;
+    int64_t bytesProcessed_{0};
+    int64_t itemsProcessed_{0};
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point stop_;
+};
+
+template <typename T>
+inline void DoNotOptimize(T const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+inline void ClobberMemory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+namespace internal
+{
+using Function = void (*)(State &);
+
+class Benchmark
+{
+  public:
+    Benchmark(const char *name, Function func) : name_(name), func_(func)
+    {
+    }
+    Benchmark *Arg(int64_t arg)
+    {
+        args_.push_back({arg});
+        return this;
+    }
+    Benchmark *Args(const std::vector<int64_t> &args)
+    {
+        args_.push_back(args);
+        return this;
+    }
+
+    const std::string &name() const
+    {
+        return name_;
+    }
+    Function function() const
+    {
+        return func_;
+    }
+    const std::vector<std::vector<int64_t>> &args() const
+    {
+        return args_;
+    }
+
+  private:
+    std::string name_;
+    Function func_;
+    std::vector<std::vector<int64_t>> args_;
+};
+
+Benchmark *registerBenchmark(const char *name, Function func);
+}  // namespace internal
+
+void Initialize(int *argc, char **argv);
+size_t RunSpecifiedBenchmarks();
+}  // namespace benchmark
+
+#define TRANTOR_BENCHMARK_CONCAT2(a, b) a##b
+#define TRANTOR_BENCHMARK_CONCAT(a, b) TRANTOR_BENCHMARK_CONCAT2(a, b)
+#if defined(__GNUC__) || defined(__clang__)
+#define TRANTOR_BENCHMARK_UNUSED __attribute__((unused))
+#else
+#define TRANTOR_BENCHMARK_UNUSED
+#endif
+#define BENCHMARK(func)                                                \
+    static ::benchmark::internal::Benchmark *TRANTOR_BENCHMARK_UNUSED  \
+        TRANTOR_BENCHMARK_CONCAT(benchmark_, __LINE__) =               \
+            ::benchmark::internal::registerBenchmark(#func, func)
+#endif
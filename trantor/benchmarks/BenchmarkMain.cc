@@ -0,0 +1,130 @@
+// The runner of the in-tree benchmark harness, only built when Google
+// Benchmark is not installed. See Benchmark.h.
+
+#include "Benchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <regex>
+
+namespace benchmark
+{
+namespace
+{
+std::vector<std::unique_ptr<internal::Benchmark>> &registry()
+{
+    static std::vector<std::unique_ptr<internal::Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+std::string filter{"."};
+double minTime{0.5};
+
+std::string formatRate(double perSecond, const char *unit)
+{
+    const char *prefixes[] = {"", "k", "M", "G", "T"};
+    size_t i = 0;
+    while (perSecond >= 1000.0 && i + 1 < sizeof(prefixes) / sizeof(*prefixes))
+    {
+        perSecond /= 1000.0;
+        ++i;
+    }
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.2f %s%s/s", perSecond, prefixes[i], unit);
+    return buf;
+}
+
+void runOne(const internal::Benchmark &bench,
+            const std::vector<int64_t> &args,
+            const std::string &name)
+{
+    // Grow the iteration count until a run takes long enough to be measured,
+    // then aim for minTime with the last run
+    int64_t iterations = 1;
+    for (;;)
+    {
+        State state(iterations, args);
+        bench.function()(state);
+        const double elapsed = state.elapsedSeconds();
+        const bool last = elapsed >= minTime || iterations >= 1000000000;
+        if (last)
+        {
+            std::string counters;
+            if (state.bytesProcessed() > 0)
+                counters += formatRate(state.bytesProcessed() / elapsed, "B");
+            if (state.itemsProcessed() > 0)
+            {
+                if (!counters.empty())
+                    counters += "  ";
+                counters +=
+                    formatRate(state.itemsProcessed() / elapsed, "items");
+            }
+            printf("%-48s %14.1f ns %12lld  %s\n",
+                   name.c_str(),
+                   elapsed * 1e9 / static_cast<double>(iterations),
+                   static_cast<long long>(iterations),
+                   counters.c_str());
+            return;
+        }
+        double multiplier = elapsed > 0 ? minTime * 1.4 / elapsed : 100;
+        if (elapsed < minTime / 10)
+            multiplier = (std::min)(multiplier, 10.0);
+        iterations = (std::max)(
+            iterations + 1, static_cast<int64_t>(iterations * multiplier));
+    }
+}
+}  // namespace
+
+namespace internal
+{
+Benchmark *registerBenchmark(const char *name, Function func)
+{
+    registry().emplace_back(new Benchmark(name, func));
+    return registry().back().get();
+}
+}  // namespace internal
+
+void Initialize(int *argc, char **argv)
+{
+    for (int i = 1; i < *argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--benchmark_filter=", 19) == 0)
+            filter = arg + 19;
+        else if (strncmp(arg, "--benchmark_min_time=", 21) == 0)
+            minTime = atof(arg + 21);
+    }
+}
+
+size_t RunSpecifiedBenchmarks()
+{
+    const std::regex re(filter);
+    size_t count = 0;
+    printf("%-48s %17s %12s\n", "Benchmark", "Time", "Iterations");
+    for (auto &bench : registry())
+    {
+        std::vector<std::vector<int64_t>> argLists = bench->args();
+        if (argLists.empty())
+            argLists.emplace_back();
+        for (auto &args : argLists)
+        {
+            std::string name = bench->name();
+            for (auto arg : args)
+                name += "/" + std::to_string(arg);
+            if (!std::regex_search(name, re))
+                continue;
+            runOne(*bench, args, name);
+            ++count;
+        }
+    }
+    return count;
+}
+}  // namespace benchmark
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "Benchmark.h"
+#include <trantor/utils/Date.h>
+#include <string>
+
+using namespace trantor;
+
+static void BM_DateNow(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Date::now());
+}
+BENCHMARK(BM_DateNow);
+
+static void BM_DateFormattedString(benchmark::State &state)
+{
+    auto date = Date::now();
+    for (auto _ : state)
+    {
+        date = date.after(1.0);
+        benchmark::DoNotOptimize(date.toFormattedString(state.range(0) != 0));
+    }
+}
+BENCHMARK(BM_DateFormattedString)->Arg(0)->Arg(1);
+
+static void BM_DateFormattedStringLocal(benchmark::State &state)
+{
+    auto date = Date::now();
+    for (auto _ : state)
+    {
+        date = date.after(1.0);
+        benchmark::DoNotOptimize(
+            date.toFormattedStringLocal(state.range(0) != 0));
+    }
+}
+BENCHMARK(BM_DateFormattedStringLocal)->Arg(0)->Arg(1);
+
+// Time points half a year apart, so every call misses the cached UTC offset
+static void BM_DateFormattedStringLocalMiss(benchmark::State &state)
+{
+    const double halfYear = 182.0 * 24 * 3600;
+    auto date = Date::now();
+    bool forward = true;
+    for (auto _ : state)
+    {
+        date = date.after(forward ? halfYear : -halfYear);
+        forward = !forward;
+        benchmark::DoNotOptimize(date.toFormattedStringLocal(false));
+    }
+}
+BENCHMARK(BM_DateFormattedStringLocalMiss);
+
+static void BM_DateCustomFormattedString(benchmark::State &state)
+{
+    auto date = Date::now();
+    for (auto _ : state)
+    {
+        date = date.after(1.0);
+        benchmark::DoNotOptimize(
+            date.toCustomFormattedString("%Y-%m-%d %H:%M:%S", true));
+    }
+}
+BENCHMARK(BM_DateCustomFormattedString);
+
+static void BM_DateDbString(benchmark::State &state)
+{
+    auto date = Date::now();
+    for (auto _ : state)
+    {
+        date = date.after(1.0);
+        benchmark::DoNotOptimize(date.toDbString());
+    }
+}
+BENCHMARK(BM_DateDbString);
+
+static void BM_DateFromDbString(benchmark::State &state)
+{
+    const std::string str = Date::now().toDbString();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Date::fromDbString(str));
+}
+BENCHMARK(BM_DateFromDbString);
+
+static void BM_DateRoundDay(benchmark::State &state)
+{
+    auto date = Date::now();
+    for (auto _ : state)
+    {
+        date = date.after(3600.0);
+        benchmark::DoNotOptimize(date.roundDay());
+    }
+}
+BENCHMARK(BM_DateRoundDay);
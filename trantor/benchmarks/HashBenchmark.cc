@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+#include <trantor/utils/Utilities.h>
+#include <string>
+
+using namespace trantor::utils;
+
+template <typename F>
+static void runHash(benchmark::State &state, F &&hash)
+{
+    const std::string data(static_cast<size_t>(state.range(0)), 'x');
+    for (auto _ : state)
+        benchmark::DoNotOptimize(hash(data.data(), data.size()));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Md5(benchmark::State &state)
+{
+    runHash(state, [](const void *data, size_t len) { return md5(data, len); });
+}
+BENCHMARK(BM_Md5)->Arg(64)->Arg(4096);
+
+static void BM_Sha1(benchmark::State &state)
+{
+    runHash(state,
+            [](const void *data, size_t len) { return sha1(data, len); });
+}
+BENCHMARK(BM_Sha1)->Arg(64)->Arg(4096);
+
+static void BM_Sha256(benchmark::State &state)
+{
+    runHash(state,
+            [](const void *data, size_t len) { return sha256(data, len); });
+}
+BENCHMARK(BM_Sha256)->Arg(64)->Arg(4096);
+
+static void BM_Sha3(benchmark::State &state)
+{
+    runHash(state,
+            [](const void *data, size_t len) { return sha3(data, len); });
+}
+BENCHMARK(BM_Sha3)->Arg(64)->Arg(4096);
+
+static void BM_Blake2b(benchmark::State &state)
+{
+    runHash(state,
+            [](const void *data, size_t len) { return blake2b(data, len); });
+}
+BENCHMARK(BM_Blake2b)->Arg(64)->Arg(4096);
+
+static void BM_FastHash64(benchmark::State &state)
+{
+    runHash(state, [](const void *data, size_t len) {
+        return fastHash64(data, len);
+    });
+}
+BENCHMARK(BM_FastHash64)->Arg(16)->Arg(64)->Arg(4096);
+
+static void BM_FastHash128(benchmark::State &state)
+{
+    runHash(state, [](const void *data, size_t len) {
+        return fastHash128(data, len);
+    });
+}
+BENCHMARK(BM_FastHash128)->Arg(64)->Arg(4096);
+
+static void BM_HmacSha256(benchmark::State &state)
+{
+    Hmac hmac(HashAlgorithm::SHA256, "secret key");
+    unsigned char mac[32];
+    runHash(state, [&hmac, &mac](const void *data, size_t len) {
+        hmac.sign(data, len, mac);
+        return mac[0];
+    });
+}
+BENCHMARK(BM_HmacSha256)->Arg(64)->Arg(4096);
+
+static void BM_HexEncode(benchmark::State &state)
+{
+    std::string out(static_cast<size_t>(state.range(0)) * 2, '\0');
+    runHash(state, [&out](const void *data, size_t len) {
+        toHexString(data, len, &out[0]);
+        return out[0];
+    });
+}
+BENCHMARK(BM_HexEncode)->Arg(64)->Arg(4096);
+
+static void BM_Base64Encode(benchmark::State &state)
+{
+    std::string out(base64EncodedLength(static_cast<size_t>(state.range(0))),
+                    '\0');
+    runHash(state, [&out](const void *data, size_t len) {
+        return base64Encode(data, len, &out[0]);
+    });
+}
+BENCHMARK(BM_Base64Encode)->Arg(64)->Arg(4096);
+
+static void BM_Base64Decode(benchmark::State &state)
+{
+    const std::string encoded =
+        base64Encode(std::string(static_cast<size_t>(state.range(0)), 'x'));
+    std::string out(base64DecodedMaxLength(encoded.size()), '\0');
+    size_t outLen = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            base64Decode(encoded.data(), encoded.size(), &out[0], outLen));
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(encoded.size()));
+}
+BENCHMARK(BM_Base64Decode)->Arg(64)->Arg(4096);
@@ -0,0 +1,47 @@
+#include "Benchmark.h"
+#include <trantor/net/InetAddress.h>
+
+using namespace trantor;
+
+static void BM_InetAddressFromIpV4(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(InetAddress("192.168.10.20", 8080));
+}
+BENCHMARK(BM_InetAddressFromIpV4);
+
+static void BM_InetAddressFromIpV6(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            InetAddress("2001:db8::8a2e:370:7334", 8080, true));
+}
+BENCHMARK(BM_InetAddressFromIpV6);
+
+static void BM_InetAddressToIpPortV4(benchmark::State &state)
+{
+    InetAddress addr("192.168.10.20", 8080);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(addr.toIpPort());
+}
+BENCHMARK(BM_InetAddressToIpPortV4);
+
+static void BM_InetAddressToIpPortV6(benchmark::State &state)
+{
+    InetAddress addr("2001:db8::8a2e:370:7334", 8080, true);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(addr.toIpPort());
+}
+BENCHMARK(BM_InetAddressToIpPortV6);
+
+static void BM_InetAddressIsIntranetIp(benchmark::State &state)
+{
+    InetAddress v4("10.1.2.3", 80);
+    InetAddress v6("fd00::1", 80, true);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v4.isIntranetIp());
+        benchmark::DoNotOptimize(v6.isIntranetIp());
+    }
+}
+BENCHMARK(BM_InetAddressIsIntranetIp);
@@ -0,0 +1,42 @@
+#include "Benchmark.h"
+#include <trantor/utils/LatencyHistogram.h>
+#include <memory>
+
+using namespace trantor;
+
+static void BM_LatencyHistogramRecord(benchmark::State &state)
+{
+    std::unique_ptr<LatencyHistogram> histogram(new LatencyHistogram);
+    uint64_t value = 1;
+    for (auto _ : state)
+    {
+        histogram->record(value);
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        value >>= 40;
+    }
+    benchmark::DoNotOptimize(histogram->count());
+}
+BENCHMARK(BM_LatencyHistogramRecord);
+
+static void BM_ConcurrentLatencyHistogramRecord(benchmark::State &state)
+{
+    ConcurrentLatencyHistogram histogram;
+    uint64_t value = 1;
+    for (auto _ : state)
+    {
+        histogram.record(value);
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        value >>= 40;
+    }
+}
+BENCHMARK(BM_ConcurrentLatencyHistogramRecord);
+
+static void BM_LatencyHistogramPercentile(benchmark::State &state)
+{
+    std::unique_ptr<LatencyHistogram> histogram(new LatencyHistogram);
+    for (uint64_t v = 1; v <= 1000000; v += 7)
+        histogram->record(v);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(histogram->valueAtPercentile(99.9));
+}
+BENCHMARK(BM_LatencyHistogramPercentile);
@@ -0,0 +1,62 @@
+#include "Benchmark.h"
+#include <trantor/utils/LogStream.h>
+#include <string>
+
+using namespace trantor;
+
+static void BM_LogStreamInteger(benchmark::State &state)
+{
+    LogStream stream;
+    int64_t value = 1234567;
+    for (auto _ : state)
+    {
+        ++value;
+        stream << value << ' ' << static_cast<int>(value) << ' '
+               << static_cast<unsigned short>(value);
+        benchmark::DoNotOptimize(stream.bufferData());
+        stream.resetBuffer();
+    }
+}
+BENCHMARK(BM_LogStreamInteger);
+
+static void BM_LogStreamDouble(benchmark::State &state)
+{
+    LogStream stream;
+    double value = 3.14159;
+    for (auto _ : state)
+    {
+        value += 0.001;
+        stream << value;
+        benchmark::DoNotOptimize(stream.bufferData());
+        stream.resetBuffer();
+    }
+}
+BENCHMARK(BM_LogStreamDouble);
+
+static void BM_LogStreamString(benchmark::State &state)
+{
+    LogStream stream;
+    const std::string str(static_cast<size_t>(state.range(0)), 'x');
+    for (auto _ : state)
+    {
+        stream << str << "literal" << static_cast<const char *>("pointer");
+        benchmark::DoNotOptimize(stream.bufferData());
+        stream.resetBuffer();
+    }
+}
+BENCHMARK(BM_LogStreamString)->Arg(16)->Arg(256)->Arg(8192);
+
+// A typical log line: text, a pointer, integers and a double
+static void BM_LogStreamMixed(benchmark::State &state)
+{
+    LogStream stream;
+    int count = 0;
+    for (auto _ : state)
+    {
+        stream << "connection " << static_cast<const void *>(&stream)
+               << " received " << ++count << " bytes in " << 0.25 << " ms";
+        benchmark::DoNotOptimize(stream.bufferData());
+        stream.resetBuffer();
+    }
+}
+BENCHMARK(BM_LogStreamMixed);
@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/WireCodec.h>
+#include <string>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace trantor;
+
+static void BM_MsgBufferAppendRetrieve(benchmark::State &state)
+{
+    const std::string data(static_cast<size_t>(state.range(0)), 'x');
+    MsgBuffer buffer;
+    for (auto _ : state)
+    {
+        buffer.append(data);
+        buffer.retrieve(data.size());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MsgBufferAppendRetrieve)->Arg(16)->Arg(256)->Arg(4096);
+
+// Appending until the buffer grows, then dropping everything at once
+static void BM_MsgBufferAppendGrow(benchmark::State &state)
+{
+    const std::string data(static_cast<size_t>(state.range(0)), 'x');
+    for (auto _ : state)
+    {
+        MsgBuffer buffer;
+        for (int i = 0; i < 64; ++i)
+            buffer.append(data);
+        benchmark::DoNotOptimize(buffer.peek());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 64);
+}
+BENCHMARK(BM_MsgBufferAppendGrow)->Arg(64)->Arg(1024);
+
+static void BM_MsgBufferAppendInt(benchmark::State &state)
+{
+    MsgBuffer buffer;
+    uint32_t value = 0;
+    for (auto _ : state)
+    {
+        buffer.appendInt8(1);
+        buffer.appendInt16(2);
+        buffer.appendInt32(++value);
+        buffer.appendInt64(value);
+        benchmark::DoNotOptimize(buffer.readInt8());
+        benchmark::DoNotOptimize(buffer.readInt16());
+        benchmark::DoNotOptimize(buffer.readInt32());
+        benchmark::DoNotOptimize(buffer.readInt64());
+    }
+}
+BENCHMARK(BM_MsgBufferAppendInt);
+
+static void BM_MsgBufferAppendFields(benchmark::State &state)
+{
+    MsgBuffer buffer;
+    uint32_t value = 0;
+    for (auto _ : state)
+    {
+        ++value;
+        buffer.appendFields(wire::fixed(uint8_t(1)),
+                            wire::fixed(uint16_t(2)),
+                            wire::fixed(value),
+                            wire::fixed(uint64_t(value)));
+        wire::Reader reader(buffer);
+        uint8_t a;
+        uint16_t b;
+        uint32_t c;
+        uint64_t d;
+        reader.readFixed(a, b, c, d);
+        benchmark::DoNotOptimize(d);
+        buffer.retrieve(reader.consumed());
+    }
+}
+BENCHMARK(BM_MsgBufferAppendFields);
+
+#ifndef _WIN32
+static void BM_MsgBufferReadFd(benchmark::State &state)
+{
+    const size_t len = static_cast<size_t>(state.range(0));
+    const std::string data(len, 'x');
+    int fds[2];
+    if (pipe(fds) != 0)
+        return;
+    MsgBuffer buffer;
+    int err = 0;
+    for (auto _ : state)
+    {
+        if (write(fds[1], data.data(), len) != static_cast<ssize_t>(len))
+            break;
+        size_t total = 0;
+        while (total < len)
+        {
+            auto n = buffer.readFd(fds[0], &err);
+            if (n <= 0)
+                break;
+            total += static_cast<size_t>(n);
+        }
+        buffer.retrieveAll();
+    }
+    close(fds[0]);
+    close(fds[1]);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MsgBufferReadFd)->Arg(512)->Arg(16384);
+#endif
@@ -0,0 +1,95 @@
+#include "Benchmark.h"
+#include <trantor/utils/LockFreeQueue.h>
+#include <trantor/utils/ObjectPool.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace trantor;
+
+static void BM_MpscQueueEnqueueDequeue(benchmark::State &state)
+{
+    MpscQueue<int> queue;
+    int value = 0;
+    for (auto _ : state)
+    {
+        queue.enqueue(1);
+        queue.dequeue(value);
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MpscQueueEnqueueDequeue);
+
+// Like the pending functors of an EventLoop
+static void BM_MpscQueueFunctions(benchmark::State &state)
+{
+    MpscQueue<std::function<void()>> queue;
+    std::function<void()> func;
+    int count = 0;
+    for (auto _ : state)
+    {
+        queue.enqueue([&count]() { ++count; });
+        queue.dequeue(func);
+        func();
+    }
+    benchmark::DoNotOptimize(count);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MpscQueueFunctions);
+
+// range(0) producer threads each enqueue a batch while the calling thread
+// consumes
+static void BM_MpscQueueContended(benchmark::State &state)
+{
+    const int producers = static_cast<int>(state.range(0));
+    const int batch = 10000;
+    MpscQueue<int> queue;
+    for (auto _ : state)
+    {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; ++i)
+        {
+            threads.emplace_back([&queue]() {
+                for (int j = 0; j < batch; ++j)
+                    queue.enqueue(j);
+            });
+        }
+        int received = 0;
+        int value;
+        while (received < producers * batch)
+        {
+            if (queue.dequeue(value))
+                ++received;
+        }
+        for (auto &thread : threads)
+            thread.join();
+    }
+    state.SetItemsProcessed(state.iterations() * producers * batch);
+}
+BENCHMARK(BM_MpscQueueContended)->Arg(1)->Arg(4);
+
+static void BM_ObjectPool(benchmark::State &state)
+{
+    auto pool = std::make_shared<ObjectPool<std::string>>();
+    for (auto _ : state)
+    {
+        auto obj = pool->getObject();
+        benchmark::DoNotOptimize(obj.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ObjectPool);
+
+static void BM_MakeShared(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto obj = std::make_shared<std::string>();
+        benchmark::DoNotOptimize(obj.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MakeShared);
@@ -0,0 +1,71 @@
+#include "Benchmark.h"
+#include <trantor/utils/Funcs.h>
+#include <trantor/utils/Utilities.h>
+#include <string>
+#include <vector>
+
+using namespace trantor;
+
+static const std::string kHeader =
+    "gzip, deflate, br, zstd, identity, compress, x-gzip, *;q=0.1";
+static const std::string kQuery =
+    "id=12345&name=trantor&lang=cpp&page=3&sort=desc&filter=active&limit=50";
+
+static void BM_SplitString(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(splitString(kHeader, ", "));
+        benchmark::DoNotOptimize(splitString(kQuery, "&"));
+    }
+}
+BENCHMARK(BM_SplitString);
+
+static void BM_SplitStringViews(benchmark::State &state)
+{
+    std::vector<StringView> tokens;
+    for (auto _ : state)
+    {
+        splitString(kHeader, ", ", tokens);
+        benchmark::DoNotOptimize(tokens.data());
+        splitString(kQuery, "&", tokens);
+        benchmark::DoNotOptimize(tokens.data());
+    }
+}
+BENCHMARK(BM_SplitStringViews);
+
+static void BM_StringSplitter(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        size_t len = 0;
+        for (auto token : StringSplitter(kQuery, "&"))
+            len += token.size();
+        benchmark::DoNotOptimize(len);
+    }
+}
+BENCHMARK(BM_StringSplitter);
+
+static void BM_Utf8ToWide(benchmark::State &state)
+{
+    std::string utf8;
+    for (int i = 0; i < state.range(0); ++i)
+        utf8 += "abc\xE4\xB8\xAD\xE6\x96\x87";
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::fromUtf8(utf8));
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(utf8.size()));
+}
+BENCHMARK(BM_Utf8ToWide)->Arg(1)->Arg(100);
+
+static void BM_WideToUtf8(benchmark::State &state)
+{
+    std::wstring wide;
+    for (int i = 0; i < state.range(0); ++i)
+        wide += L"abc中文";
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::toUtf8(wide));
+    state.SetItemsProcessed(state.iterations() *
+                            static_cast<int64_t>(wide.size()));
+}
+BENCHMARK(BM_WideToUtf8)->Arg(1)->Arg(100);
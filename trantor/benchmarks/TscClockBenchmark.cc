@@ -0,0 +1,34 @@
+#include "Benchmark.h"
+#include <trantor/utils/TscClock.h>
+#include <chrono>
+
+using namespace trantor;
+
+static void BM_TscClockTicks(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(TscClock::ticks());
+}
+BENCHMARK(BM_TscClockTicks);
+
+static void BM_TscClockTicksOrdered(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(TscClock::ticksOrdered());
+}
+BENCHMARK(BM_TscClockTicksOrdered);
+
+static void BM_TscClockNanoseconds(benchmark::State &state)
+{
+    TscClock::calibrate();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(TscClock::nanoseconds());
+}
+BENCHMARK(BM_TscClockNanoseconds);
+
+static void BM_SteadyClockNow(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(std::chrono::steady_clock::now());
+}
+BENCHMARK(BM_SteadyClockNow);
@@ -0,0 +1,137 @@
+/**
+ *
+ *  @file AsyncFile.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include <trantor/net/AsyncFile.h>
+#include "inner/AsyncFileEngine.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace trantor;
+
+void AsyncFile::open(EventLoop *loop,
+                     const std::string &path,
+                     int flags,
+                     OpenCallback callback,
+                     int mode)
+{
+    loop->runInLoop([loop,
+                     path,
+                     flags,
+                     mode,
+                     callback = std::move(callback)]() mutable {
+        auto engine = AsyncFileEngine::forLoop(loop);
+        AsyncFileOpPtr op(new AsyncFileOp(AsyncFileOp::Type::Open));
+        op->path = std::move(path);
+        op->flags = flags;
+        op->mode = mode;
+        op->owner = engine;
+        op->callback = [loop, engine, callback = std::move(callback)](
+                           ssize_t result) {
+            if (result < 0)
+            {
+                callback(nullptr, static_cast<int>(-result));
+                return;
+            }
+            callback(AsyncFilePtr(new AsyncFile(loop,
+                                                static_cast<int>(result),
+                                                engine)),
+                     0);
+        };
+        engine->submit(std::move(op));
+    });
+}
+
+AsyncFile::AsyncFile(EventLoop *loop,
+                     int fd,
+                     std::shared_ptr<AsyncFileEngine> engine)
+    : loop_(loop), fd_(fd), engine_(std::move(engine))
+{
+}
+
+AsyncFile::~AsyncFile()
+{
+    // Operations keep the file alive, so none is pending
+#ifdef _WIN32
+    ::_close(fd_);
+#else
+    ::close(fd_);
+#endif
+}
+
+bool AsyncFile::isIoUringUsed() const
+{
+    return engine_->isIoUring();
+}
+
+void AsyncFile::submit(AsyncFileOpPtr op)
+{
+    op->fd = fd_;
+    op->owner = shared_from_this();
+    if (loop_->isInLoopThread())
+    {
+        engine_->submit(std::move(op));
+        return;
+    }
+    // Functors must be copyable. The operation is freed with the functor if
+    // the loop never runs it.
+    auto opPtr = std::make_shared<AsyncFileOpPtr>(std::move(op));
+    loop_->queueInLoop(
+        [this, opPtr]() { engine_->submit(std::move(*opPtr)); });
+}
+
+void AsyncFile::read(uint64_t offset,
+                     char *buffer,
+                     size_t length,
+                     Callback callback)
+{
+    AsyncFileOpPtr op(new AsyncFileOp(AsyncFileOp::Type::Read));
+    op->buffer = buffer;
+    op->length = length;
+    op->offset = offset;
+    op->callback = std::move(callback);
+    submit(std::move(op));
+}
+
+void AsyncFile::write(uint64_t offset,
+                      const char *data,
+                      size_t length,
+                      Callback callback)
+{
+    AsyncFileOpPtr op(new AsyncFileOp(AsyncFileOp::Type::Write));
+    op->buffer = const_cast<char *>(data);
+    op->length = length;
+    op->offset = offset;
+    op->callback = std::move(callback);
+    submit(std::move(op));
+}
+
+void AsyncFile::write(uint64_t offset, std::string data, Callback callback)
+{
+    AsyncFileOpPtr op(new AsyncFileOp(AsyncFileOp::Type::Write));
+    op->data = std::move(data);
+    op->buffer = &op->data[0];
+    op->length = op->data.size();
+    op->offset = offset;
+    op->callback = std::move(callback);
+    submit(std::move(op));
+}
+
+void AsyncFile::fsync(Callback callback, bool dataOnly)
+{
+    AsyncFileOpPtr op(new AsyncFileOp(AsyncFileOp::Type::Fsync));
+    op->dataOnly = dataOnly;
+    op->callback = std::move(callback);
+    submit(std::move(op));
+}
@@ -0,0 +1,146 @@
+/**
+ *
+ *  @file AsyncFile.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+#include <trantor/exports.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace trantor
+{
+class AsyncFileEngine;
+struct AsyncFileOp;
+
+/**
+ * @brief This class represents a file read and written asynchronously, so
+ * that slow disks don't block the event loop.
+ *
+ * The operations run on io_uring on Linux when the kernel supports it, and
+ * on a shared thread pool otherwise. The callbacks are called in the event
+ * loop of the file.
+ *
+ * @code
+   AsyncFile::open(loop, "upload.bin", O_WRONLY | O_CREAT | O_TRUNC,
+                   [](const AsyncFilePtr &file, int err) {
+                       if (!file)
+                           return;
+                       file->write(0, std::move(data), [file](ssize_t n) {
+                           file->fsync([](ssize_t) {});
+                       });
+                   });
+   @endcode
+ */
+class TRANTOR_EXPORT AsyncFile : NonCopyable,
+                                 public std::enable_shared_from_this<AsyncFile>
+{
+  public:
+    /**
+     * @brief The callback of an operation, called with the number of bytes
+     * read or written, 0 for fsync(), or a negative errno value on failure.
+     */
+    using Callback = std::function<void(ssize_t result)>;
+    /**
+     * @brief The callback of open(), called with the file, or with nullptr
+     * and the errno value on failure.
+     */
+    using OpenCallback =
+        std::function<void(const std::shared_ptr<AsyncFile> &file, int err)>;
+
+    /**
+     * @brief Open a file asynchronously.
+     *
+     * @param loop The event loop in which the callbacks of the file are
+     * called.
+     * @param path The path of the file in UTF-8.
+     * @param flags The flags of open(2), e.g. O_RDONLY or O_WRONLY | O_CREAT.
+     * @param mode The permissions of a created file.
+     */
+    static void open(EventLoop *loop,
+                     const std::string &path,
+                     int flags,
+                     OpenCallback callback,
+                     int mode = 0644);
+
+    /**
+     * @brief Read from the file at the given offset. The result is less than
+     * the length at the end of the file.
+     * @note The buffer must stay valid until the callback is called.
+     */
+    void read(uint64_t offset, char *buffer, size_t length, Callback callback);
+
+    /**
+     * @brief Write to the file at the given offset. The callback is called
+     * when all the data is written, or on failure.
+     * @note The data must stay valid until the callback is called.
+     */
+    void write(uint64_t offset,
+               const char *data,
+               size_t length,
+               Callback callback);
+
+    /**
+     * @brief Write to the file at the given offset, the file keeps the data
+     * until the callback is called.
+     */
+    void write(uint64_t offset, std::string data, Callback callback);
+
+    /**
+     * @brief Flush the data written to the file to the disk.
+     *
+     * @param dataOnly If true, metadata that isn't needed to read the data
+     * back, like the modification time, isn't flushed (fdatasync).
+     */
+    void fsync(Callback callback, bool dataOnly = false);
+
+    /**
+     * @brief Get the file descriptor, closed when the file is destroyed.
+     */
+    int fd() const
+    {
+        return fd_;
+    }
+
+    /**
+     * @brief Get the event loop in which the callbacks are called.
+     */
+    EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+    /**
+     * @brief Check whether the operations run on io_uring.
+     */
+    bool isIoUringUsed() const;
+
+    ~AsyncFile();
+
+  private:
+    AsyncFile(EventLoop *loop,
+              int fd,
+              std::shared_ptr<AsyncFileEngine> engine);
+    void submit(std::unique_ptr<AsyncFileOp> op);
+
+    EventLoop *loop_;
+    int fd_;
+    std::shared_ptr<AsyncFileEngine> engine_;
+};
+
+using AsyncFilePtr = std::shared_ptr<AsyncFile>;
+
+}  // namespace trantor
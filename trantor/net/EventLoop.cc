@@ -216,8 +216,13 @@ void EventLoop::loop()
         while (!quit_.load(std::memory_order_acquire))
         {
             activeChannels_.clear();
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
             poller_->poll(kPollTimeMs, &activeChannels_);
+#elif defined __linux__
+            // Without a timeout if there is no timer, the loop is woken up
+            // by the eventfd when one is added from another thread.
+            poller_->pollUs(timerQueue_->getTimeoutUs(), &activeChannels_);
+            timerQueue_->processTimers();
 #else
             poller_->poll(static_cast<int>(timerQueue_->getTimeout()),
                           &activeChannels_);
@@ -236,6 +241,8 @@ void EventLoop::loop()
             eventHandling_ = false;
             // std::cout << "looping" << endl;
             doRunInLoopFuncs();
+            if (!funcsAtEndOfIteration_.empty())
+                doRunEndOfIterationFuncs();
         }
         // loopFlagCleaner clears the loop flag here
     }
@@ -355,6 +362,25 @@ void EventLoop::doRunInLoopFuncs()
         }
     }
 }
+void EventLoop::doRunEndOfIterationFuncs()
+{
+    std::vector<Func> funcs;
+    // The functions may add more functions
+    while (!funcsAtEndOfIteration_.empty())
+    {
+        funcs.swap(funcsAtEndOfIteration_);
+        for (auto &func : funcs)
+        {
+            func();
+        }
+        funcs.clear();
+    }
+    // The functions queued by them in this thread don't wake the loop up
+    if (!funcs_.empty())
+    {
+        wakeup();
+    }
+}
 void EventLoop::wakeup()
 {
     // if (!looping_)
@@ -419,4 +445,10 @@ void EventLoop::runOnQuit(const Func &cb)
     funcsOnQuit_.enqueue(cb);
 }
 
+void EventLoop::runAtEndOfIteration(Func &&cb)
+{
+    assertInLoopThread();
+    funcsAtEndOfIteration_.push_back(std::move(cb));
+}
+
 }  // namespace trantor
@@ -295,6 +295,16 @@ class TRANTOR_EXPORT EventLoop : NonCopyable
     void runOnQuit(Func &&cb);
     void runOnQuit(const Func &cb);
 
+    /**
+     * @brief Run a function once at the end of the current iteration of the
+     * event loop, after the events are handled and the functions queued by
+     * queueInLoop() are run. It gathers the work of an iteration, such as
+     * the writes of connections in the deferred flush mode.
+     *
+     * @note This method must be called in the thread of the event loop.
+     */
+    void runAtEndOfIteration(Func &&cb);
+
   private:
     void abortNotInLoopThread();
     void wakeup();
@@ -312,6 +322,8 @@ class TRANTOR_EXPORT EventLoop : NonCopyable
     std::unique_ptr<TimerQueue> timerQueue_;
     MpscQueue<Func> funcsOnQuit_;
     bool callingFuncs_{false};
+    std::vector<Func> funcsAtEndOfIteration_;
+    void doRunEndOfIterationFuncs();
 #ifdef __linux__
     int wakeupFd_;
     std::unique_ptr<Channel> wakeupChannelPtr_;
@@ -0,0 +1,205 @@
+/**
+ *
+ *  @file LoopChannel.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/LockFreeQueue.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace trantor
+{
+/**
+ * @brief This class template represents a channel that passes messages from
+ * one event loop (the producer) to another one (the consumer), e.g. from the
+ * loop parsing requests to the loop processing them.
+ *
+ * Messages go through a bounded single producer single consumer ring instead
+ * of the functor queue of the consumer loop, so sending doesn't allocate. The
+ * consumer loop is woken up once for a batch of messages: the handler is
+ * called for every message sent until the batch is drained.
+ *
+ * When the ring is full, send() keeps messages in a backlog in the producer
+ * loop, which is moved to the ring as the consumer makes room, so messages
+ * are never dropped or reordered.
+ *
+ * @code
+   auto channel = std::make_shared<LoopChannel<Request>>(parseLoop, workLoop);
+   channel->setHandler([](Request &&req) { process(req); });
+   // In parseLoop
+   channel->send(std::move(req));
+   @endcode
+ * @note Channels must be owned by a shared_ptr.
+ */
+template <typename T>
+class LoopChannel : NonCopyable,
+                    public std::enable_shared_from_this<LoopChannel<T>>
+{
+  public:
+    using Handler = std::function<void(T &&)>;
+
+    /**
+     * @brief Construct a new channel.
+     *
+     * @param producerLoop The loop in which send() is called.
+     * @param consumerLoop The loop in which the handler is called.
+     * @param capacity The capacity of the ring, rounded up to a power of two.
+     */
+    LoopChannel(EventLoop *producerLoop,
+                EventLoop *consumerLoop,
+                size_t capacity = 1024)
+        : producerLoop_(producerLoop),
+          consumerLoop_(consumerLoop),
+          queue_(capacity),
+          maxBatchSize_(queue_.capacity())
+    {
+    }
+
+    /**
+     * @brief Set the handler called in the consumer loop for each message.
+     * @note Must be set before the first message is sent.
+     */
+    void setHandler(Handler handler)
+    {
+        handler_ = std::move(handler);
+    }
+
+    /**
+     * @brief Set the maximum number of messages handled before the consumer
+     * loop gets to process its other events. The default is the capacity.
+     */
+    void setMaxBatchSize(size_t size)
+    {
+        maxBatchSize_ = size > 0 ? size : 1;
+    }
+
+    /**
+     * @brief Send a message to the consumer loop.
+     * @note This method must be called in the producer loop.
+     */
+    void send(T &&message)
+    {
+        producerLoop_->assertInLoopThread();
+        if (backlog_.empty() && queue_.enqueue(std::move(message)))
+        {
+            scheduleDrain();
+            return;
+        }
+        // A drain is pending since the ring is full
+        backlog_.push_back(std::move(message));
+        if (backlog_.size() == 1)
+            flushBacklog();
+    }
+    void send(const T &message)
+    {
+        send(T(message));
+    }
+
+    /**
+     * @brief The number of messages waiting for room in the ring, from the
+     * producer loop.
+     */
+    size_t backlogSize() const
+    {
+        return backlog_.size();
+    }
+
+  private:
+    // In the producer loop, after enqueuing
+    void scheduleDrain()
+    {
+        // Pairs with the fence in drain(): either the consumer sees the new
+        // messages or we see that it stopped draining
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!draining_.load(std::memory_order_relaxed) &&
+            !draining_.exchange(true))
+            queueDrain();
+    }
+
+    void queueDrain()
+    {
+        std::weak_ptr<LoopChannel> weakSelf = this->shared_from_this();
+        consumerLoop_->queueInLoop([weakSelf]() {
+            if (auto self = weakSelf.lock())
+                self->drain();
+        });
+    }
+
+    void drain()
+    {
+        const size_t handled = queue_.consume(
+            [this](T &&message) { handler_(std::move(message)); },
+            maxBatchSize_);
+        if (handled > 0)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (needRoom_.load(std::memory_order_relaxed) &&
+                needRoom_.exchange(false))
+            {
+                std::weak_ptr<LoopChannel> weakSelf = this->shared_from_this();
+                producerLoop_->queueInLoop([weakSelf]() {
+                    if (auto self = weakSelf.lock())
+                        self->flushBacklog();
+                });
+            }
+        }
+        if (handled == maxBatchSize_)
+        {
+            // Let the loop handle its other events before the next batch
+            queueDrain();
+            return;
+        }
+        draining_.store(false);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!queue_.empty() && !draining_.exchange(true))
+            queueDrain();
+    }
+
+    // In the producer loop, move as much of the backlog as possible to the
+    // ring
+    void flushBacklog()
+    {
+        for (;;)
+        {
+            while (!backlog_.empty() &&
+                   queue_.enqueue(std::move(backlog_.front())))
+                backlog_.pop_front();
+            if (backlog_.empty())
+                break;
+            needRoom_.store(true);
+            // The consumer may have made room before it could see the flag
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!queue_.enqueue(std::move(backlog_.front())))
+                break;
+            backlog_.pop_front();
+        }
+        scheduleDrain();
+    }
+
+    EventLoop *producerLoop_;
+    EventLoop *consumerLoop_;
+    SpscQueue<T> queue_;
+    size_t maxBatchSize_;
+    Handler handler_;
+    // Whether a drain is queued in or running in the consumer loop
+    std::atomic<bool> draining_{false};
+    // Whether the producer waits for room to flush its backlog
+    std::atomic<bool> needRoom_{false};
+    std::deque<T> backlog_;  // producer loop only
+};
+
+}  // namespace trantor
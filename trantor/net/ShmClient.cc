@@ -0,0 +1,159 @@
+/**
+ *
+ *  @file ShmClient.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include <trantor/net/ShmClient.h>
+#include <trantor/net/Channel.h>
+#include <trantor/utils/Logger.h>
+#include "inner/ShmConnectionImpl.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <string.h>
+
+using namespace trantor;
+
+ShmClient::ShmClient(EventLoop *loop, std::string path, std::string name)
+    : loop_(loop), path_(std::move(path)), name_(std::move(name))
+{
+}
+
+ShmClient::~ShmClient()
+{
+    if (handshakeChannelPtr_)
+    {
+        handshakeChannelPtr_->disableAll();
+        handshakeChannelPtr_->remove();
+        ::close(sockfd_);
+    }
+    auto conn = connection();
+    if (conn)
+        conn->forceClose();
+}
+
+void ShmClient::connect()
+{
+    loop_->runInLoop([thisPtr = shared_from_this()]() {
+        if (thisPtr->handshakeChannelPtr_ || thisPtr->connection())
+        {
+            LOG_WARN << "The client " << thisPtr->name_
+                     << " is already connecting or connected";
+            return;
+        }
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (thisPtr->path_.size() >= sizeof(addr.sun_path))
+        {
+            LOG_ERROR << "The path of the Unix socket is too long: "
+                      << thisPtr->path_;
+            if (thisPtr->connectionErrorCallback_)
+                thisPtr->connectionErrorCallback_();
+            return;
+        }
+        memcpy(addr.sun_path,
+               thisPtr->path_.c_str(),
+               thisPtr->path_.size() + 1);
+        thisPtr->sockfd_ =
+            ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        // Connecting to a Unix socket doesn't block, it fails with EAGAIN if
+        // the backlog of the server is full
+        if (thisPtr->sockfd_ < 0 ||
+            ::connect(thisPtr->sockfd_,
+                      reinterpret_cast<sockaddr *>(&addr),
+                      sizeof(addr)) != 0)
+        {
+            LOG_SYSERR << "Can't connect to " << thisPtr->path_;
+            thisPtr->connectFailed();
+            return;
+        }
+        thisPtr->handshakeChannelPtr_ =
+            std::make_unique<Channel>(thisPtr->loop_, thisPtr->sockfd_);
+        thisPtr->handshakeChannelPtr_->setReadCallback(
+            [ptr = thisPtr.get()]() { ptr->handleHandshake(); });
+        thisPtr->handshakeChannelPtr_->tie(thisPtr);
+        thisPtr->handshakeChannelPtr_->enableReading();
+    });
+}
+
+void ShmClient::connectFailed()
+{
+    if (handshakeChannelPtr_)
+    {
+        handshakeChannelPtr_->disableAll();
+        handshakeChannelPtr_->remove();
+        // Destroyed after the channel handles its event
+        loop_->queueInLoop([channelPtr = std::shared_ptr<Channel>(
+                                std::move(handshakeChannelPtr_))]() {});
+    }
+    if (sockfd_ >= 0)
+    {
+        ::close(sockfd_);
+        sockfd_ = -1;
+    }
+    if (connectionErrorCallback_)
+        connectionErrorCallback_();
+}
+
+void ShmClient::handleHandshake()
+{
+    size_t ringCapacity;
+    int fds[3];
+    auto ret = ShmConnectionImpl::receiveHandshake(sockfd_, ringCapacity, fds);
+    if (ret == 0)
+        return;
+    if (ret < 0)
+    {
+        connectFailed();
+        return;
+    }
+    auto memory = ShmConnectionImpl::mapSharedMemory(fds[0], ringCapacity);
+    ::close(fds[0]);
+    if (!memory)
+    {
+        ::close(fds[1]);
+        ::close(fds[2]);
+        connectFailed();
+        return;
+    }
+    handshakeChannelPtr_->disableAll();
+    handshakeChannelPtr_->remove();
+    loop_->queueInLoop([channelPtr = std::shared_ptr<Channel>(
+                            std::move(handshakeChannelPtr_))]() {});
+    auto sockfd = sockfd_;
+    sockfd_ = -1;
+    auto connPtr = std::make_shared<ShmConnectionImpl>(
+        loop_, sockfd, memory, ringCapacity, fds[2], fds[1], false);
+    connPtr->setConnectionCallback(connectionCallback_);
+    connPtr->setRecvMsgCallback(messageCallback_);
+    connPtr->setWriteCompleteCallback(writeCompleteCallback_);
+    std::weak_ptr<ShmClient> weakPtr = shared_from_this();
+    connPtr->setCloseCallback([weakPtr](const TcpConnectionPtr &conn) {
+        conn->getLoop()->queueInLoop([conn]() { conn->connectDestroyed(); });
+        auto thisPtr = weakPtr.lock();
+        if (thisPtr)
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            thisPtr->connection_.reset();
+        }
+    });
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_ = connPtr;
+    }
+    connPtr->connectEstablished();
+}
+
+void ShmClient::disconnect()
+{
+    auto conn = connection();
+    if (conn)
+        conn->shutdown();
+}
@@ -0,0 +1,115 @@
+/**
+ *
+ *  @file ShmClient.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/net/callbacks.h>
+#include <trantor/utils/NonCopyable.h>
+#include <trantor/exports.h>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace trantor
+{
+class Channel;
+
+/**
+ * @brief This class represents a client of a ShmServer (Linux only). It must
+ * be owned by a shared_ptr, and destroyed in its loop or after the loop
+ * quits.
+ */
+class TRANTOR_EXPORT ShmClient : NonCopyable,
+                                 public std::enable_shared_from_this<ShmClient>
+{
+  public:
+    /**
+     * @brief Construct a new shared memory client.
+     *
+     * @param loop The event loop in which the client runs.
+     * @param path The path of the Unix socket of the server.
+     * @param name The name of the client.
+     */
+    ShmClient(EventLoop *loop, std::string path, std::string name);
+    ~ShmClient();
+
+    /**
+     * @brief Connect to the server.
+     */
+    void connect();
+
+    /**
+     * @brief Shut the connection to the server down.
+     */
+    void disconnect();
+
+    TcpConnectionPtr connection() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connection_;
+    }
+    EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+    const std::string &name() const
+    {
+        return name_;
+    }
+
+    void setConnectionCallback(const ConnectionCallback &cb)
+    {
+        connectionCallback_ = cb;
+    }
+    /**
+     * @brief Set the connection error callback.
+     *
+     * @param cb The callback is called when the client can't connect to the
+     * server or can't set the shared memory up.
+     */
+    void setConnectionErrorCallback(const ConnectionErrorCallback &cb)
+    {
+        connectionErrorCallback_ = cb;
+    }
+    void setMessageCallback(const RecvMessageCallback &cb)
+    {
+        messageCallback_ = cb;
+    }
+    void setWriteCompleteCallback(const WriteCompleteCallback &cb)
+    {
+        writeCompleteCallback_ = cb;
+    }
+
+  private:
+    void handleHandshake();
+    void connectFailed();
+
+    EventLoop *loop_;
+    std::string path_;
+    std::string name_;
+    int sockfd_{-1};
+    std::unique_ptr<Channel> handshakeChannelPtr_;
+    ConnectionCallback connectionCallback_;
+    ConnectionErrorCallback connectionErrorCallback_;
+    RecvMessageCallback messageCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+    mutable std::mutex mutex_;
+    TcpConnectionPtr connection_;  // @GuardedBy mutex_
+};
+
+using ShmClientPtr = std::shared_ptr<ShmClient>;
+
+}  // namespace trantor
@@ -0,0 +1,203 @@
+/**
+ *
+ *  @file ShmServer.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include <trantor/net/ShmServer.h>
+#include <trantor/net/Channel.h>
+#include <trantor/utils/Logger.h>
+#include "inner/ShmConnectionImpl.h"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace trantor;
+
+namespace
+{
+// Remove the socket of a server that is gone, nobody accepts connections on
+// it. Any other file is left for bind() to fail on.
+void removeStaleSocket(const sockaddr_un &addr)
+{
+    struct stat st;
+    if (::lstat(addr.sun_path, &st) != 0 || !S_ISSOCK(st.st_mode))
+        return;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return;
+    if (::connect(fd,
+                  reinterpret_cast<const sockaddr *>(&addr),
+                  sizeof(addr)) != 0 &&
+        errno == ECONNREFUSED)
+    {
+        LOG_INFO << "Removing the stale socket " << addr.sun_path;
+        ::unlink(addr.sun_path);
+    }
+    ::close(fd);
+}
+}  // namespace
+
+ShmServer::ShmServer(EventLoop *loop,
+                     std::string path,
+                     std::string name,
+                     size_t ringCapacity)
+    : loop_(loop),
+      path_(std::move(path)),
+      name_(std::move(name)),
+      ringCapacity_(4096),
+      ioLoops_({loop})
+{
+    while (ringCapacity_ < ringCapacity)
+        ringCapacity_ <<= 1;
+}
+
+ShmServer::~ShmServer()
+{
+    if (listenChannelPtr_)
+    {
+        loop_->assertInLoopThread();
+        listenChannelPtr_->disableAll();
+        listenChannelPtr_->remove();
+        ::close(listenFd_);
+    }
+}
+
+void ShmServer::start()
+{
+    loop_->runInLoop([this]() {
+        assert(!listenChannelPtr_);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path_.size() >= sizeof(addr.sun_path))
+        {
+            LOG_FATAL << "The path of the Unix socket is too long: " << path_;
+            exit(1);
+        }
+        memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+        listenFd_ =
+            ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        removeStaleSocket(addr);
+        if (listenFd_ < 0 ||
+            ::bind(listenFd_,
+                   reinterpret_cast<sockaddr *>(&addr),
+                   sizeof(addr)) != 0 ||
+            ::listen(listenFd_, SOMAXCONN) != 0)
+        {
+            LOG_SYSERR << "Can't listen on " << path_;
+            exit(1);
+        }
+        listenChannelPtr_ = std::make_unique<Channel>(loop_, listenFd_);
+        listenChannelPtr_->setReadCallback([this]() { handleAccept(); });
+        listenChannelPtr_->enableReading();
+    });
+}
+
+void ShmServer::stop()
+{
+    loop_->assertInLoopThread();
+    if (listenChannelPtr_)
+    {
+        listenChannelPtr_->disableAll();
+        listenChannelPtr_->remove();
+        listenChannelPtr_.reset();
+        ::close(listenFd_);
+        ::unlink(path_.c_str());
+    }
+    std::vector<TcpConnectionPtr> connPtrs(connSet_.begin(), connSet_.end());
+    connSet_.clear();
+    TcpConnection::closeConnections(connPtrs);
+}
+
+void ShmServer::handleAccept()
+{
+    while (true)
+    {
+        int fd = ::accept4(listenFd_,
+                           nullptr,
+                           nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno != EAGAIN && errno != ECONNABORTED)
+                LOG_SYSERR << "accept4";
+            return;
+        }
+        newConnection(fd);
+    }
+}
+
+void ShmServer::newConnection(int sockfd)
+{
+    int memfd;
+    void *memory;
+    if (!ShmConnectionImpl::createSharedMemory(ringCapacity_, memfd, memory))
+    {
+        ::close(sockfd);
+        return;
+    }
+    int eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int peerEventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    bool sent = eventFd >= 0 && peerEventFd >= 0 &&
+                ShmConnectionImpl::sendHandshake(sockfd,
+                                                 ringCapacity_,
+                                                 {memfd,
+                                                  eventFd,
+                                                  peerEventFd});
+    // The client has its own mapping now
+    ::close(memfd);
+    if (!sent)
+    {
+        LOG_SYSERR << "Can't set up a shared memory connection";
+        ::munmap(memory, ShmConnectionImpl::sharedMemorySize(ringCapacity_));
+        for (int fd : {sockfd, eventFd, peerEventFd})
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+        return;
+    }
+    auto ioLoop = ioLoops_[nextLoopIdx_];
+    nextLoopIdx_ = (nextLoopIdx_ + 1) % ioLoops_.size();
+    auto connPtr = std::make_shared<ShmConnectionImpl>(ioLoop,
+                                                       sockfd,
+                                                       memory,
+                                                       ringCapacity_,
+                                                       eventFd,
+                                                       peerEventFd,
+                                                       true);
+    connPtr->setRecvMsgCallback(recvMessageCallback_);
+    connPtr->setConnectionCallback([this](const TcpConnectionPtr &conn) {
+        if (connectionCallback_)
+            connectionCallback_(conn);
+    });
+    connPtr->setWriteCompleteCallback([this](const TcpConnectionPtr &conn) {
+        if (writeCompleteCallback_)
+            writeCompleteCallback_(conn);
+    });
+    connPtr->setCloseCallback(
+        [this](const TcpConnectionPtr &conn) { connectionClosed(conn); });
+    connSet_.insert(connPtr);
+    connPtr->connectEstablished();
+}
+
+void ShmServer::connectionClosed(const TcpConnectionPtr &connectionPtr)
+{
+    loop_->runInLoop([this, connectionPtr]() {
+        // Closed by stop() if it isn't in the set
+        connSet_.erase(connectionPtr);
+        connectionPtr->getLoop()->queueInLoop(
+            [connectionPtr]() { connectionPtr->connectDestroyed(); });
+    });
+}
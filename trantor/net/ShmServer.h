@@ -0,0 +1,124 @@
+/**
+ *
+ *  @file ShmServer.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/net/callbacks.h>
+#include <trantor/utils/NonCopyable.h>
+#include <trantor/exports.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace trantor
+{
+class Channel;
+
+/**
+ * @brief This class represents a server for the processes of the same host,
+ * which exchange data through shared memory instead of loopback TCP (Linux
+ * only).
+ *
+ * Clients connect with ShmClient to a Unix socket, through which the server
+ * sends the shared memory and the eventfds of the connection. The connections
+ * have the TcpConnection interface, without TLS and idle timeouts.
+ */
+class TRANTOR_EXPORT ShmServer : NonCopyable
+{
+  public:
+    /**
+     * @brief Construct a new shared memory server.
+     *
+     * @param loop The event loop in which the connections are accepted.
+     * @param path The path of the Unix socket. A stale socket left there by a
+     * server that is gone is replaced, anything else makes start() fail.
+     * @param name The name of the server.
+     * @param ringCapacity The bytes of the ring of each direction of a
+     * connection, rounded up to a power of two.
+     */
+    ShmServer(EventLoop *loop,
+              std::string path,
+              std::string name,
+              size_t ringCapacity = 1 << 20);
+    ~ShmServer();
+
+    /**
+     * @brief Start listening.
+     */
+    void start();
+
+    /**
+     * @brief Stop listening and close the connections. It must be called in
+     * the loop of the server.
+     */
+    void stop();
+
+    /**
+     * @brief Set the event loops in which the I/O of the connections is
+     * handled, the loop of the server by default.
+     */
+    void setIoLoops(const std::vector<EventLoop *> &ioLoops)
+    {
+        ioLoops_ = ioLoops;
+    }
+
+    void setRecvMessageCallback(const RecvMessageCallback &cb)
+    {
+        recvMessageCallback_ = cb;
+    }
+    void setConnectionCallback(const ConnectionCallback &cb)
+    {
+        connectionCallback_ = cb;
+    }
+    void setWriteCompleteCallback(const WriteCompleteCallback &cb)
+    {
+        writeCompleteCallback_ = cb;
+    }
+
+    const std::string &name() const
+    {
+        return name_;
+    }
+    const std::string &path() const
+    {
+        return path_;
+    }
+    EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+  private:
+    void handleAccept();
+    void newConnection(int sockfd);
+    void connectionClosed(const TcpConnectionPtr &connectionPtr);
+
+    EventLoop *loop_;
+    std::string path_;
+    std::string name_;
+    size_t ringCapacity_;
+    int listenFd_{-1};
+    std::unique_ptr<Channel> listenChannelPtr_;
+    std::vector<EventLoop *> ioLoops_;
+    size_t nextLoopIdx_{0};
+    std::set<TcpConnectionPtr> connSet_;
+    RecvMessageCallback recvMessageCallback_;
+    ConnectionCallback connectionCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+};
+
+}  // namespace trantor
@@ -25,6 +25,8 @@
 #include <memory>
 #include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace trantor
 {
@@ -44,6 +46,18 @@ class TRANTOR_EXPORT TcpConnection
     friend class TcpConnectionImpl;
     friend class TcpClient;
 
+    /**
+     * @brief The deadlines of a connection, see setReadDeadline() and
+     * setWriteDeadline().
+     */
+    enum class Deadline
+    {
+        Read,
+        Write
+    };
+    using DeadlineCallback =
+        std::function<void(const TcpConnectionPtr &, Deadline)>;
+
     TcpConnection() = default;
     virtual ~TcpConnection(){};
 
@@ -104,6 +118,32 @@ class TRANTOR_EXPORT TcpConnection
      * the stream is closed.
      */
     virtual AsyncStreamPtr sendAsyncStream(bool disableKickoff = false) = 0;
+
+    /**
+     * @brief Reserve a slot for a response, usually when its request is
+     * received. The slots are sent in the order they are reserved, whatever
+     * the order they are filled in, so pipelined requests can be processed in
+     * parallel.
+     *
+     * @return The sequence number of the slot to fill with fillSendSlot().
+     * @note This method is thread safe. The data sent with send() isn't
+     * ordered with the slots. The ordering needs state of its own, so
+     * subclasses have to implement both reserveSendSlot() and fillSendSlot().
+     */
+    virtual uint64_t reserveSendSlot() = 0;
+
+    /**
+     * @brief Fill a slot reserved by reserveSendSlot(), in any thread. The
+     * filled slots following the last slot sent are written together, in one
+     * write at the end of the current iteration of the event loop. The data
+     * is moved into the slot, not copied.
+     *
+     * @param slot The sequence number returned by reserveSendSlot(). Each
+     * slot must be filled once.
+     */
+    virtual void fillSendSlot(uint64_t slot, std::string &&data) = 0;
+    virtual void fillSendSlot(uint64_t slot, MsgBuffer &&data) = 0;
+
     /**
      * @brief Get the local address of the connection.
      *
@@ -159,6 +199,21 @@ class TRANTOR_EXPORT TcpConnection
      */
     virtual void setTcpNoDelay(bool on) = 0;
 
+    /**
+     * @brief Enable or disable the deferred flush mode, which is disabled by
+     * default. In this mode, the data sent in the thread of the event loop is
+     * buffered, and the connection is flushed once at the end of the current
+     * iteration of the loop, so the small messages sent while handling an
+     * event are written together.
+     *
+     * @param on
+     * @note The default implementation always flushes immediately.
+     */
+    virtual void setDeferredFlush(bool on)
+    {
+        (void)on;
+    }
+
     /**
      * @brief Shutdown the connection.
      * @note This method only closes the writing direction.
@@ -171,6 +226,41 @@ class TRANTOR_EXPORT TcpConnection
      */
     virtual void forceClose() = 0;
 
+    /**
+     * @brief Close many connections with one task per event loop, instead of
+     * one task per connection.
+     *
+     * @param connections The connections to close, in any event loops.
+     * @param graceTime If positive, the connections are shut down after
+     * sending their pending data, and the ones still open after graceTime
+     * seconds are closed forcefully. Otherwise they are closed forcefully at
+     * once.
+     * @param done Called, in one of the event loops, when all the
+     * connections are closed.
+     * @note The connections of the event loop of the current thread are
+     * closed before this method returns.
+     */
+    static void closeConnections(
+        const std::vector<std::shared_ptr<TcpConnection>> &connections,
+        double graceTime = 0.0,
+        std::function<void()> done = nullptr);
+
+    /**
+     * @brief Create a pair of connected connections in the same process,
+     * which pass the data through memory instead of sockets, with the same
+     * callbacks and send() methods as TCP connections. Set the callbacks of
+     * both, then call connectEstablished() on both to start them. When one is
+     * shut down or closed, the other one is closed. TLS and idle timeouts
+     * aren't supported.
+     *
+     * @param loop1 The event loop of the first connection.
+     * @param loop2 The event loop of the second connection, which may be
+     * loop1.
+     */
+    static std::pair<std::shared_ptr<TcpConnection>,
+                     std::shared_ptr<TcpConnection>>
+    newLocalPair(EventLoop *loop1, EventLoop *loop2);
+
     /**
      * @brief Get the event loop in which the connection I/O is handled.
      *
@@ -232,6 +322,49 @@ class TRANTOR_EXPORT TcpConnection
      */
     virtual void keepAlive() = 0;
 
+    /**
+     * @brief Set a deadline for receiving data: the deadline callback is
+     * called, or the connection is closed, if the deadline isn't set again or
+     * cleared within the timeout, e.g. after each complete request is
+     * received. Receiving part of a request doesn't extend the deadline.
+     *
+     * @param timeout The timeout in seconds from now, 0 clears the deadline.
+     * @note Deadlines have an accuracy of 0.1 seconds. Setting a deadline
+     * again doesn't allocate, so it can be done for every request. The
+     * default implementation ignores the deadline.
+     */
+    virtual void setReadDeadline(double timeout)
+    {
+        (void)timeout;
+    }
+
+    /**
+     * @brief Set a deadline for writing the data sent so far: the deadline
+     * callback is called, or the connection is closed, if it isn't all
+     * written within the timeout. The deadline is cleared when all the data
+     * is written.
+     *
+     * @param timeout The timeout in seconds from now, 0 clears the deadline.
+     * @note The default implementation ignores the deadline.
+     */
+    virtual void setWriteDeadline(double timeout)
+    {
+        (void)timeout;
+    }
+
+    /**
+     * @brief Set the callback called when a deadline expires instead of
+     * closing the connection.
+     */
+    void setDeadlineCallback(const DeadlineCallback &cb)
+    {
+        deadlineCallback_ = cb;
+    }
+    void setDeadlineCallback(DeadlineCallback &&cb)
+    {
+        deadlineCallback_ = std::move(cb);
+    }
+
     /**
      * @brief Return true if the keepAlive() method is called.
      *
@@ -375,6 +508,7 @@ class TRANTOR_EXPORT TcpConnection
     WriteCompleteCallback writeCompleteCallback_;
     HighWaterMarkCallback highWaterMarkCallback_;
     SSLErrorCallback sslErrorCallback_;
+    DeadlineCallback deadlineCallback_;
     TLSPolicy tlsPolicy_;
 
   private:
@@ -14,7 +14,9 @@
 
 #include <trantor/net/TcpServer.h>
 #include <trantor/utils/Logger.h>
+#include <algorithm>
 #include <functional>
+#include <future>
 #include <vector>
 #include "Acceptor.h"
 #include "inner/TcpConnectionImpl.h"
@@ -132,44 +134,44 @@ void TcpServer::start()
         acceptorPtr_->listen();
     });
 }
-void TcpServer::stop()
+void TcpServer::stop(double graceTime)
 {
+    std::vector<TcpConnectionPtr> connPtrs;
+    auto takeConnections = [this, &connPtrs]() {
+        acceptorPtr_.reset();
+        stopping_.store(true, std::memory_order_release);
+        connPtrs.assign(connSet_.begin(), connSet_.end());
+        connSet_.clear();
+    };
     if (loop_->isInLoopThread())
     {
-        acceptorPtr_.reset();
-        // copy the connSet_ to a vector, use the vector to close the
-        // connections to avoid the iterator invalidation.
-        std::vector<TcpConnectionPtr> connPtrs;
-        connPtrs.reserve(connSet_.size());
-        for (auto &conn : connSet_)
-        {
-            connPtrs.push_back(conn);
-        }
-        for (auto &connection : connPtrs)
-        {
-            connection->forceClose();
-        }
+        takeConnections();
     }
     else
     {
         std::promise<void> pro;
         auto f = pro.get_future();
-        loop_->queueInLoop([this, &pro]() {
-            acceptorPtr_.reset();
-            std::vector<TcpConnectionPtr> connPtrs;
-            connPtrs.reserve(connSet_.size());
-            for (auto &conn : connSet_)
-            {
-                connPtrs.push_back(conn);
-            }
-            for (auto &connection : connPtrs)
-            {
-                connection->forceClose();
-            }
+        loop_->queueInLoop([&takeConnections, &pro]() {
+            takeConnections();
             pro.set_value();
         });
         f.get();
     }
+    // The loop of the current thread can't run while we wait, its
+    // connections are closed in closeConnections() or after this method
+    // returns.
+    auto currentLoop = EventLoop::getEventLoopOfCurrentThread();
+    bool canWait = currentLoop == nullptr ||
+                   std::find(ioLoops_.begin(), ioLoops_.end(), currentLoop) ==
+                       ioLoops_.end();
+    auto closed = std::make_shared<std::promise<void>>();
+    auto closedFuture = closed->get_future();
+    TcpConnection::closeConnections(connPtrs, graceTime, [closed]() {
+        closed->set_value();
+    });
+    connPtrs.clear();
+    if (canWait)
+        closedFuture.get();
     loopPoolPtr_.reset();
     for (auto &iter : timingWheelMap_)
     {
@@ -186,7 +188,8 @@ void TcpServer::handleCloseInLoop(const TcpConnectionPtr &connectionPtr)
 {
     size_t n = connSet_.erase(connectionPtr);
     (void)n;
-    assert(n == 1);
+    // The connection may have been closed while stop() was taking it
+    assert(n == 1 || stopping_);
     auto connLoop = connectionPtr->getLoop();
 
     // NOTE: always queue this operation in connLoop, because this connection
@@ -199,6 +202,15 @@ void TcpServer::handleCloseInLoop(const TcpConnectionPtr &connectionPtr)
 void TcpServer::connectionClosed(const TcpConnectionPtr &connectionPtr)
 {
     LOG_TRACE << "connectionClosed";
+    if (stopping_.load(std::memory_order_acquire))
+    {
+        // Closed by stop(), which has removed the connection from connSet_
+        // already, so there is no need to go through loop_
+        auto connLoop = connectionPtr->getLoop();
+        connLoop->queueInLoop(
+            [connectionPtr]() { connectionPtr->connectDestroyed(); });
+        return;
+    }
     if (loop_->isInLoopThread())
     {
         handleCloseInLoop(connectionPtr);
@@ -21,6 +21,7 @@
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/utils/TimingWheel.h>
+#include <atomic>
 #include <csignal>
 #include <memory>
 #include <set>
@@ -62,8 +63,14 @@ class TRANTOR_EXPORT TcpServer : NonCopyable
     /**
      * @brief Stop the server.
      *
+     * The connections are closed with one task per I/O loop.
+     *
+     * @param graceTime If positive, the connections are given up to
+     * graceTime seconds to send their pending data before they are closed
+     * forcefully, and this method waits for them. Otherwise they are closed
+     * forcefully at once.
      */
-    void stop();
+    void stop(double graceTime = 0.0);
 
     /**
      * @brief Set the number of event loops in which the I/O of connections to
@@ -310,6 +317,8 @@ class TRANTOR_EXPORT TcpServer : NonCopyable
     IgnoreSigPipe initObj;
 #endif
     bool started_{false};
+    // Set by stop(), the connections are no longer in connSet_
+    std::atomic<bool> stopping_{false};
     TLSPolicyPtr policyPtr_{nullptr};
     SSLContextPtr sslContextPtr_{nullptr};
 };
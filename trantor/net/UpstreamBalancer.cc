@@ -0,0 +1,281 @@
+/**
+ *
+ *  @file UpstreamBalancer.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include <trantor/net/UpstreamBalancer.h>
+#include <trantor/net/TcpClient.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+using namespace trantor;
+
+namespace
+{
+// The weight of a new sample in the moving average of the latency
+constexpr double kLatencyDecay = 0.2;
+constexpr size_t kMaxEjectionMultiplier = 10;
+constexpr double kMinReconnectDelay = 0.5;
+constexpr double kMaxReconnectDelay = 30.0;
+}  // namespace
+
+struct UpstreamBalancer::Endpoint
+{
+    explicit Endpoint(const InetAddress &addr) : address(addr)
+    {
+    }
+    InetAddress address;
+    std::shared_ptr<TcpClient> client;
+    TcpConnectionPtr connection;
+    size_t outstandingRequests{0};
+    size_t outstandingBytes{0};
+    double latency{0};
+    size_t consecutiveFailures{0};
+    size_t ejections{0};
+    std::chrono::steady_clock::time_point ejectedUntil;
+    double reconnectDelay{kMinReconnectDelay};
+    // Set when the endpoint is no longer in the set, it's kept alive by the
+    // requests routed to it until they are finished
+    bool removed{false};
+};
+
+UpstreamBalancer::UpstreamBalancer(EventLoop *loop, std::string name)
+    : loop_(loop), name_(std::move(name)), random_(std::random_device{}())
+{
+}
+
+UpstreamBalancer::~UpstreamBalancer()
+{
+    for (auto &endpoint : endpoints_)
+        endpoint->client->stop();
+}
+
+std::shared_ptr<UpstreamBalancer::Endpoint> UpstreamBalancer::newEndpoint(
+    const InetAddress &address)
+{
+    auto endpoint = std::make_shared<Endpoint>(address);
+    auto client = std::make_shared<TcpClient>(loop_,
+                                              address,
+                                              name_ + "-" +
+                                                  address.toIpPort());
+    if (tlsPolicyPtr_)
+        client->enableSSL(tlsPolicyPtr_);
+    // Reconnect after the connection is lost
+    client->enableRetry();
+    std::weak_ptr<Endpoint> weakEndpoint = endpoint;
+    client->setConnectionCallback(
+        [weakEndpoint, cb = connectionCallback_](const TcpConnectionPtr &conn) {
+            if (auto endpoint = weakEndpoint.lock())
+            {
+                if (conn->connected())
+                {
+                    endpoint->connection = conn;
+                    endpoint->reconnectDelay = kMinReconnectDelay;
+                }
+                else if (endpoint->connection == conn)
+                {
+                    endpoint->connection.reset();
+                }
+            }
+            if (cb)
+                cb(conn);
+        });
+    if (messageCallback_)
+        client->setMessageCallback(messageCallback_);
+    // TcpClient only retries lost connections, not failed attempts
+    client->setConnectionErrorCallback([weakEndpoint, loop = loop_]() {
+        auto endpoint = weakEndpoint.lock();
+        if (!endpoint || endpoint->removed)
+            return;
+        LOG_DEBUG << "Failed to connect to " << endpoint->address.toIpPort()
+                  << ", retrying in " << endpoint->reconnectDelay << " s";
+        loop->runAfter(endpoint->reconnectDelay, [weakEndpoint]() {
+            auto endpoint = weakEndpoint.lock();
+            if (endpoint && !endpoint->removed)
+                endpoint->client->connect();
+        });
+        endpoint->reconnectDelay =
+            (std::min)(endpoint->reconnectDelay * 2, kMaxReconnectDelay);
+    });
+    endpoint->client = std::move(client);
+    endpoint->client->connect();
+    return endpoint;
+}
+
+void UpstreamBalancer::setEndpoints(const std::vector<InetAddress> &endpoints,
+                                    uint16_t port)
+{
+    loop_->assertInLoopThread();
+    std::unordered_map<std::string, std::shared_ptr<Endpoint>> current;
+    for (auto &endpoint : endpoints_)
+        current.emplace(endpoint->address.toIpPort(), std::move(endpoint));
+    endpoints_.clear();
+    for (auto address : endpoints)
+    {
+        if (port != 0)
+            address.setPortNetEndian(htons(port));
+        auto iter = current.find(address.toIpPort());
+        if (iter != current.end())
+        {
+            endpoints_.push_back(std::move(iter->second));
+            current.erase(iter);
+        }
+        else
+        {
+            endpoints_.push_back(newEndpoint(address));
+        }
+    }
+    // stop() only stops connecting and reconnecting. The connection of a
+    // removed endpoint stays open for the requests routed to it, and is
+    // closed by the TcpClient's destructor when the last of them is finished
+    // and releases the endpoint.
+    for (auto &removed : current)
+    {
+        removed.second->removed = true;
+        removed.second->client->stop();
+    }
+}
+
+bool UpstreamBalancer::lessLoaded(const Endpoint &a, const Endpoint &b) const
+{
+    if (metric_ == LoadMetric::Latency)
+    {
+        // Endpoints without a sample yet have a latency of 0 and get tried
+        auto load = [](const Endpoint &e) {
+            return e.latency * static_cast<double>(e.outstandingRequests + 1);
+        };
+        const double loadA = load(a);
+        const double loadB = load(b);
+        if (loadA != loadB)
+            return loadA < loadB;
+    }
+    else if (a.outstandingBytes != b.outstandingBytes)
+    {
+        return a.outstandingBytes < b.outstandingBytes;
+    }
+    return a.outstandingRequests < b.outstandingRequests;
+}
+
+UpstreamBalancer::Request UpstreamBalancer::pick(size_t requestBytes)
+{
+    loop_->assertInLoopThread();
+    const auto now = std::chrono::steady_clock::now();
+    candidates_.clear();
+    for (size_t i = 0; i < endpoints_.size(); ++i)
+    {
+        auto &endpoint = *endpoints_[i];
+        if (endpoint.connection && endpoint.connection->connected() &&
+            now >= endpoint.ejectedUntil)
+            candidates_.push_back(i);
+    }
+    Request request;
+    if (candidates_.empty())
+        return request;
+
+    size_t chosen = candidates_[0];
+    if (candidates_.size() > 1)
+    {
+        // Two distinct random candidates
+        const size_t n = candidates_.size();
+        size_t first = random_() % n;
+        size_t second = random_() % (n - 1);
+        if (second >= first)
+            ++second;
+        first = candidates_[first];
+        second = candidates_[second];
+        chosen = lessLoaded(*endpoints_[second], *endpoints_[first]) ? second
+                                                                     : first;
+    }
+    auto &endpoint = endpoints_[chosen];
+    ++endpoint->outstandingRequests;
+    endpoint->outstandingBytes += requestBytes;
+    request.endpoint_ = endpoint;
+    request.connection_ = endpoint->connection;
+    request.bytes_ = requestBytes;
+    request.start_ = now;
+    return request;
+}
+
+void UpstreamBalancer::finish(Request &request, bool success)
+{
+    loop_->assertInLoopThread();
+    if (!request.endpoint_)
+        return;
+    auto &endpoint = *request.endpoint_;
+    assert(endpoint.outstandingRequests > 0);
+    --endpoint.outstandingRequests;
+    endpoint.outstandingBytes -= request.bytes_;
+    const auto now = std::chrono::steady_clock::now();
+    // Failed requests count too, a timed out request is a slow one
+    const double latency =
+        std::chrono::duration<double>(now - request.start_).count();
+    if (endpoint.latency == 0)
+        endpoint.latency = latency;
+    else
+        endpoint.latency += kLatencyDecay * (latency - endpoint.latency);
+    if (success)
+    {
+        endpoint.consecutiveFailures = 0;
+        endpoint.ejections = 0;
+    }
+    else if (consecutiveFailures_ > 0 &&
+             ++endpoint.consecutiveFailures >= consecutiveFailures_ &&
+             now >= endpoint.ejectedUntil)
+    {
+        eject(endpoint, now);
+    }
+    request = Request();
+}
+
+void UpstreamBalancer::eject(Endpoint &endpoint,
+                             std::chrono::steady_clock::time_point now)
+{
+    size_t ejected = 0;
+    for (auto &ep : endpoints_)
+    {
+        if (now < ep->ejectedUntil)
+            ++ejected;
+    }
+    if (static_cast<double>(ejected + 1) >
+        maxEjectedRatio_ * static_cast<double>(endpoints_.size()))
+        return;
+    endpoint.ejections = (std::min)(endpoint.ejections + 1,
+                                    kMaxEjectionMultiplier);
+    endpoint.consecutiveFailures = 0;
+    const double seconds =
+        ejectionTime_ * static_cast<double>(endpoint.ejections);
+    endpoint.ejectedUntil =
+        now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(seconds));
+    LOG_WARN << name_ << ": ejected " << endpoint.address.toIpPort()
+             << " for " << seconds << " s";
+}
+
+std::vector<UpstreamBalancer::EndpointStats> UpstreamBalancer::endpointStats()
+    const
+{
+    loop_->assertInLoopThread();
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<EndpointStats> stats;
+    stats.reserve(endpoints_.size());
+    for (auto &endpoint : endpoints_)
+    {
+        stats.push_back({endpoint->address,
+                         endpoint->connection &&
+                             endpoint->connection->connected(),
+                         now < endpoint->ejectedUntil,
+                         endpoint->outstandingRequests,
+                         endpoint->outstandingBytes,
+                         endpoint->latency});
+    }
+    return stats;
+}
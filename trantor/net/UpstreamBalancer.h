@@ -0,0 +1,245 @@
+/**
+ *
+ *  @file UpstreamBalancer.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+#include <trantor/exports.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/net/callbacks.h>
+#include <trantor/utils/NonCopyable.h>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace trantor
+{
+/**
+ * @brief This class keeps a TcpClient connection to each of a set of
+ * upstream endpoints and routes requests among them.
+ *
+ * Each request goes to the less loaded of two randomly chosen endpoints
+ * (power of two choices), which spreads load almost as well as always
+ * choosing the least loaded endpoint without herding onto it. An endpoint
+ * that fails several requests in a row is ejected for a while.
+ *
+ * The balancer doesn't know the application protocol, so the caller tells it
+ * when a request is done:
+ * @code
+   auto request = balancer->pick(payload.size());
+   if (request)
+   {
+       request.connection()->send(payload);
+       // Later, when the response arrives or the request times out
+       balancer->finish(request, succeeded);
+   }
+   @endcode
+ * @note All the methods must be called in the thread of the event loop.
+ */
+class TRANTOR_EXPORT UpstreamBalancer : NonCopyable
+{
+    struct Endpoint;
+
+  public:
+    /**
+     * @brief The load compared between the two choices.
+     */
+    enum class LoadMetric
+    {
+        /// The bytes of the requests that are not finished yet
+        OutstandingBytes,
+        /// The moving average of the latency, weighted by the number of
+        /// requests that are not finished yet
+        Latency
+    };
+
+    /**
+     * @brief A request routed to an endpoint, returned by pick().
+     */
+    class Request
+    {
+      public:
+        Request() = default;
+
+        /**
+         * @brief False if no endpoint was available.
+         */
+        explicit operator bool() const
+        {
+            return endpoint_ != nullptr;
+        }
+
+        /**
+         * @brief The connection to send the request on.
+         */
+        const TcpConnectionPtr &connection() const
+        {
+            return connection_;
+        }
+
+      private:
+        friend class UpstreamBalancer;
+        std::shared_ptr<Endpoint> endpoint_;
+        TcpConnectionPtr connection_;
+        size_t bytes_{0};
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    /**
+     * @brief The state of an endpoint, see endpointStats().
+     */
+    struct EndpointStats
+    {
+        InetAddress address;
+        bool connected;
+        bool ejected;
+        size_t outstandingRequests;
+        size_t outstandingBytes;
+        /// The moving average of the latency in seconds
+        double latency;
+    };
+
+    /**
+     * @brief Construct a new balancer.
+     *
+     * @param loop The event loop in which the balancer and the connections
+     * to the endpoints run.
+     * @param name The name of the balancer, the TcpClients are named after
+     * it.
+     */
+    UpstreamBalancer(EventLoop *loop, std::string name);
+    ~UpstreamBalancer();
+
+    /**
+     * @brief Set the endpoints to connect to. The connections to endpoints
+     * that are in the previous set are kept, those to endpoints that are not
+     * in the new set are closed once the requests routed to them are
+     * finished.
+     *
+     * @param endpoints A static list or the results of a Resolver.
+     * @param port If not zero, the port of every endpoint, since the
+     * addresses returned by a Resolver have no port.
+     */
+    void setEndpoints(const std::vector<InetAddress> &endpoints,
+                      uint16_t port = 0);
+
+    /**
+     * @brief Route a request.
+     *
+     * @param requestBytes The size of the request, used by the
+     * OutstandingBytes metric.
+     * @return A request that converts to false if no endpoint is connected.
+     */
+    Request pick(size_t requestBytes = 0);
+
+    /**
+     * @brief Report the outcome of a request returned by pick(). The request
+     * is reset.
+     *
+     * @param success Whether the request succeeded. Failures count towards
+     * ejecting the endpoint. The time since pick() is the latency sample of
+     * the Latency metric.
+     */
+    void finish(Request &request, bool success = true);
+
+    /**
+     * @brief Set the load metric, OutstandingBytes by default.
+     */
+    void setLoadMetric(LoadMetric metric)
+    {
+        metric_ = metric;
+    }
+
+    /**
+     * @brief Set the outlier ejection policy.
+     *
+     * @param consecutiveFailures An endpoint is ejected after this number of
+     * failed requests in a row, 0 disables ejection. The default is 5.
+     * @param ejectionTime The time in seconds an endpoint is ejected for the
+     * first time. It is multiplied by the number of ejections without a
+     * successful request in between, up to 10. The default is 30 seconds.
+     * @param maxEjectedRatio The maximum ratio of endpoints ejected at the
+     * same time. The default is 0.5.
+     */
+    void setOutlierEjection(size_t consecutiveFailures,
+                            double ejectionTime = 30.0,
+                            double maxEjectedRatio = 0.5)
+    {
+        consecutiveFailures_ = consecutiveFailures;
+        ejectionTime_ = ejectionTime;
+        maxEjectedRatio_ = maxEjectedRatio;
+    }
+
+    /**
+     * @brief Set the connection callback of the connections to the
+     * endpoints. Callbacks and TLS must be set before setEndpoints().
+     */
+    void setConnectionCallback(const ConnectionCallback &cb)
+    {
+        connectionCallback_ = cb;
+    }
+
+    /**
+     * @brief Set the message callback of the connections to the endpoints.
+     */
+    void setMessageCallback(const RecvMessageCallback &cb)
+    {
+        messageCallback_ = cb;
+    }
+
+    /**
+     * @brief Enable TLS on the connections to the endpoints.
+     */
+    void enableSSL(TLSPolicyPtr policy)
+    {
+        tlsPolicyPtr_ = std::move(policy);
+    }
+
+    /**
+     * @brief Get the state of every endpoint.
+     */
+    std::vector<EndpointStats> endpointStats() const;
+
+    /**
+     * @brief Get the event loop.
+     */
+    EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+  private:
+    std::shared_ptr<Endpoint> newEndpoint(const InetAddress &address);
+    bool lessLoaded(const Endpoint &a, const Endpoint &b) const;
+    void eject(Endpoint &endpoint,
+               std::chrono::steady_clock::time_point now);
+
+    EventLoop *loop_;
+    const std::string name_;
+    std::vector<std::shared_ptr<Endpoint>> endpoints_;
+    // Indices of the available endpoints, reused by pick()
+    std::vector<size_t> candidates_;
+    LoadMetric metric_{LoadMetric::OutstandingBytes};
+    size_t consecutiveFailures_{5};
+    double ejectionTime_{30.0};
+    double maxEjectedRatio_{0.5};
+    ConnectionCallback connectionCallback_;
+    RecvMessageCallback messageCallback_;
+    TLSPolicyPtr tlsPolicyPtr_;
+    std::minstd_rand random_;
+};
+
+}  // namespace trantor
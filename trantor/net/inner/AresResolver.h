@@ -9,6 +9,7 @@
 #include <trantor/net/Resolver.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/Utilities.h>
 #include <map>
 #include <memory>
 #include <string.h>
@@ -132,13 +133,15 @@ class AresResolver : public Resolver,
     static std::unordered_map<
         std::string,
         std::pair<std::shared_ptr<std::vector<trantor::InetAddress>>,
-                  trantor::Date>>&
+                  trantor::Date>,
+        utils::StringHash>&
     globalCache()
     {
         static std::unordered_map<
             std::string,
             std::pair<std::shared_ptr<std::vector<trantor::InetAddress>>,
-                      trantor::Date>>
+                      trantor::Date>,
+            utils::StringHash>
             dnsCache;
         return dnsCache;
     }
@@ -0,0 +1,187 @@
+/**
+ *
+ *  @file AsyncFileEngine.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include "AsyncFileEngine.h"
+#ifdef TRANTOR_HAS_IO_URING
+#include "IoUringFileEngine.h"
+#endif
+#include <trantor/utils/ConcurrentTaskQueue.h>
+#include <trantor/utils/Utilities.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace trantor;
+
+namespace
+{
+ConcurrentTaskQueue &fileQueue()
+{
+    static ConcurrentTaskQueue queue(
+        std::thread::hardware_concurrency() < 4
+            ? 4
+            : std::thread::hardware_concurrency(),
+        "File IO Queue");
+    return queue;
+}
+
+#ifdef _WIN32
+ssize_t positionalIo(int fd,
+                     char *buffer,
+                     size_t length,
+                     uint64_t offset,
+                     bool write)
+{
+    auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD n = 0;
+    const BOOL ok =
+        write ? WriteFile(handle, buffer, (DWORD)length, &n, &overlapped)
+              : ReadFile(handle, buffer, (DWORD)length, &n, &overlapped);
+    if (!ok)
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -EIO;
+    return static_cast<ssize_t>(n);
+}
+#endif
+}  // namespace
+
+std::shared_ptr<AsyncFileEngine> AsyncFileEngine::forLoop(EventLoop *loop)
+{
+    loop->assertInLoopThread();
+    // The running loop holds its engine until it quits, so the engine isn't
+    // recreated for every file. A loop that isn't running might never run
+    // its quit functions, the engine only lives as long as its files then.
+    static thread_local std::weak_ptr<AsyncFileEngine> weakEngine;
+    static thread_local std::shared_ptr<AsyncFileEngine> heldEngine;
+    static thread_local EventLoop *engineLoop{nullptr};
+    auto engine = weakEngine.lock();
+    if (engine && engineLoop == loop)
+    {
+        if (!heldEngine && loop->isRunning())
+        {
+            heldEngine = engine;
+            loop->runOnQuit([]() { heldEngine.reset(); });
+        }
+        return engine;
+    }
+    engine.reset();
+    heldEngine.reset();
+#ifdef TRANTOR_HAS_IO_URING
+    engine = IoUringFileEngine::create(loop);
+#endif
+    if (!engine)
+        engine = std::make_shared<ThreadPoolFileEngine>(loop);
+    weakEngine = engine;
+    engineLoop = loop;
+    if (loop->isRunning())
+    {
+        heldEngine = engine;
+        loop->runOnQuit([]() { heldEngine.reset(); });
+    }
+    return engine;
+}
+
+ssize_t AsyncFileEngine::runBlocking(AsyncFileOp &op)
+{
+    switch (op.type)
+    {
+        case AsyncFileOp::Type::Open:
+        {
+#ifdef _WIN32
+            int fd = _wopen(utils::toNativePath(op.path).c_str(),
+                            op.flags | _O_BINARY,
+                            op.mode);
+#else
+            int fd = ::open(op.path.c_str(), op.flags | O_CLOEXEC, op.mode);
+#endif
+            return fd < 0 ? -errno : fd;
+        }
+        case AsyncFileOp::Type::Read:
+        {
+#ifdef _WIN32
+            return positionalIo(op.fd, op.buffer, op.length, op.offset, false);
+#else
+            ssize_t n;
+            do
+            {
+                n = ::pread(op.fd,
+                            op.buffer,
+                            op.length,
+                            static_cast<off_t>(op.offset));
+            } while (n < 0 && errno == EINTR);
+            return n < 0 ? -errno : n;
+#endif
+        }
+        case AsyncFileOp::Type::Write:
+        {
+            while (op.done < op.length)
+            {
+#ifdef _WIN32
+                ssize_t n = positionalIo(op.fd,
+                                         op.buffer + op.done,
+                                         op.length - op.done,
+                                         op.offset + op.done,
+                                         true);
+                if (n < 0)
+                    return n;
+#else
+                ssize_t n = ::pwrite(op.fd,
+                                     op.buffer + op.done,
+                                     op.length - op.done,
+                                     static_cast<off_t>(op.offset + op.done));
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return -errno;
+                }
+#endif
+                // No progress for a non-empty write would loop forever
+                if (n == 0)
+                    return -EIO;
+                op.done += static_cast<size_t>(n);
+            }
+            return static_cast<ssize_t>(op.done);
+        }
+        case AsyncFileOp::Type::Fsync:
+        {
+#ifdef _WIN32
+            auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(op.fd));
+            return FlushFileBuffers(handle) ? 0 : -EIO;
+#elif defined(__linux__)
+            const int ret = op.dataOnly ? ::fdatasync(op.fd) : ::fsync(op.fd);
+            return ret < 0 ? -errno : 0;
+#else
+            return ::fsync(op.fd) < 0 ? -errno : 0;
+#endif
+        }
+    }
+    return -EINVAL;
+}
+
+void ThreadPoolFileEngine::submit(AsyncFileOpPtr op)
+{
+    std::shared_ptr<AsyncFileOp> sharedOp(std::move(op));
+    fileQueue().runTaskInQueue([sharedOp, loop = loop_]() {
+        const ssize_t result = runBlocking(*sharedOp);
+        loop->queueInLoop(
+            [sharedOp, result]() { sharedOp->callback(result); });
+    });
+}
@@ -0,0 +1,113 @@
+/**
+ *
+ *  @file AsyncFileEngine.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace trantor
+{
+/**
+ * @brief A file operation of AsyncFile.
+ */
+struct AsyncFileOp
+{
+    enum class Type
+    {
+        Open,
+        Read,
+        Write,
+        Fsync
+    };
+    explicit AsyncFileOp(Type t) : type(t)
+    {
+    }
+
+    Type type;
+    int fd{-1};
+    // Open
+    std::string path;
+    int flags{0};
+    int mode{0};
+    // Read and Write
+    char *buffer{nullptr};
+    size_t length{0};
+    uint64_t offset{0};
+    // The bytes written so far, writes are always completed
+    size_t done{0};
+    // The data of a write owned by the operation
+    std::string data;
+    // Fsync
+    bool dataOnly{false};
+    // Keeps the file alive until completion
+    std::shared_ptr<void> owner;
+    std::function<void(ssize_t)> callback;
+};
+using AsyncFileOpPtr = std::unique_ptr<AsyncFileOp>;
+
+/**
+ * @brief The engine running the file operations of the files of an event
+ * loop.
+ */
+class AsyncFileEngine : NonCopyable
+{
+  public:
+    virtual ~AsyncFileEngine() = default;
+
+    /**
+     * @brief Get the engine of the loop of the current thread: an io_uring if
+     * the kernel supports it, or the shared thread pool.
+     */
+    static std::shared_ptr<AsyncFileEngine> forLoop(EventLoop *loop);
+
+    /**
+     * @brief Run an operation, the callback is called in the loop.
+     * @note Must be called in the loop.
+     */
+    virtual void submit(AsyncFileOpPtr op) = 0;
+
+    virtual bool isIoUring() const = 0;
+
+  protected:
+    /**
+     * @brief Run an operation in the current thread.
+     * @return The result passed to the callback.
+     */
+    static ssize_t runBlocking(AsyncFileOp &op);
+};
+
+/**
+ * @brief The engine running the operations on a thread pool shared by all
+ * the loops.
+ */
+class ThreadPoolFileEngine : public AsyncFileEngine
+{
+  public:
+    explicit ThreadPoolFileEngine(EventLoop *loop) : loop_(loop)
+    {
+    }
+    void submit(AsyncFileOpPtr op) override;
+    bool isIoUring() const override
+    {
+        return false;
+    }
+
+  private:
+    EventLoop *loop_;
+};
+
+}  // namespace trantor
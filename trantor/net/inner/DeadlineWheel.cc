@@ -0,0 +1,111 @@
+/**
+ *
+ *  @file DeadlineWheel.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include "DeadlineWheel.h"
+#include <cmath>
+
+using namespace trantor;
+
+namespace
+{
+constexpr double kTickInterval = 0.1;
+// About 25 seconds, longer deadlines are checked once per turn of the wheel
+constexpr size_t kBucketsNum = 256;
+}  // namespace
+
+DeadlineWheel::DeadlineWheel(EventLoop *loop)
+    : loop_(loop),
+      buckets_(kBucketsNum),
+      start_(std::chrono::steady_clock::now())
+{
+}
+
+DeadlineWheel::~DeadlineWheel()
+{
+    if (ticking_)
+        loop_->invalidateTimer(timerId_);
+}
+
+std::shared_ptr<DeadlineWheel> DeadlineWheel::forLoop(EventLoop *loop)
+{
+    loop->assertInLoopThread();
+    static thread_local std::weak_ptr<DeadlineWheel> weakWheel;
+    auto wheel = weakWheel.lock();
+    if (!wheel || wheel->loop_ != loop)
+    {
+        wheel = std::make_shared<DeadlineWheel>(loop);
+        weakWheel = wheel;
+    }
+    return wheel;
+}
+
+uint64_t DeadlineWheel::deadlineTick(double seconds) const
+{
+    // The current tick is at most one tick behind
+    const auto ticks =
+        static_cast<uint64_t>(std::ceil(seconds / kTickInterval));
+    return currentTick_ + (ticks > 0 ? ticks : 1);
+}
+
+uint64_t DeadlineWheel::schedule(std::weak_ptr<Connection> conn,
+                                 uint64_t tick)
+{
+    loop_->assertInLoopThread();
+    if (!ticking_)
+    {
+        // The wheel didn't turn while it was empty
+        using Duration = std::chrono::steady_clock::duration;
+        start_ = std::chrono::steady_clock::now() -
+                 std::chrono::duration_cast<Duration>(
+                     std::chrono::duration<double>(currentTick_ *
+                                                   kTickInterval));
+        std::weak_ptr<DeadlineWheel> weakSelf = shared_from_this();
+        timerId_ = loop_->runEvery(kTickInterval, [weakSelf]() {
+            if (auto self = weakSelf.lock())
+                self->onTick();
+        });
+        ticking_ = true;
+    }
+    if (tick <= currentTick_)
+        tick = currentTick_ + 1;
+    else if (tick >= currentTick_ + kBucketsNum)
+        tick = currentTick_ + kBucketsNum - 1;
+    buckets_[tick % kBucketsNum].push_back(std::move(conn));
+    ++scheduled_;
+    return tick;
+}
+
+void DeadlineWheel::onTick()
+{
+    const auto elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start_)
+                             .count();
+    const auto target = static_cast<uint64_t>(elapsed / kTickInterval);
+    while (currentTick_ < target)
+    {
+        ++currentTick_;
+        expiring_.swap(buckets_[currentTick_ % kBucketsNum]);
+        scheduled_ -= expiring_.size();
+        // Connections may schedule themselves again, in later buckets
+        for (auto &weakConn : expiring_)
+        {
+            if (auto conn = weakConn.lock())
+                conn->checkDeadlines(currentTick_);
+        }
+        expiring_.clear();
+    }
+    if (scheduled_ == 0)
+    {
+        loop_->invalidateTimer(timerId_);
+        ticking_ = false;
+    }
+}
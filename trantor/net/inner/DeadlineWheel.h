@@ -0,0 +1,88 @@
+/**
+ *
+ *  @file DeadlineWheel.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace trantor
+{
+/**
+ * @brief The wheel on which the read and write deadlines of the connections
+ * of a loop expire, see TcpConnection::setReadDeadline().
+ *
+ * Deadlines are counted in ticks of the wheel. A connection is in at most one
+ * bucket at a time, the one of its earliest deadline, and is checked when
+ * that bucket expires. Moving a deadline later only changes the tick stored
+ * in the connection, which is checked again and rescheduled when its bucket
+ * expires, so deadlines that are reset on every request cost no allocation.
+ *
+ * The timer of the wheel only runs while connections are scheduled.
+ */
+class DeadlineWheel : NonCopyable,
+                      public std::enable_shared_from_this<DeadlineWheel>
+{
+  public:
+    /**
+     * @brief A connection whose deadlines expire on the wheel.
+     */
+    class Connection
+    {
+      public:
+        virtual ~Connection() = default;
+        // Called when the bucket of the tick the connection was scheduled to
+        // expires
+        virtual void checkDeadlines(uint64_t tick) = 0;
+    };
+
+    explicit DeadlineWheel(EventLoop *loop);
+    ~DeadlineWheel();
+
+    /**
+     * @brief Get the wheel of the loop of the current thread, created if the
+     * loop has none.
+     */
+    static std::shared_ptr<DeadlineWheel> forLoop(EventLoop *loop);
+
+    /**
+     * @brief The tick by which a deadline the given seconds from now expires.
+     */
+    uint64_t deadlineTick(double seconds) const;
+
+    /**
+     * @brief Schedule a connection to be checked when the given tick expires.
+     *
+     * @return The tick of the bucket the connection is put in, which is
+     * earlier than the given tick if it's beyond the span of the wheel.
+     */
+    uint64_t schedule(std::weak_ptr<Connection> conn, uint64_t tick);
+
+  private:
+    void onTick();
+
+    EventLoop *loop_;
+    std::vector<std::vector<std::weak_ptr<Connection>>> buckets_;
+    // The bucket being expired, swapped with it to keep both capacities
+    std::vector<std::weak_ptr<Connection>> expiring_;
+    uint64_t currentTick_{0};
+    size_t scheduled_{0};
+    bool ticking_{false};
+    TimerId timerId_{0};
+    // The time of tick 0, the ticks are counted from it
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace trantor
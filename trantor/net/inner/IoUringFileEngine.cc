@@ -0,0 +1,354 @@
+/**
+ *
+ *  @file IoUringFileEngine.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include "IoUringFileEngine.h"
+#include <trantor/net/Channel.h>
+#include <trantor/utils/Logger.h>
+#include <linux/io_uring.h>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace trantor;
+
+namespace
+{
+constexpr unsigned kRingEntries = 256;
+// The largest transfer of a single operation, as for read(2)
+constexpr size_t kMaxTransfer = 0x7ffff000;
+
+template <typename T>
+T *ringField(void *ring, unsigned offset)
+{
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+}  // namespace
+
+std::shared_ptr<IoUringFileEngine> IoUringFileEngine::create(EventLoop *loop)
+{
+    auto engine = std::make_shared<IoUringFileEngine>(loop);
+    if (!engine->init())
+    {
+        LOG_DEBUG << "io_uring is not available, files use the thread pool";
+        return nullptr;
+    }
+    std::weak_ptr<IoUringFileEngine> weakEngine = engine;
+    engine->eventChannel_->setReadCallback([weakEngine]() {
+        if (auto engine = weakEngine.lock())
+            engine->handleCompletions();
+    });
+    engine->eventChannel_->enableReading();
+    return engine;
+}
+
+IoUringFileEngine::IoUringFileEngine(EventLoop *loop) : loop_(loop)
+{
+}
+
+IoUringFileEngine::~IoUringFileEngine()
+{
+    // Operations keep the engine alive, so none is in flight
+    auto cleanup = [channel = eventChannel_,
+                    ringFd = ringFd_,
+                    eventFd = eventFd_,
+                    sqRing = sqRing_,
+                    sqRingSize = sqRingSize_,
+                    cqRing = cqRing_,
+                    cqRingSize = cqRingSize_,
+                    sqes = sqes_,
+                    sqesSize = sqesSize_]() {
+        if (channel)
+        {
+            channel->disableAll();
+            channel->remove();
+        }
+        if (sqes)
+            ::munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing)
+            ::munmap(cqRing, cqRingSize);
+        if (sqRing)
+            ::munmap(sqRing, sqRingSize);
+        if (eventFd >= 0)
+            ::close(eventFd);
+        if (ringFd >= 0)
+            ::close(ringFd);
+    };
+    if (loop_->isInLoopThread())
+        cleanup();
+    else
+        loop_->runInLoop(std::move(cleanup));
+}
+
+bool IoUringFileEngine::init()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ringFd_ = static_cast<int>(
+        ::syscall(__NR_io_uring_setup, kRingEntries, &params));
+    if (ringFd_ < 0)
+        return false;
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap)
+    {
+        sqRingSize_ = (std::max)(sqRingSize_, cqRingSize_);
+        cqRingSize_ = sqRingSize_;
+    }
+    sqRing_ = ::mmap(nullptr,
+                     sqRingSize_,
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE,
+                     ringFd_,
+                     IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED)
+    {
+        sqRing_ = nullptr;
+        return false;
+    }
+    if (singleMmap)
+    {
+        cqRing_ = sqRing_;
+    }
+    else
+    {
+        cqRing_ = ::mmap(nullptr,
+                         cqRingSize_,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE,
+                         ringFd_,
+                         IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED)
+        {
+            cqRing_ = nullptr;
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = ::mmap(nullptr,
+                        sqesSize_,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        ringFd_,
+                        IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    sqHead_ = ringField<unsigned>(sqRing_, params.sq_off.head);
+    sqTail_ = ringField<unsigned>(sqRing_, params.sq_off.tail);
+    sqMask_ = *ringField<unsigned>(sqRing_, params.sq_off.ring_mask);
+    sqArray_ = ringField<unsigned>(sqRing_, params.sq_off.array);
+    sqEntries_ = params.sq_entries;
+    cqHead_ = ringField<unsigned>(cqRing_, params.cq_off.head);
+    cqTail_ = ringField<unsigned>(cqRing_, params.cq_off.tail);
+    cqMask_ = *ringField<unsigned>(cqRing_, params.cq_off.ring_mask);
+    cqes_ = ringField<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+    cqEntries_ = params.cq_entries;
+
+    // The operations used need Linux 5.6
+    const unsigned probeOps = 256;
+    std::vector<char> probeBuffer(sizeof(io_uring_probe) +
+                                  probeOps * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe *>(probeBuffer.data());
+    if (::syscall(__NR_io_uring_register,
+                  ringFd_,
+                  IORING_REGISTER_PROBE,
+                  probe,
+                  probeOps) < 0)
+        return false;
+    for (unsigned op : {IORING_OP_OPENAT,
+                        IORING_OP_READ,
+                        IORING_OP_WRITE,
+                        IORING_OP_FSYNC})
+    {
+        if (op > probe->last_op ||
+            (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)
+            return false;
+    }
+
+    eventFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ < 0)
+        return false;
+    if (::syscall(__NR_io_uring_register,
+                  ringFd_,
+                  IORING_REGISTER_EVENTFD,
+                  &eventFd_,
+                  1) < 0)
+        return false;
+    eventChannel_ = std::make_shared<Channel>(loop_, eventFd_);
+    return true;
+}
+
+void IoUringFileEngine::submit(AsyncFileOpPtr op)
+{
+    loop_->assertInLoopThread();
+    if (!waiting_.empty() || inFlight_ == cqEntries_)
+    {
+        waiting_.push_back(std::move(op));
+        return;
+    }
+    if (toSubmit_ == sqEntries_)
+        flush();
+    // flush() may fail and leave the submission ring full
+    if (sqFull())
+    {
+        waiting_.push_back(std::move(op));
+        return;
+    }
+    prepare(op.release());
+    if (!flushQueued_)
+    {
+        // Submit the operations of this iteration together
+        flushQueued_ = true;
+        std::weak_ptr<IoUringFileEngine> weakSelf = shared_from_this();
+        loop_->queueInLoop([weakSelf]() {
+            if (auto self = weakSelf.lock())
+                self->flush();
+        });
+    }
+}
+
+bool IoUringFileEngine::sqFull() const
+{
+    // The kernel moves the head as it consumes the entries
+    return *sqTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_;
+}
+
+void IoUringFileEngine::prepare(AsyncFileOp *op)
+{
+    // Only this thread writes the tail
+    const unsigned tail = *sqTail_;
+    const unsigned index = tail & sqMask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    switch (op->type)
+    {
+        case AsyncFileOp::Type::Open:
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(op->path.c_str());
+            sqe->len = static_cast<uint32_t>(op->mode);
+            sqe->open_flags = static_cast<uint32_t>(op->flags | O_CLOEXEC);
+            break;
+        case AsyncFileOp::Type::Read:
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = op->fd;
+            sqe->addr = reinterpret_cast<uint64_t>(op->buffer);
+            sqe->len = static_cast<uint32_t>(
+                (std::min)(op->length, kMaxTransfer));
+            sqe->off = op->offset;
+            break;
+        case AsyncFileOp::Type::Write:
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = op->fd;
+            sqe->addr = reinterpret_cast<uint64_t>(op->buffer + op->done);
+            sqe->len = static_cast<uint32_t>(
+                (std::min)(op->length - op->done, kMaxTransfer));
+            sqe->off = op->offset + op->done;
+            break;
+        case AsyncFileOp::Type::Fsync:
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = op->fd;
+            sqe->fsync_flags = op->dataOnly ? IORING_FSYNC_DATASYNC : 0;
+            break;
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(op);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    ++toSubmit_;
+    ++inFlight_;
+}
+
+void IoUringFileEngine::flush()
+{
+    flushQueued_ = false;
+    while (toSubmit_ > 0)
+    {
+        const int ret = static_cast<int>(::syscall(
+            __NR_io_uring_enter, ringFd_, toSubmit_, 0, 0, nullptr, 0));
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // Out of kernel resources, try again shortly
+            LOG_SYSERR << "io_uring_enter";
+            std::weak_ptr<IoUringFileEngine> weakSelf = shared_from_this();
+            flushQueued_ = true;
+            loop_->runAfter(0.001, [weakSelf]() {
+                if (auto self = weakSelf.lock())
+                    self->flush();
+            });
+            return;
+        }
+        toSubmit_ -= static_cast<unsigned>(ret);
+    }
+}
+
+void IoUringFileEngine::handleCompletions()
+{
+    // The last operations may hold the last references to the engine
+    auto guard = shared_from_this();
+    uint64_t count;
+    if (::read(eventFd_, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        LOG_SYSERR << "read eventfd";
+    unsigned head = *cqHead_;
+    for (;;)
+    {
+        const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        if (head == tail)
+            break;
+        const io_uring_cqe &cqe = cqes_[head & cqMask_];
+        auto op = reinterpret_cast<AsyncFileOp *>(cqe.user_data);
+        const int res = cqe.res;
+        ++head;
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        --inFlight_;
+
+        if (op->type == AsyncFileOp::Type::Write && res > 0 &&
+            op->done + static_cast<size_t>(res) < op->length)
+        {
+            // Short write, write the rest
+            op->done += static_cast<size_t>(res);
+            submit(AsyncFileOpPtr(op));
+            continue;
+        }
+        AsyncFileOpPtr done(op);
+        ssize_t result = res;
+        if (op->type == AsyncFileOp::Type::Write && res >= 0)
+        {
+            // No progress before the end, like runBlocking()
+            result = (res == 0 && op->done < op->length)
+                         ? -EIO
+                         : static_cast<ssize_t>(op->done + res);
+        }
+        done->callback(result);
+    }
+    while (!waiting_.empty() && inFlight_ < cqEntries_)
+    {
+        if (toSubmit_ == sqEntries_)
+            flush();
+        if (sqFull())
+            break;
+        prepare(waiting_.front().release());
+        waiting_.pop_front();
+    }
+    if (toSubmit_ > 0 && !flushQueued_)
+        flush();
+}
@@ -0,0 +1,91 @@
+/**
+ *
+ *  @file IoUringFileEngine.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include "AsyncFileEngine.h"
+#include <deque>
+#include <memory>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace trantor
+{
+class Channel;
+
+/**
+ * @brief The engine running the file operations of a loop on an io_uring.
+ *
+ * Operations submitted in an iteration of the loop are submitted to the
+ * kernel together at the end of the iteration. The completions are signaled
+ * by an eventfd watched by the loop.
+ */
+class IoUringFileEngine
+    : public AsyncFileEngine,
+      public std::enable_shared_from_this<IoUringFileEngine>
+{
+  public:
+    /**
+     * @brief Create an engine, nullptr if the kernel doesn't support the
+     * operations of io_uring used.
+     */
+    static std::shared_ptr<IoUringFileEngine> create(EventLoop *loop);
+
+    explicit IoUringFileEngine(EventLoop *loop);
+    ~IoUringFileEngine() override;
+
+    void submit(AsyncFileOpPtr op) override;
+    bool isIoUring() const override
+    {
+        return true;
+    }
+
+  private:
+    bool init();
+    bool sqFull() const;
+    void prepare(AsyncFileOp *op);
+    void flush();
+    void handleCompletions();
+
+    EventLoop *loop_;
+    int ringFd_{-1};
+    int eventFd_{-1};
+    std::shared_ptr<Channel> eventChannel_;
+
+    void *sqRing_{nullptr};
+    size_t sqRingSize_{0};
+    void *cqRing_{nullptr};
+    size_t cqRingSize_{0};
+    io_uring_sqe *sqes_{nullptr};
+    size_t sqesSize_{0};
+    unsigned *sqHead_{nullptr};
+    unsigned *sqTail_{nullptr};
+    unsigned sqMask_{0};
+    unsigned *sqArray_{nullptr};
+    unsigned sqEntries_{0};
+    unsigned *cqHead_{nullptr};
+    unsigned *cqTail_{nullptr};
+    unsigned cqMask_{0};
+    io_uring_cqe *cqes_{nullptr};
+    unsigned cqEntries_{0};
+
+    // Prepared but not submitted to the kernel yet
+    unsigned toSubmit_{0};
+    // Prepared and not completed, bounded by the size of the completion ring
+    unsigned inFlight_{0};
+    bool flushQueued_{false};
+    // Operations waiting for room in the rings
+    std::deque<AsyncFileOpPtr> waiting_;
+};
+
+}  // namespace trantor
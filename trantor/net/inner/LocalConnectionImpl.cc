@@ -0,0 +1,178 @@
+/**
+ *
+ *  @file LocalConnectionImpl.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include "LocalConnectionImpl.h"
+#include <algorithm>
+
+using namespace trantor;
+
+namespace
+{
+// The bytes an inbox holds before the peer waits for the data to be
+// delivered, as the socket buffer of a TCP connection
+constexpr size_t kInboxCapacity = 1024 * 1024;
+}  // namespace
+
+std::pair<TcpConnectionPtr, TcpConnectionPtr> TcpConnection::newLocalPair(
+    EventLoop *loop1,
+    EventLoop *loop2)
+{
+    auto conn1 = std::make_shared<LocalConnectionImpl>(loop1);
+    auto conn2 = std::make_shared<LocalConnectionImpl>(loop2);
+    conn1->setPeer(conn2);
+    conn2->setPeer(conn1);
+    return {conn1, conn2};
+}
+
+LocalConnectionImpl::~LocalConnectionImpl()
+{
+    // The peer sees the end of the connection, as when a process exits
+    auto peer = peer_.lock();
+    if (peer)
+        peer->pushEof();
+}
+
+void LocalConnectionImpl::connectEstablished()
+{
+    auto thisPtr =
+        std::static_pointer_cast<LocalConnectionImpl>(shared_from_this());
+    loop_->runInLoop([thisPtr]() {
+        assert(thisPtr->status_ == ConnStatus::Connecting);
+        thisPtr->status_ = ConnStatus::Connected;
+        if (thisPtr->connectionCallback_)
+            thisPtr->connectionCallback_(thisPtr);
+        // The peer may have sent data before
+        thisPtr->deliver();
+    });
+}
+
+void LocalConnectionImpl::connectDestroyed()
+{
+    loop_->assertInLoopThread();
+    if (status_ == ConnStatus::Connected)
+    {
+        status_ = ConnStatus::Disconnected;
+        closeTransport();
+        if (connectionCallback_)
+            connectionCallback_(shared_from_this());
+    }
+}
+
+size_t LocalConnectionImpl::writeData(const char *data, size_t len)
+{
+    auto peer = peer_.lock();
+    // The data is dropped if the peer is gone, it closes this connection
+    return peer ? peer->pushData(data, len) : len;
+}
+
+void LocalConnectionImpl::shutdownWrite()
+{
+    auto peer = peer_.lock();
+    if (peer)
+        peer->pushEof();
+}
+
+void LocalConnectionImpl::closeTransport()
+{
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex_);
+        inboxClosed_ = true;
+        inbox_.retrieveAll();
+    }
+    shutdownWrite();
+}
+
+size_t LocalConnectionImpl::pushData(const char *data, size_t len)
+{
+    bool queue;
+    size_t n;
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex_);
+        if (inboxClosed_)
+            return len;
+        n = (std::min)(len, kInboxCapacity - inbox_.readableBytes());
+        inbox_.append(data, n);
+        if (n < len)
+            peerWaiting_ = true;
+        queue = n > 0 && !deliveryQueued_;
+        if (queue)
+            deliveryQueued_ = true;
+    }
+    if (queue)
+        queueDelivery();
+    return n;
+}
+
+void LocalConnectionImpl::pushEof()
+{
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex_);
+        if (inboxClosed_ || eof_)
+            return;
+        eof_ = true;
+        if (deliveryQueued_)
+            return;
+        deliveryQueued_ = true;
+    }
+    queueDelivery();
+}
+
+void LocalConnectionImpl::queueDelivery()
+{
+    // In the loop thread, the delivery runs after the current event is
+    // handled, so the data sent while handling it is delivered together
+    loop_->queueInLoop(
+        [thisPtr = std::static_pointer_cast<LocalConnectionImpl>(
+             shared_from_this())]() { thisPtr->deliver(); });
+}
+
+void LocalConnectionImpl::deliver()
+{
+    loop_->assertInLoopThread();
+    size_t n;
+    bool eof;
+    bool wakePeer;
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex_);
+        deliveryQueued_ = false;
+        // connectEstablished() delivers what is sent before
+        if (status_ != ConnStatus::Connected &&
+            status_ != ConnStatus::Disconnecting)
+            return;
+        n = inbox_.readableBytes();
+        if (readBuffer_.readableBytes() == 0)
+        {
+            readBuffer_.swap(inbox_);
+        }
+        else
+        {
+            readBuffer_.append(inbox_);
+            inbox_.retrieveAll();
+        }
+        eof = eof_;
+        wakePeer = peerWaiting_;
+        peerWaiting_ = false;
+    }
+    if (wakePeer)
+    {
+        auto peer = peer_.lock();
+        if (peer)
+        {
+            peer->loop_->queueInLoop(
+                [peer]() { peer->writeBuffered(); });
+        }
+    }
+    if (n > 0)
+        handleReceived(n);
+    if (eof)
+        handleClose();
+}
@@ -0,0 +1,64 @@
+/**
+ *
+ *  @file LocalConnectionImpl.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/inner/MemoryConnection.h>
+#include <memory>
+#include <mutex>
+
+namespace trantor
+{
+/**
+ * @brief One end of a pair of connections in the same process, created by
+ * TcpConnection::newLocalPair(). The data sent is appended to the inbox of
+ * the other end, which moves it to its read buffer in its loop.
+ */
+class LocalConnectionImpl : public MemoryConnection
+{
+  public:
+    explicit LocalConnectionImpl(EventLoop *loop) : MemoryConnection(loop)
+    {
+    }
+    ~LocalConnectionImpl() override;
+
+    void setPeer(const std::shared_ptr<LocalConnectionImpl> &peer)
+    {
+        peer_ = peer;
+    }
+
+    void connectEstablished() override;
+    void connectDestroyed() override;
+
+  protected:
+    size_t writeData(const char *data, size_t len) override;
+    void shutdownWrite() override;
+    void closeTransport() override;
+
+  private:
+    // Called by the peer in its loop, returns the bytes taken
+    size_t pushData(const char *data, size_t len);
+    // Called by the peer when it shuts down or closes
+    void pushEof();
+    void queueDelivery();
+    void deliver();
+
+    std::weak_ptr<LocalConnectionImpl> peer_;
+    std::mutex inboxMutex_;
+    MsgBuffer inbox_;             // @GuardedBy inboxMutex_
+    bool deliveryQueued_{false};  // @GuardedBy inboxMutex_
+    bool peerWaiting_{false};     // @GuardedBy inboxMutex_
+    bool eof_{false};             // @GuardedBy inboxMutex_
+    bool inboxClosed_{false};     // @GuardedBy inboxMutex_
+};
+
+}  // namespace trantor
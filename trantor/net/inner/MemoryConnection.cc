@@ -0,0 +1,477 @@
+/**
+ *
+ *  @file MemoryConnection.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include "MemoryConnection.h"
+#include <trantor/utils/Utilities.h>
+
+using namespace trantor;
+
+namespace
+{
+class MemoryAsyncStream : public AsyncStream
+{
+  public:
+    explicit MemoryAsyncStream(
+        std::function<bool(const char *, size_t)> callback)
+        : callback_(std::move(callback))
+    {
+    }
+    bool send(const char *data, size_t len) override
+    {
+        return callback_(data, len);
+    }
+    void close() override
+    {
+        callback_(nullptr, 0);
+        callback_ = nullptr;
+    }
+    ~MemoryAsyncStream() override
+    {
+        if (callback_)
+            callback_(nullptr, 0);
+    }
+
+  private:
+    std::function<bool(const char *, size_t)> callback_;
+};
+}  // namespace
+
+void MemoryConnection::handleClose()
+{
+    loop_->assertInLoopThread();
+    if (status_ == ConnStatus::Disconnected)
+        return;
+    status_ = ConnStatus::Disconnected;
+    closeTransport();
+    writeBufferList_.clear();
+    readDeadline_ = writeDeadline_ = 0;
+    auto guardThis = shared_from_this();
+    if (connectionCallback_)
+        connectionCallback_(guardThis);
+    if (closeCallback_)
+        closeCallback_(guardThis);
+}
+
+void MemoryConnection::handleReceived(size_t n)
+{
+    bytesReceived_ += n;
+    if (recvMsgCallback_)
+        recvMsgCallback_(shared_from_this(), &readBuffer_);
+}
+
+void MemoryConnection::sendInLoop(const char *data, size_t len)
+{
+    loop_->assertInLoopThread();
+    if (status_ != ConnStatus::Connected)
+    {
+        LOG_DEBUG << "Connection is not connected,give up sending";
+        return;
+    }
+    if (!deferredFlush_ && writeBufferList_.empty())
+    {
+        auto n = writeData(data, len);
+        bytesSent_ += n;
+        if (n == len)
+            return;
+        data += n;
+        len -= n;
+    }
+    if (writeBufferList_.empty() || writeBufferList_.back()->isFile() ||
+        writeBufferList_.back()->isStream() ||
+        writeBufferList_.back()->isAsync())
+    {
+        writeBufferList_.push_back(BufferNode::newMemBufferNode());
+    }
+    writeBufferList_.back()->append(data, len);
+    if (highWaterMarkCallback_ &&
+        writeBufferList_.back()->remainingBytes() >
+            static_cast<long long>(highWaterMarkLen_))
+    {
+        highWaterMarkCallback_(shared_from_this(),
+                               writeBufferList_.back()->remainingBytes());
+    }
+    flush();
+}
+
+void MemoryConnection::flush()
+{
+    if (!deferredFlush_)
+    {
+        writeBuffered();
+        return;
+    }
+    if (!flushQueued_)
+    {
+        flushQueued_ = true;
+        loop_->runAtEndOfIteration([thisPtr = shared_from_this()]() {
+            thisPtr->flushQueued_ = false;
+            thisPtr->writeBuffered();
+        });
+    }
+}
+
+void MemoryConnection::writeBuffered()
+{
+    if ((status_ != ConnStatus::Connected &&
+         status_ != ConnStatus::Disconnecting) ||
+        writeBufferList_.empty())
+        return;
+    while (!writeBufferList_.empty())
+    {
+        auto &nodePtr = writeBufferList_.front();
+        if (nodePtr->remainingBytes() == 0)
+        {
+            // An async node waits for its data
+            if (nodePtr->isAsync() && nodePtr->available())
+                return;
+            writeBufferList_.pop_front();
+            continue;
+        }
+        const char *data;
+        size_t len;
+        nodePtr->getData(data, len);
+        if (len == 0)
+        {
+            // The end of a stream
+            nodePtr->done();
+            continue;
+        }
+        auto n = writeData(data, len);
+        bytesSent_ += n;
+        nodePtr->retrieve(n);
+        if (n < len)
+            return;
+    }
+    writeDeadline_ = 0;
+    if (writeCompleteCallback_)
+        writeCompleteCallback_(shared_from_this());
+    if (closeOnEmpty_)
+        shutdown();
+}
+
+void MemoryConnection::send(const char *msg, size_t len)
+{
+    if (loop_->isInLoopThread())
+    {
+        sendInLoop(msg, len);
+    }
+    else
+    {
+        auto buffer = std::make_shared<std::string>(msg, len);
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this(), buffer = std::move(buffer)]() {
+                thisPtr->sendInLoop(buffer->data(), buffer->length());
+            });
+    }
+}
+
+void MemoryConnection::send(const void *msg, size_t len)
+{
+    send(static_cast<const char *>(msg), len);
+}
+
+void MemoryConnection::send(const std::string &msg)
+{
+    send(msg.data(), msg.length());
+}
+
+void MemoryConnection::send(std::string &&msg)
+{
+    if (loop_->isInLoopThread())
+    {
+        sendInLoop(msg.data(), msg.length());
+    }
+    else
+    {
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this(), msg = std::move(msg)]() {
+                thisPtr->sendInLoop(msg.data(), msg.length());
+            });
+    }
+}
+
+void MemoryConnection::send(const MsgBuffer &buffer)
+{
+    send(buffer.peek(), buffer.readableBytes());
+}
+
+void MemoryConnection::send(MsgBuffer &&buffer)
+{
+    if (loop_->isInLoopThread())
+    {
+        sendInLoop(buffer.peek(), buffer.readableBytes());
+    }
+    else
+    {
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this(), buffer = std::move(buffer)]() {
+                thisPtr->sendInLoop(buffer.peek(), buffer.readableBytes());
+            });
+    }
+}
+
+void MemoryConnection::send(const std::shared_ptr<std::string> &msgPtr)
+{
+    if (loop_->isInLoopThread())
+    {
+        sendInLoop(msgPtr->data(), msgPtr->length());
+    }
+    else
+    {
+        loop_->queueInLoop([thisPtr = shared_from_this(), msgPtr]() {
+            thisPtr->sendInLoop(msgPtr->data(), msgPtr->length());
+        });
+    }
+}
+
+void MemoryConnection::send(const std::shared_ptr<MsgBuffer> &msgPtr)
+{
+    if (loop_->isInLoopThread())
+    {
+        sendInLoop(msgPtr->peek(), msgPtr->readableBytes());
+    }
+    else
+    {
+        loop_->queueInLoop([thisPtr = shared_from_this(), msgPtr]() {
+            thisPtr->sendInLoop(msgPtr->peek(), msgPtr->readableBytes());
+        });
+    }
+}
+
+void MemoryConnection::pushNode(BufferNodePtr &&node)
+{
+    loop_->runInLoop(
+        [thisPtr = shared_from_this(), node = std::move(node)]() mutable {
+            if (thisPtr->status_ != ConnStatus::Connected)
+                return;
+            thisPtr->writeBufferList_.push_back(std::move(node));
+            thisPtr->flush();
+        });
+}
+
+void MemoryConnection::sendFile(const char *fileName,
+                                 long long offset,
+                                 long long length)
+{
+    assert(fileName);
+    auto fileNode = BufferNode::newFileBufferNode(fileName, offset, length);
+    if (!fileNode->available())
+    {
+        LOG_SYSERR << fileName << " open error";
+        return;
+    }
+    pushNode(std::move(fileNode));
+}
+
+void MemoryConnection::sendFile(const wchar_t *fileName,
+                                 long long offset,
+                                 long long length)
+{
+    assert(fileName);
+    sendFile(utils::toNativePath(fileName).c_str(), offset, length);
+}
+
+void MemoryConnection::sendStream(
+    std::function<std::size_t(char *, std::size_t)> callback)
+{
+    pushNode(BufferNode::newStreamBufferNode(std::move(callback)));
+}
+
+void MemoryConnection::sendAsyncDataInLoop(const BufferNodePtr &node,
+                                            const char *data,
+                                            size_t len)
+{
+    loop_->assertInLoopThread();
+    if (data)
+        node->append(data, len);
+    else
+        node->done();
+    if (!writeBufferList_.empty() && node == writeBufferList_.front())
+        flush();
+}
+
+AsyncStreamPtr MemoryConnection::sendAsyncStream(bool)
+{
+    auto node = BufferNode::newAsyncStreamBufferNode();
+    std::weak_ptr<MemoryConnection> weakPtr = shared_from_this();
+    auto asyncStream = std::make_unique<MemoryAsyncStream>(
+        [node, weakPtr = std::move(weakPtr)](const char *data,
+                                             size_t len) -> bool {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr || thisPtr->status_ != ConnStatus::Connected)
+            {
+                LOG_DEBUG << "Connection is not connected,give up sending";
+                return false;
+            }
+            if (thisPtr->loop_->isInLoopThread())
+            {
+                thisPtr->sendAsyncDataInLoop(node, data, len);
+                return true;
+            }
+            std::shared_ptr<std::string> buffer;
+            if (data)
+                buffer = std::make_shared<std::string>(data, len);
+            thisPtr->loop_->queueInLoop([thisPtr, node, buffer]() {
+                thisPtr->sendAsyncDataInLoop(node,
+                                             buffer ? buffer->data() : nullptr,
+                                             buffer ? buffer->length() : 0);
+            });
+            return true;
+        });
+    pushNode(BufferNodePtr(node));
+    return asyncStream;
+}
+
+uint64_t MemoryConnection::reserveSendSlot()
+{
+    return sendSlots_.reserve();
+}
+
+void MemoryConnection::fillSendSlot(uint64_t slot, std::string &&data)
+{
+    if (sendSlots_.fill(slot, std::move(data)))
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this()]() { thisPtr->flushSendSlots(); });
+}
+
+void MemoryConnection::fillSendSlot(uint64_t slot, MsgBuffer &&data)
+{
+    if (sendSlots_.fill(slot, std::move(data)))
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this()]() { thisPtr->flushSendSlots(); });
+}
+
+void MemoryConnection::flushSendSlots()
+{
+    std::vector<SendSlots::Slot> slots;
+    sendSlots_.takeFilled(slots);
+    for (auto &slot : slots)
+        sendInLoop(slot.data(), slot.size());
+}
+
+void MemoryConnection::setDeferredFlush(bool on)
+{
+    loop_->runInLoop(
+        [thisPtr = shared_from_this(), on]() { thisPtr->deferredFlush_ = on; });
+}
+
+void MemoryConnection::shutdown()
+{
+    loop_->runInLoop([thisPtr = shared_from_this()]() {
+        if (thisPtr->status_ != ConnStatus::Connected)
+            return;
+        if (!thisPtr->writeBufferList_.empty())
+        {
+            thisPtr->closeOnEmpty_ = true;
+            return;
+        }
+        thisPtr->status_ = ConnStatus::Disconnecting;
+        thisPtr->shutdownWrite();
+    });
+}
+
+void MemoryConnection::forceClose()
+{
+    loop_->runInLoop([thisPtr = shared_from_this()]() {
+        if (thisPtr->status_ == ConnStatus::Connected ||
+            thisPtr->status_ == ConnStatus::Disconnecting)
+            thisPtr->handleClose();
+    });
+}
+
+void MemoryConnection::setReadDeadline(double timeout)
+{
+    loop_->runInLoop([thisPtr = shared_from_this(), timeout]() {
+        thisPtr->setDeadlineInLoop(Deadline::Read, timeout);
+    });
+}
+
+void MemoryConnection::setWriteDeadline(double timeout)
+{
+    loop_->runInLoop([thisPtr = shared_from_this(), timeout]() {
+        thisPtr->setDeadlineInLoop(Deadline::Write, timeout);
+    });
+}
+
+void MemoryConnection::setDeadlineInLoop(Deadline kind, double timeout)
+{
+    auto &deadline = kind == Deadline::Read ? readDeadline_ : writeDeadline_;
+    // A cleared deadline leaves the connection in the wheel until its bucket
+    // expires
+    if (timeout <= 0 || status_ == ConnStatus::Disconnected ||
+        (kind == Deadline::Write && writeBufferList_.empty()))
+    {
+        deadline = 0;
+        return;
+    }
+    if (!deadlineWheel_)
+        deadlineWheel_ = DeadlineWheel::forLoop(loop_);
+    deadline = deadlineWheel_->deadlineTick(timeout);
+    scheduleDeadlineCheck(deadline);
+}
+
+void MemoryConnection::scheduleDeadlineCheck(uint64_t tick)
+{
+    // A later deadline is found when the current bucket expires
+    if (deadlineCheckTick_ != 0 && deadlineCheckTick_ <= tick)
+        return;
+    deadlineCheckTick_ = deadlineWheel_->schedule(shared_from_this(), tick);
+}
+
+void MemoryConnection::checkDeadlines(uint64_t tick)
+{
+    // Only the latest bucket the connection was put in counts
+    if (tick != deadlineCheckTick_)
+        return;
+    deadlineCheckTick_ = 0;
+    if (status_ != ConnStatus::Connected)
+        return;
+    if (writeDeadline_ != 0 && writeDeadline_ <= tick)
+    {
+        writeDeadline_ = 0;
+        if (!writeBufferList_.empty())
+            onDeadline(Deadline::Write);
+    }
+    if (readDeadline_ != 0 && readDeadline_ <= tick &&
+        status_ == ConnStatus::Connected)
+    {
+        readDeadline_ = 0;
+        onDeadline(Deadline::Read);
+    }
+    // The callbacks may have set the deadlines again
+    if (status_ != ConnStatus::Connected)
+        return;
+    if (readDeadline_ != 0)
+        scheduleDeadlineCheck(readDeadline_);
+    if (writeDeadline_ != 0)
+        scheduleDeadlineCheck(writeDeadline_);
+}
+
+void MemoryConnection::onDeadline(Deadline deadline)
+{
+    if (deadlineCallback_)
+    {
+        deadlineCallback_(shared_from_this(), deadline);
+        return;
+    }
+    LOG_DEBUG << (deadline == Deadline::Read ? "read" : "write")
+              << " deadline expired, closing the connection";
+    forceClose();
+}
+
+void MemoryConnection::startEncryption(
+    TLSPolicyPtr,
+    bool,
+    std::function<void(const TcpConnectionPtr &)>)
+{
+    LOG_ERROR << "TLS isn't supported by in-memory connections";
+}
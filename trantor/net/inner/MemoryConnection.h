@@ -0,0 +1,202 @@
+/**
+ *
+ *  @file MemoryConnection.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/TcpConnection.h>
+#include <trantor/net/inner/BufferNode.h>
+#include <trantor/net/inner/SendSlots.h>
+#include <trantor/net/inner/DeadlineWheel.h>
+#include <list>
+#include <memory>
+#include <string>
+
+namespace trantor
+{
+/**
+ * @brief The common part of the connections which pass data through memory
+ * instead of sockets. The subclasses implement the transport: they write the
+ * data to it, append the data received to readBuffer_ and call
+ * handleReceived(), and call handleClose() when the peer closes the
+ * connection. TLS and idle timeouts aren't supported.
+ */
+class MemoryConnection : public TcpConnection,
+                         public NonCopyable,
+                         public DeadlineWheel::Connection,
+                         public std::enable_shared_from_this<MemoryConnection>
+{
+  public:
+    explicit MemoryConnection(EventLoop *loop) : loop_(loop)
+    {
+    }
+
+    void send(const char *msg, size_t len) override;
+    void send(const void *msg, size_t len) override;
+    void send(const std::string &msg) override;
+    void send(std::string &&msg) override;
+    void send(const MsgBuffer &buffer) override;
+    void send(MsgBuffer &&buffer) override;
+    void send(const std::shared_ptr<std::string> &msgPtr) override;
+    void send(const std::shared_ptr<MsgBuffer> &msgPtr) override;
+    void sendFile(const char *fileName,
+                  long long offset,
+                  long long length) override;
+    void sendFile(const wchar_t *fileName,
+                  long long offset,
+                  long long length) override;
+    void sendStream(
+        std::function<std::size_t(char *, std::size_t)> callback) override;
+    AsyncStreamPtr sendAsyncStream(bool disableKickoff) override;
+    uint64_t reserveSendSlot() override;
+    void fillSendSlot(uint64_t slot, std::string &&data) override;
+    void fillSendSlot(uint64_t slot, MsgBuffer &&data) override;
+
+    const InetAddress &localAddr() const override
+    {
+        return address_;
+    }
+    const InetAddress &peerAddr() const override
+    {
+        return address_;
+    }
+    bool connected() const override
+    {
+        return status_ == ConnStatus::Connected;
+    }
+    bool disconnected() const override
+    {
+        return status_ == ConnStatus::Disconnected;
+    }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback &cb,
+                                  size_t markLen) override
+    {
+        highWaterMarkCallback_ = cb;
+        highWaterMarkLen_ = markLen;
+    }
+    void setTcpNoDelay(bool) override
+    {
+    }
+    void setDeferredFlush(bool on) override;
+    void shutdown() override;
+    void forceClose() override;
+    EventLoop *getLoop() override
+    {
+        return loop_;
+    }
+    std::string applicationProtocol() const override
+    {
+        return "";
+    }
+    // Idle connections aren't kicked off
+    void keepAlive() override
+    {
+    }
+    bool isKeepAlive() override
+    {
+        return true;
+    }
+    void setReadDeadline(double timeout) override;
+    void setWriteDeadline(double timeout) override;
+    size_t bytesSent() const override
+    {
+        return bytesSent_;
+    }
+    size_t bytesReceived() const override
+    {
+        return bytesReceived_;
+    }
+    bool isSSLConnection() const override
+    {
+        return false;
+    }
+    MsgBuffer *getRecvBuffer() override
+    {
+        return &readBuffer_;
+    }
+    CertificatePtr peerCertificate() const override
+    {
+        return nullptr;
+    }
+    std::string sniName() const override
+    {
+        return "";
+    }
+    void startEncryption(
+        TLSPolicyPtr policy,
+        bool isServer,
+        std::function<void(const TcpConnectionPtr &)> upgradeCallback) override;
+    void enableKickingOff(size_t,
+                          const std::shared_ptr<TimingWheel> &) override
+    {
+    }
+
+  protected:
+    enum class ConnStatus
+    {
+        Disconnected,
+        Connecting,
+        Connected,
+        Disconnecting
+    };
+
+    // Write as much data as the transport takes now. If it takes less than
+    // len, writeBuffered() must be called when it has room again.
+    virtual size_t writeData(const char *data, size_t len) = 0;
+    // Shut the writing direction down, after the data written
+    virtual void shutdownWrite() = 0;
+    // Stop the transport, the connection is closed
+    virtual void closeTransport() = 0;
+
+    // Write the buffered data until the transport is full
+    void writeBuffered();
+    // Called after n bytes are appended to readBuffer_
+    void handleReceived(size_t n);
+    void handleClose();
+
+    EventLoop *loop_;
+    ConnStatus status_{ConnStatus::Connecting};
+    MsgBuffer readBuffer_;
+
+  private:
+    void sendInLoop(const char *data, size_t len);
+    void pushNode(BufferNodePtr &&node);
+    void sendAsyncDataInLoop(const BufferNodePtr &node,
+                             const char *data,
+                             size_t len);
+    // Write the buffered data now, or at the end of the iteration of the
+    // loop in the deferred flush mode
+    void flush();
+    void flushSendSlots();
+    // Deadlines are ticks of the deadline wheel, 0 if not set, like in
+    // TcpConnectionImpl
+    void setDeadlineInLoop(Deadline kind, double timeout);
+    void scheduleDeadlineCheck(uint64_t tick);
+    void checkDeadlines(uint64_t tick) override;
+    void onDeadline(Deadline deadline);
+
+    InetAddress address_;
+    std::list<BufferNodePtr> writeBufferList_;
+    size_t highWaterMarkLen_{0};
+    size_t bytesSent_{0};
+    size_t bytesReceived_{0};
+    bool closeOnEmpty_{false};
+    bool deferredFlush_{false};
+    bool flushQueued_{false};
+    std::shared_ptr<DeadlineWheel> deadlineWheel_;
+    uint64_t readDeadline_{0};
+    uint64_t writeDeadline_{0};
+    // The tick of the bucket of the wheel the connection is in, 0 if none
+    uint64_t deadlineCheckTick_{0};
+    SendSlots sendSlots_;
+};
+
+}  // namespace trantor
@@ -9,6 +9,7 @@
 #include <trantor/net/Resolver.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/utils/ConcurrentTaskQueue.h>
+#include <trantor/utils/Utilities.h>
 #include <memory>
 #include <vector>
 #include <thread>
@@ -40,12 +41,14 @@ class NormalResolver : public Resolver,
 
   private:
     static std::unordered_map<std::string,
-                              std::pair<trantor::InetAddress, trantor::Date>>&
+                              std::pair<trantor::InetAddress, trantor::Date>,
+                              utils::StringHash>&
     globalCache()
     {
         static std::unordered_map<
             std::string,
-            std::pair<trantor::InetAddress, trantor::Date>>
+            std::pair<trantor::InetAddress, trantor::Date>,
+            utils::StringHash>
             dnsCache_;
         return dnsCache_;
     }
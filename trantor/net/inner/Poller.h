@@ -16,6 +16,8 @@
 #include "NonCopyable.h"
 #include "EventLoop.h"
 
+#include <algorithm>
+#include <climits>
 #include <memory>
 #include <map>
 
@@ -37,6 +39,20 @@ class Poller : NonCopyable
         ownerLoop_->assertInLoopThread();
     }
     virtual void poll(int timeoutMs, ChannelList *activeChannels) = 0;
+    /**
+     * @brief Poll with a timeout in microseconds, or without a timeout if it
+     * is negative. The timeout is rounded up to milliseconds unless the
+     * poller supports a finer one.
+     */
+    virtual void pollUs(int64_t timeoutUs, ChannelList *activeChannels)
+    {
+        int timeoutMs = -1;
+        if (timeoutUs >= 0)
+            timeoutMs = static_cast<int>(
+                (std::min)((timeoutUs + 999) / 1000,
+                           static_cast<int64_t>(INT_MAX)));
+        poll(timeoutMs, activeChannels);
+    }
     virtual void updateChannel(Channel *channel) = 0;
     virtual void removeChannel(Channel *channel) = 0;
 #ifdef _WIN32
@@ -0,0 +1,128 @@
+/**
+ *
+ *  @file SendSlots.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/Logger.h>
+#include <trantor/utils/NonCopyable.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trantor
+{
+/**
+ * @brief The slots reserved by TcpConnection::reserveSendSlot() and not sent
+ * yet. They can be reserved and filled in any thread, the connections send
+ * them in their loop.
+ */
+class SendSlots : public NonCopyable
+{
+  public:
+    struct Slot
+    {
+        std::string string;
+        std::unique_ptr<MsgBuffer> buffer;
+        bool filled{false};
+
+        const char *data() const
+        {
+            return buffer ? buffer->peek() : string.data();
+        }
+        size_t size() const
+        {
+            return buffer ? buffer->readableBytes() : string.size();
+        }
+    };
+
+    uint64_t reserve()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.emplace_back();
+        return first_ + slots_.size() - 1;
+    }
+
+    /**
+     * @brief Fill a slot.
+     *
+     * @return true if the first slot not sent is filled and no flush is
+     * queued yet, then the caller must queue a call to takeFilled() in the
+     * loop of the connection.
+     */
+    bool fill(uint64_t slot, std::string &&data)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto emptySlot = findEmpty(slot);
+        if (!emptySlot)
+            return false;
+        emptySlot->string = std::move(data);
+        emptySlot->filled = true;
+        return needsFlush();
+    }
+    bool fill(uint64_t slot, MsgBuffer &&data)
+    {
+        auto buffer = std::make_unique<MsgBuffer>(std::move(data));
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto emptySlot = findEmpty(slot);
+        if (!emptySlot)
+            return false;
+        emptySlot->buffer = std::move(buffer);
+        emptySlot->filled = true;
+        return needsFlush();
+    }
+
+    /**
+     * @brief Take the filled slots following the last slot sent.
+     */
+    void takeFilled(std::vector<Slot> &slots)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushQueued_ = false;
+        while (!slots_.empty() && slots_.front().filled)
+        {
+            slots.push_back(std::move(slots_.front()));
+            slots_.pop_front();
+            ++first_;
+        }
+    }
+
+  private:
+    Slot *findEmpty(uint64_t slot)
+    {
+        if (slot < first_ || slot - first_ >= slots_.size() ||
+            slots_[slot - first_].filled)
+        {
+            LOG_ERROR << "The send slot " << slot
+                      << " isn't reserved or is already filled";
+            return nullptr;
+        }
+        return &slots_[slot - first_];
+    }
+    bool needsFlush()
+    {
+        if (flushQueued_ || !slots_.front().filled)
+            return false;
+        flushQueued_ = true;
+        return true;
+    }
+
+    std::mutex mutex_;
+    // The slots from the first one not sent yet
+    std::deque<Slot> slots_;
+    uint64_t first_{0};
+    bool flushQueued_{false};
+};
+
+}  // namespace trantor
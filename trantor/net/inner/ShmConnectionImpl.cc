@@ -0,0 +1,459 @@
+/**
+ *
+ *  @file ShmConnectionImpl.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include "ShmConnectionImpl.h"
+#include <trantor/net/Channel.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+
+using namespace trantor;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "The rings need lock-free atomics to be shared by processes");
+
+namespace
+{
+// The headers of the two rings are in the first page, followed by the data of
+// the ring from the server to the client, then by the one from the client to
+// the server
+constexpr size_t kHeadersSize = 4096;
+constexpr size_t kClientHeaderOffset = 256;
+static_assert(sizeof(ShmRingHeader) <= kClientHeaderOffset,
+              "The ring headers don't fit");
+
+// Bounds the size of the memory a client maps
+constexpr uint64_t kMaxRingCapacity = uint64_t(1) << 30;
+
+constexpr uint32_t kHandshakeMagic = 0x74736d31;
+constexpr uint32_t kHandshakeVersion = 1;
+struct Handshake
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ringCapacity;
+};
+
+// Close all the fds received with a rejected handshake
+void closeReceivedFds(msghdr &msg)
+{
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+            cmsg->cmsg_len < CMSG_LEN(0))
+            continue;
+        const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; ++i)
+        {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+            ::close(fd);
+        }
+    }
+}
+
+ShmRingHeader *ringHeader(void *memory, bool toClient)
+{
+    return reinterpret_cast<ShmRingHeader *>(static_cast<char *>(memory) +
+                                             (toClient ? 0
+                                                       : kClientHeaderOffset));
+}
+
+char *ringData(void *memory, size_t ringCapacity, bool toClient)
+{
+    return static_cast<char *>(memory) + kHeadersSize +
+           (toClient ? 0 : ringCapacity);
+}
+}  // namespace
+
+ssize_t ShmRing::write(const char *data, size_t len)
+{
+    auto head = header_->head.load(std::memory_order_relaxed);
+    auto tail = header_->tail.load(std::memory_order_acquire);
+    // The other process can write anything to the header
+    if (head - tail > mask_ + 1)
+        return -1;
+    size_t n = (std::min)(len, mask_ + 1 - static_cast<size_t>(head - tail));
+    if (n == 0)
+        return 0;
+    size_t offset = static_cast<size_t>(head) & mask_;
+    size_t first = (std::min)(n, mask_ + 1 - offset);
+    memcpy(data_ + offset, data, first);
+    memcpy(data_, data + first, n - first);
+    // Sequentially consistent, so that the consumer can't miss the data and
+    // the producer can't miss consumerWaiting
+    header_->head.store(head + n, std::memory_order_seq_cst);
+    return static_cast<ssize_t>(n);
+}
+
+ssize_t ShmRing::read(MsgBuffer &buffer)
+{
+    auto tail = header_->tail.load(std::memory_order_relaxed);
+    auto head = header_->head.load(std::memory_order_acquire);
+    if (head - tail > mask_ + 1)
+        return -1;
+    size_t n = static_cast<size_t>(head - tail);
+    if (n == 0)
+        return 0;
+    size_t offset = static_cast<size_t>(tail) & mask_;
+    size_t first = (std::min)(n, mask_ + 1 - offset);
+    buffer.append(data_ + offset, first);
+    buffer.append(data_, n - first);
+    header_->tail.store(tail + n, std::memory_order_seq_cst);
+    return static_cast<ssize_t>(n);
+}
+
+size_t ShmConnectionImpl::sharedMemorySize(size_t ringCapacity)
+{
+    return kHeadersSize + 2 * ringCapacity;
+}
+
+bool ShmConnectionImpl::createSharedMemory(size_t ringCapacity,
+                                           int &memfd,
+                                           void *&memory)
+{
+    memfd = ::memfd_create("trantor-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0)
+    {
+        LOG_SYSERR << "memfd_create";
+        return false;
+    }
+    // The size is sealed, so that the client can't make the mapping of the
+    // server fault by shrinking the memory
+    if (::ftruncate(memfd, sharedMemorySize(ringCapacity)) != 0 ||
+        ::fcntl(memfd,
+                F_ADD_SEALS,
+                F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+    {
+        LOG_SYSERR << "Can't size the shared memory";
+        ::close(memfd);
+        return false;
+    }
+    memory = mapSharedMemory(memfd, ringCapacity);
+    if (!memory)
+    {
+        ::close(memfd);
+        return false;
+    }
+    for (bool toClient : {true, false})
+    {
+        auto header = new (ringHeader(memory, toClient)) ShmRingHeader;
+        header->head.store(0);
+        header->tail.store(0);
+        // Both ends wait for data until they write
+        header->consumerWaiting.store(1);
+        header->producerWaiting.store(0);
+    }
+    return true;
+}
+
+void *ShmConnectionImpl::mapSharedMemory(int memfd, size_t ringCapacity)
+{
+    // The memory received from the server must be large enough, and must not
+    // shrink once mapped
+    struct stat st;
+    if (::fstat(memfd, &st) != 0 ||
+        static_cast<uint64_t>(st.st_size) < sharedMemorySize(ringCapacity) ||
+        (::fcntl(memfd, F_GET_SEALS) & F_SEAL_SHRINK) == 0)
+    {
+        LOG_ERROR << "Invalid memory of a shared memory connection";
+        return nullptr;
+    }
+    void *memory = ::mmap(nullptr,
+                          sharedMemorySize(ringCapacity),
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          memfd,
+                          0);
+    if (memory == MAP_FAILED)
+    {
+        LOG_SYSERR << "mmap";
+        return nullptr;
+    }
+    return memory;
+}
+
+bool ShmConnectionImpl::sendHandshake(int socketfd,
+                                      size_t ringCapacity,
+                                      const int (&fds)[3])
+{
+    Handshake handshake{kHandshakeMagic, kHandshakeVersion, ringCapacity};
+    iovec iov{&handshake, sizeof(handshake)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    // The socket buffer of a new connection is empty, so it can't be full
+    if (::sendmsg(socketfd, &msg, MSG_NOSIGNAL) != sizeof(handshake))
+    {
+        LOG_SYSERR << "sendmsg";
+        return false;
+    }
+    return true;
+}
+
+int ShmConnectionImpl::receiveHandshake(int socketfd,
+                                        size_t &ringCapacity,
+                                        int (&fds)[3])
+{
+    Handshake handshake;
+    iovec iov{&handshake, sizeof(handshake)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    auto n = ::recvmsg(socketfd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0)
+    {
+        if (errno == EAGAIN)
+            return 0;
+        LOG_SYSERR << "recvmsg";
+        return -1;
+    }
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    // A truncated control message lost some of the fds
+    if (n != sizeof(handshake) || (msg.msg_flags & MSG_CTRUNC) || !cmsg ||
+        cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(fds)) || CMSG_NXTHDR(&msg, cmsg))
+    {
+        LOG_ERROR << "Invalid handshake of a shared memory connection";
+        closeReceivedFds(msg);
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    if (handshake.magic != kHandshakeMagic ||
+        handshake.version != kHandshakeVersion ||
+        handshake.ringCapacity == 0 ||
+        handshake.ringCapacity > kMaxRingCapacity ||
+        (handshake.ringCapacity & (handshake.ringCapacity - 1)) != 0)
+    {
+        LOG_ERROR << "Invalid handshake of a shared memory connection";
+        for (int fd : fds)
+            ::close(fd);
+        return -1;
+    }
+    ringCapacity = static_cast<size_t>(handshake.ringCapacity);
+    return 1;
+}
+
+ShmConnectionImpl::ShmConnectionImpl(EventLoop *loop,
+                                     int socketfd,
+                                     void *memory,
+                                     size_t ringCapacity,
+                                     int eventFd,
+                                     int peerEventFd,
+                                     bool isServer)
+    : MemoryConnection(loop),
+      socketFd_(socketfd),
+      eventFd_(eventFd),
+      peerEventFd_(peerEventFd),
+      memory_(memory),
+      memorySize_(sharedMemorySize(ringCapacity)),
+      readRing_(ringHeader(memory, !isServer),
+                ringData(memory, ringCapacity, !isServer),
+                ringCapacity),
+      writeRing_(ringHeader(memory, isServer),
+                 ringData(memory, ringCapacity, isServer),
+                 ringCapacity),
+      socketChannelPtr_(new Channel(loop, socketfd)),
+      eventChannelPtr_(new Channel(loop, eventFd))
+{
+    socketChannelPtr_->setReadCallback([this]() { handleSocketRead(); });
+    socketChannelPtr_->setCloseCallback([this]() {
+        readRing();
+        handleClose();
+    });
+    eventChannelPtr_->setReadCallback([this]() { handleNotification(); });
+}
+
+ShmConnectionImpl::~ShmConnectionImpl()
+{
+    ::munmap(memory_, memorySize_);
+    ::close(socketFd_);
+    ::close(eventFd_);
+    ::close(peerEventFd_);
+}
+
+void ShmConnectionImpl::connectEstablished()
+{
+    auto thisPtr =
+        std::static_pointer_cast<ShmConnectionImpl>(shared_from_this());
+    loop_->runInLoop([thisPtr]() {
+        assert(thisPtr->status_ == ConnStatus::Connecting);
+        thisPtr->socketChannelPtr_->tie(thisPtr);
+        thisPtr->eventChannelPtr_->tie(thisPtr);
+        thisPtr->socketChannelPtr_->enableReading();
+        thisPtr->eventChannelPtr_->enableReading();
+        thisPtr->status_ = ConnStatus::Connected;
+        if (thisPtr->connectionCallback_)
+            thisPtr->connectionCallback_(thisPtr);
+        // The peer may have written data before
+        thisPtr->readRing();
+    });
+}
+
+void ShmConnectionImpl::connectDestroyed()
+{
+    loop_->assertInLoopThread();
+    if (status_ == ConnStatus::Connected)
+    {
+        status_ = ConnStatus::Disconnected;
+        socketChannelPtr_->disableAll();
+        eventChannelPtr_->disableAll();
+        connectionCallback_(shared_from_this());
+    }
+    socketChannelPtr_->remove();
+    eventChannelPtr_->remove();
+}
+
+void ShmConnectionImpl::handleNotification()
+{
+    uint64_t count;
+    if (::read(eventFd_, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        LOG_SYSERR << "read eventfd";
+    readRing();
+    writeBuffered();
+}
+
+void ShmConnectionImpl::handleSocketRead()
+{
+    char buffer[64];
+    auto n = ::recv(socketFd_, buffer, sizeof(buffer), 0);
+    if (n > 0 || (n < 0 && errno == EAGAIN))
+        return;
+    // The peer shut the connection down or exited, after writing its data
+    readRing();
+    handleClose();
+}
+
+void ShmConnectionImpl::readRing()
+{
+    if (status_ != ConnStatus::Connected &&
+        status_ != ConnStatus::Disconnecting)
+        return;
+    auto header = readRing_.header();
+    size_t total = 0;
+    while (true)
+    {
+        auto n = readRing_.read(readBuffer_);
+        if (n < 0)
+        {
+            handleProtocolError();
+            break;
+        }
+        if (n == 0)
+        {
+            header->consumerWaiting.store(1);
+            // The producer may have written before it could see the flag
+            if (readRing_.readableBytes() == 0)
+                break;
+            header->consumerWaiting.store(0);
+            continue;
+        }
+        total += static_cast<size_t>(n);
+        if (header->producerWaiting.load() &&
+            header->producerWaiting.exchange(0))
+            notifyPeer();
+        if (total >= memorySize_)
+        {
+            // Let the other events be handled, the data left is read in this
+            // iteration of the loop
+            std::weak_ptr<ShmConnectionImpl> weakPtr =
+                std::static_pointer_cast<ShmConnectionImpl>(shared_from_this());
+            loop_->queueInLoop([weakPtr]() {
+                auto thisPtr = weakPtr.lock();
+                if (thisPtr)
+                    thisPtr->readRing();
+            });
+            break;
+        }
+    }
+    if (total > 0)
+        handleReceived(total);
+}
+
+void ShmConnectionImpl::handleProtocolError()
+{
+    if (protocolError_)
+        return;
+    protocolError_ = true;
+    LOG_ERROR << "The peer of a shared memory connection corrupted a ring";
+    // Not closed right away, the callers of writeData() use the write
+    // buffers after it returns
+    std::weak_ptr<ShmConnectionImpl> weakPtr =
+        std::static_pointer_cast<ShmConnectionImpl>(shared_from_this());
+    loop_->queueInLoop([weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (thisPtr)
+            thisPtr->handleClose();
+    });
+}
+
+void ShmConnectionImpl::notifyPeer()
+{
+    uint64_t one = 1;
+    if (::write(peerEventFd_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        LOG_SYSERR << "write eventfd";
+}
+
+size_t ShmConnectionImpl::writeData(const char *data, size_t len)
+{
+    if (protocolError_)
+        return 0;
+    auto header = writeRing_.header();
+    size_t total = 0;
+    while (true)
+    {
+        auto n = writeRing_.write(data + total, len - total);
+        if (n < 0)
+        {
+            handleProtocolError();
+            return total;
+        }
+        total += static_cast<size_t>(n);
+        if (n > 0 && header->consumerWaiting.load() &&
+            header->consumerWaiting.exchange(0))
+            notifyPeer();
+        if (total == len)
+            return total;
+        header->producerWaiting.store(1);
+        // The consumer may have read before it could see the flag
+        if (writeRing_.writableBytes() == 0)
+            return total;
+        header->producerWaiting.store(0);
+    }
+}
+
+void ShmConnectionImpl::shutdownWrite()
+{
+    ::shutdown(socketFd_, SHUT_WR);
+}
+
+void ShmConnectionImpl::closeTransport()
+{
+    socketChannelPtr_->disableAll();
+    eventChannelPtr_->disableAll();
+}
@@ -0,0 +1,152 @@
+/**
+ *
+ *  @file ShmConnectionImpl.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/inner/MemoryConnection.h>
+#include <sys/types.h>
+#include <atomic>
+#include <memory>
+
+namespace trantor
+{
+class Channel;
+
+// The control block of a ring in the shared memory. The producer and the
+// consumer are usually in different processes.
+struct ShmRingHeader
+{
+    // Bytes written by the producer
+    alignas(64) std::atomic<uint64_t> head;
+    // Bytes read by the consumer
+    alignas(64) std::atomic<uint64_t> tail;
+    // Set by the consumer before it waits for data, and by the producer
+    // before it waits for room. The other side notifies it when it clears
+    // the flag.
+    alignas(64) std::atomic<uint32_t> consumerWaiting;
+    std::atomic<uint32_t> producerWaiting;
+};
+
+/**
+ * @brief A single producer single consumer ring of bytes in shared memory.
+ */
+class ShmRing
+{
+  public:
+    ShmRing(ShmRingHeader *header, char *data, size_t capacity)
+        : header_(header), data_(data), mask_(capacity - 1)
+    {
+    }
+    // Called by the producer, returns the bytes written, or -1 if the header
+    // is corrupted
+    ssize_t write(const char *data, size_t len);
+    // Called by the consumer, returns the bytes appended to the buffer, or -1
+    // if the header is corrupted
+    ssize_t read(MsgBuffer &buffer);
+    size_t readableBytes() const
+    {
+        return static_cast<size_t>(
+            header_->head.load(std::memory_order_seq_cst) -
+            header_->tail.load(std::memory_order_seq_cst));
+    }
+    size_t writableBytes() const
+    {
+        return mask_ + 1 - readableBytes();
+    }
+    ShmRingHeader *header() const
+    {
+        return header_;
+    }
+
+  private:
+    ShmRingHeader *header_;
+    char *data_;
+    size_t mask_;
+};
+
+/**
+ * @brief This class represents a connection between two processes through
+ * two rings in shared memory, one for each direction. An eventfd of each end
+ * wakes its event loop up when the other end writes data or makes room while
+ * it waits. The Unix socket the memory was set up with stays open, it tells
+ * each end when the other one shuts the connection down or exits.
+ */
+class ShmConnectionImpl : public MemoryConnection
+{
+  public:
+    /**
+     * @brief Construct a connection, which owns the memory and the file
+     * descriptors.
+     *
+     * @param memory The memory shared with the other end, of
+     * sharedMemorySize(ringCapacity) bytes.
+     * @param ringCapacity A power of two.
+     * @param isServer Which ring is read and which one is written.
+     */
+    ShmConnectionImpl(EventLoop *loop,
+                      int socketfd,
+                      void *memory,
+                      size_t ringCapacity,
+                      int eventFd,
+                      int peerEventFd,
+                      bool isServer);
+    ~ShmConnectionImpl() override;
+
+    static size_t sharedMemorySize(size_t ringCapacity);
+    // Create the shared memory of a connection, with both rings empty
+    static bool createSharedMemory(size_t ringCapacity,
+                                   int &memfd,
+                                   void *&memory);
+    static void *mapSharedMemory(int memfd, size_t ringCapacity);
+
+    // The server sends the capacity of the rings with the memfd, its eventfd
+    // and the eventfd of the client, in this order
+    static bool sendHandshake(int socketfd,
+                              size_t ringCapacity,
+                              const int (&fds)[3]);
+    // Returns 1 when the handshake is received, 0 if it isn't there yet, -1
+    // on error
+    static int receiveHandshake(int socketfd,
+                                size_t &ringCapacity,
+                                int (&fds)[3]);
+
+    void connectEstablished() override;
+    void connectDestroyed() override;
+
+  protected:
+    size_t writeData(const char *data, size_t len) override;
+    void shutdownWrite() override;
+    void closeTransport() override;
+
+  private:
+    void handleNotification();
+    void handleSocketRead();
+    void readRing();
+    // Close the connection when the peer breaks the protocol
+    void handleProtocolError();
+    void notifyPeer();
+
+    int socketFd_;
+    int eventFd_;
+    int peerEventFd_;
+    void *memory_;
+    size_t memorySize_;
+    ShmRing readRing_;
+    ShmRing writeRing_;
+    std::unique_ptr<Channel> socketChannelPtr_;
+    std::unique_ptr<Channel> eventChannelPtr_;
+    bool protocolError_{false};
+};
+
+using ShmConnectionImplPtr = std::shared_ptr<ShmConnectionImpl>;
+
+}  // namespace trantor
@@ -15,13 +15,20 @@
 #include "TcpConnectionImpl.h"
 #include "Socket.h"
 #include "Channel.h"
+#include "DeadlineWheel.h"
 #include <trantor/utils/Utilities.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
 #ifdef __linux__
 #include <sys/sendfile.h>
 #include <poll.h>
 #endif
 #include <sys/types.h>
 #ifndef _WIN32
+#include <sys/uio.h>
+#include <climits>
 #include <unistd.h>
 #endif
 
@@ -201,6 +208,103 @@ void TcpConnectionImpl::extendLife()
         }
     }
 }
+void TcpConnectionImpl::setReadDeadline(double timeout)
+{
+    if (loop_->isInLoopThread())
+    {
+        setDeadlineInLoop(Deadline::Read, timeout);
+        return;
+    }
+    auto thisPtr = shared_from_this();
+    loop_->queueInLoop([thisPtr, timeout]() {
+        thisPtr->setDeadlineInLoop(Deadline::Read, timeout);
+    });
+}
+void TcpConnectionImpl::setWriteDeadline(double timeout)
+{
+    // Queued like send() so that it applies to the data sent before
+    if (loop_->isInLoopThread())
+    {
+        setDeadlineInLoop(Deadline::Write, timeout);
+        return;
+    }
+    auto thisPtr = shared_from_this();
+    loop_->queueInLoop([thisPtr, timeout]() {
+        thisPtr->setDeadlineInLoop(Deadline::Write, timeout);
+    });
+}
+void TcpConnectionImpl::setDeadlineInLoop(Deadline kind, double timeout)
+{
+    loop_->assertInLoopThread();
+    auto &deadline = kind == Deadline::Read ? readDeadline_ : writeDeadline_;
+    // A cleared deadline leaves the connection in the wheel until its bucket
+    // expires
+    if (timeout <= 0 || status_ == ConnStatus::Disconnected ||
+        (kind == Deadline::Write && !hasDataToWrite()))
+    {
+        deadline = 0;
+        return;
+    }
+    if (!deadlineWheel_)
+        deadlineWheel_ = DeadlineWheel::forLoop(loop_);
+    deadline = deadlineWheel_->deadlineTick(timeout);
+    scheduleDeadlineCheck(deadline);
+}
+void TcpConnectionImpl::scheduleDeadlineCheck(uint64_t tick)
+{
+    // A later deadline is found when the current bucket expires
+    if (deadlineCheckTick_ != 0 && deadlineCheckTick_ <= tick)
+        return;
+    deadlineCheckTick_ = deadlineWheel_->schedule(shared_from_this(), tick);
+}
+void TcpConnectionImpl::checkDeadlines(uint64_t tick)
+{
+    // The connection may be in the wheel several times if its deadline was
+    // moved earlier, only the latest bucket counts
+    if (tick != deadlineCheckTick_)
+        return;
+    deadlineCheckTick_ = 0;
+    if (status_ != ConnStatus::Connected)
+        return;
+    if (writeDeadline_ != 0 && writeDeadline_ <= tick)
+    {
+        writeDeadline_ = 0;
+        if (hasDataToWrite())
+            onDeadline(Deadline::Write);
+    }
+    if (readDeadline_ != 0 && readDeadline_ <= tick &&
+        status_ == ConnStatus::Connected)
+    {
+        readDeadline_ = 0;
+        onDeadline(Deadline::Read);
+    }
+    // The callbacks may have set the deadlines again
+    if (status_ != ConnStatus::Connected)
+        return;
+    if (readDeadline_ != 0)
+        scheduleDeadlineCheck(readDeadline_);
+    if (writeDeadline_ != 0)
+        scheduleDeadlineCheck(writeDeadline_);
+}
+void TcpConnectionImpl::onDeadline(Deadline deadline)
+{
+    if (deadlineCallback_)
+    {
+        deadlineCallback_(shared_from_this(), deadline);
+        return;
+    }
+    LOG_DEBUG << "[" << name_ << "] "
+              << (deadline == Deadline::Read ? "read" : "write")
+              << " deadline expired, closing the connection to "
+              << peerAddr_.toIpPort();
+    forceClose();
+}
+bool TcpConnectionImpl::hasDataToWrite() const
+{
+    return !writeBufferList_.empty() ||
+           (tlsProviderPtr_ &&
+            tlsProviderPtr_->getBufferedData().readableBytes() > 0);
+}
 void TcpConnectionImpl::writeCallback()
 {
     loop_->assertInLoopThread();
@@ -244,6 +348,7 @@ void TcpConnectionImpl::writeCallback()
             tlsProviderPtr_->getBufferedData().readableBytes() == 0)
         {
             ioChannelPtr_->disableWriting();
+            writeDeadline_ = 0;
             if (closeOnEmpty_)
             {
                 shutdown();
@@ -317,6 +422,41 @@ void TcpConnectionImpl::setTcpNoDelay(bool on)
 {
     socketPtr_->setTcpNoDelay(on);
 }
+void TcpConnectionImpl::setDeferredFlush(bool on)
+{
+    loop_->runInLoop(
+        [thisPtr = shared_from_this(), on]() { thisPtr->deferredFlush_ = on; });
+}
+void TcpConnectionImpl::flushDeferredData()
+{
+    loop_->assertInLoopThread();
+    flushQueued_ = false;
+    // When writing is enabled, the write callback sends the data once the
+    // socket is writable
+    if (ioChannelPtr_->isWriting() ||
+        (status_ != ConnStatus::Connected &&
+         status_ != ConnStatus::Disconnecting))
+        return;
+    while (!writeBufferList_.empty())
+    {
+        auto &nodePtr = writeBufferList_.front();
+        if (nodePtr->remainingBytes() == 0)
+        {
+            // An async node waits for its data
+            if (nodePtr->isAsync() && nodePtr->available())
+                return;
+            writeBufferList_.pop_front();
+        }
+        else
+        {
+            auto n = sendNodeInLoop(nodePtr);
+            if (nodePtr->remainingBytes() > 0 || n < 0)
+                return;
+        }
+    }
+    if (closeOnEmpty_)
+        shutdown();
+}
 void TcpConnectionImpl::connectDestroyed()
 {
     loop_->assertInLoopThread();
@@ -378,6 +518,89 @@ void TcpConnectionImpl::forceClose()
         }
     });
 }
+
+namespace
+{
+// The connections of one event loop being closed by closeConnections()
+struct LoopClose
+{
+    EventLoop *loop;
+    std::vector<TcpConnectionPtr> connections;
+    std::function<void()> finish;
+    std::chrono::steady_clock::time_point deadline;
+    TimerId timerId{0};
+
+    void forceClose()
+    {
+        for (auto &conn : connections)
+            conn->forceClose();
+        connections.clear();
+        finish();
+    }
+    // Called periodically during the grace time
+    void check()
+    {
+        connections.erase(std::remove_if(connections.begin(),
+                                         connections.end(),
+                                         [](const TcpConnectionPtr &conn) {
+                                             return conn->disconnected();
+                                         }),
+                          connections.end());
+        if (!connections.empty() &&
+            std::chrono::steady_clock::now() < deadline)
+            return;
+        loop->invalidateTimer(timerId);
+        forceClose();
+    }
+};
+}  // namespace
+
+void TcpConnection::closeConnections(
+    const std::vector<TcpConnectionPtr> &connections,
+    double graceTime,
+    std::function<void()> done)
+{
+    std::unordered_map<EventLoop *, std::vector<TcpConnectionPtr>> loops;
+    for (auto &conn : connections)
+        loops[conn->getLoop()].push_back(conn);
+    if (loops.empty())
+    {
+        if (done)
+            done();
+        return;
+    }
+    auto loopsLeft = std::make_shared<std::atomic<size_t>>(loops.size());
+    auto sharedDone =
+        std::make_shared<std::function<void()>>(std::move(done));
+    for (auto &item : loops)
+    {
+        auto close = std::make_shared<LoopClose>();
+        close->loop = item.first;
+        close->connections = std::move(item.second);
+        close->finish = [loopsLeft, sharedDone]() {
+            if (--*loopsLeft == 0 && *sharedDone)
+                (*sharedDone)();
+        };
+        item.first->runInLoop([close, graceTime]() {
+            if (graceTime <= 0)
+            {
+                close->forceClose();
+                return;
+            }
+            // shutdown() sends the pending data before closing the writing
+            // direction, the peer then closes the connection.
+            for (auto &conn : close->connections)
+                conn->shutdown();
+            close->deadline =
+                std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(graceTime));
+            close->timerId =
+                close->loop->runEvery((std::min)(graceTime, 0.1),
+                                      [close]() { close->check(); });
+        });
+    }
+}
 #ifndef _WIN32
 void TcpConnectionImpl::sendInLoop(const void *buffer, size_t length)
 #else
@@ -391,7 +614,18 @@ void TcpConnectionImpl::sendInLoop(const char *buffer, size_t length)
         return;
     }
     ssize_t sendLen = 0;
-    if (!ioChannelPtr_->isWriting() && writeBufferList_.empty())
+    if (deferredFlush_ && !ioChannelPtr_->isWriting())
+    {
+        // The data is buffered and written at the end of the iteration
+        if (!flushQueued_)
+        {
+            flushQueued_ = true;
+            loop_->runAtEndOfIteration([thisPtr = shared_from_this()]() {
+                thisPtr->flushDeferredData();
+            });
+        }
+    }
+    else if (!ioChannelPtr_->isWriting() && writeBufferList_.empty())
     {
         // send directly
         sendLen = writeInLoop(buffer, length);
@@ -548,6 +782,104 @@ void TcpConnectionImpl::send(MsgBuffer &&buffer)
             });
     }
 }
+
+uint64_t TcpConnectionImpl::reserveSendSlot()
+{
+    return sendSlots_.reserve();
+}
+
+void TcpConnectionImpl::fillSendSlot(uint64_t slot, std::string &&data)
+{
+    // The flush is queued even in the loop thread, so that the slots filled
+    // in the same iteration of the loop are written together
+    if (sendSlots_.fill(slot, std::move(data)))
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this()]() { thisPtr->flushSendSlots(); });
+}
+
+void TcpConnectionImpl::fillSendSlot(uint64_t slot, MsgBuffer &&data)
+{
+    if (sendSlots_.fill(slot, std::move(data)))
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this()]() { thisPtr->flushSendSlots(); });
+}
+
+void TcpConnectionImpl::flushSendSlots()
+{
+    std::vector<SendSlots::Slot> slots;
+    sendSlots_.takeFilled(slots);
+    if (status_ != ConnStatus::Connected)
+    {
+        LOG_DEBUG << "Connection is not connected,give up sending";
+        return;
+    }
+    // The first slot not written and the bytes of it written
+    size_t index = 0;
+    size_t offset = 0;
+#ifndef _WIN32
+    if (!tlsProviderPtr_ && !ioChannelPtr_->isWriting() &&
+        writeBufferList_.empty())
+    {
+        // Write the slots with as few system calls as possible, the rest is
+        // buffered as by send()
+        std::vector<struct iovec> iovecs;
+        while (index < slots.size())
+        {
+            iovecs.clear();
+            size_t length = 0;
+            for (size_t i = index;
+                 i < slots.size() &&
+                 iovecs.size() < static_cast<size_t>(IOV_MAX);
+                 ++i)
+            {
+                size_t skipped = i == index ? offset : 0;
+                struct iovec iov;
+                iov.iov_base = const_cast<char *>(slots[i].data()) + skipped;
+                iov.iov_len = slots[i].size() - skipped;
+                iovecs.push_back(iov);
+                length += iov.iov_len;
+            }
+            auto nWritten = ::writev(socketPtr_->fd(),
+                                     iovecs.data(),
+                                     static_cast<int>(iovecs.size()));
+            if (nWritten < 0)
+            {
+                if (!isEAGAIN())
+                {
+                    LOG_TRACE << "write error";
+                    return;
+                }
+                nWritten = 0;
+            }
+            bytesSent_ += nWritten;
+            extendLife();
+            size_t written = static_cast<size_t>(nWritten);
+            while (index < slots.size() &&
+                   written >= slots[index].size() - offset)
+            {
+                written -= slots[index].size() - offset;
+                offset = 0;
+                ++index;
+            }
+            offset += written;
+            if (static_cast<size_t>(nWritten) < length)
+            {
+                LOG_TRACE << "nWritten = " << nWritten
+                          << " length = " << length;
+                ioChannelPtr_->enableWriting();
+                break;
+            }
+        }
+    }
+#endif
+    for (; index < slots.size(); ++index)
+    {
+        sendInLoop(slots[index].data() + offset,
+                   slots[index].size() - offset);
+        offset = 0;
+    }
+}
+
 void TcpConnectionImpl::sendFile(const char *fileName,
                                  long long offset,
                                  long long length)
@@ -18,6 +18,8 @@
 #include <trantor/utils/TimingWheel.h>
 #include <trantor/net/inner/TLSProvider.h>
 #include <trantor/net/inner/BufferNode.h>
+#include <trantor/net/inner/SendSlots.h>
+#include <trantor/net/inner/DeadlineWheel.h>
 #include <list>
 #include <mutex>
 #ifndef _WIN32
@@ -33,6 +35,7 @@ class Socket;
 class TcpServer;
 class TcpConnectionImpl : public TcpConnection,
                           public NonCopyable,
+                          public DeadlineWheel::Connection,
                           public std::enable_shared_from_this<TcpConnectionImpl>
 {
     friend class TcpServer;
@@ -131,7 +134,10 @@ class TcpConnectionImpl : public TcpConnection,
     {
         return idleTimeout_ == 0;
     }
+    void setReadDeadline(double timeout) override;
+    void setWriteDeadline(double timeout) override;
     void setTcpNoDelay(bool on) override;
+    void setDeferredFlush(bool on) override;
     void shutdown() override;
     void forceClose() override;
     EventLoop *getLoop() override
@@ -188,6 +194,9 @@ class TcpConnectionImpl : public TcpConnection,
         bool isServer,
         std::function<void(const TcpConnectionPtr &)> upgradeCallback) override;
     AsyncStreamPtr sendAsyncStream(bool disableKickoff) override;
+    uint64_t reserveSendSlot() override;
+    void fillSendSlot(uint64_t slot, std::string &&data) override;
+    void fillSendSlot(uint64_t slot, MsgBuffer &&data) override;
 
     void enableKickingOff(
         size_t timeout,
@@ -214,6 +223,25 @@ class TcpConnectionImpl : public TcpConnection,
     void extendLife();
     void sendFile(BufferNodePtr &&fileNode);
 
+    // Deadlines are ticks of the deadline wheel, 0 if not set
+    void setDeadlineInLoop(Deadline kind, double timeout);
+    void scheduleDeadlineCheck(uint64_t tick);
+    void checkDeadlines(uint64_t tick) override;
+    void onDeadline(Deadline deadline);
+    bool hasDataToWrite() const;
+    std::shared_ptr<DeadlineWheel> deadlineWheel_;
+    uint64_t readDeadline_{0};
+    uint64_t writeDeadline_{0};
+    // The tick of the bucket of the wheel the connection is in, 0 if none
+    uint64_t deadlineCheckTick_{0};
+
+    void flushDeferredData();
+    bool deferredFlush_{false};
+    bool flushQueued_{false};
+
+    void flushSendSlots();
+    SendSlots sendSlots_;
+
   protected:
     enum class ConnStatus
     {
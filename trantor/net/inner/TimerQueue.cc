@@ -16,7 +16,7 @@
 
 #include "TimerQueue.h"
 #include "Channel.h"
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
 #include <sys/timerfd.h>
 #endif
 #include <string.h>
@@ -26,7 +26,7 @@
 #endif
 
 using namespace trantor;
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
 static int createTimerfd()
 {
     int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
@@ -135,14 +135,14 @@ void TimerQueue::processTimers()
 ///////////////////////////////////////
 TimerQueue::TimerQueue(EventLoop *loop)
     : loop_(loop),
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
       timerfd_(createTimerfd()),
       timerfdChannelPtr_(new Channel(loop, timerfd_)),
 #endif
       timers_(),
       callingExpiredTimers_(false)
 {
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
     timerfdChannelPtr_->setReadCallback(
         std::bind(&TimerQueue::handleRead, this));
     // we are always reading the timerfd, we disarm it with timerfd_settime.
@@ -152,6 +152,7 @@ TimerQueue::TimerQueue(EventLoop *loop)
 #ifdef __linux__
 void TimerQueue::reset()
 {
+#ifdef TRANTOR_TIMERFD
     loop_->runInLoop([this]() {
         timerfdChannelPtr_->disableAll();
         timerfdChannelPtr_->remove();
@@ -168,11 +169,19 @@ void TimerQueue::reset()
             resetTimerfd(timerfd_, nextExpire);
         }
     });
+#endif
 }
 #endif
 TimerQueue::~TimerQueue()
 {
-#ifdef __linux__
+    auto op = staged_.exchange(nullptr, std::memory_order_acquire);
+    while (op)
+    {
+        auto next = op->next;
+        delete op;
+        op = next;
+    }
+#ifdef TRANTOR_TIMERFD
     auto chlPtr = timerfdChannelPtr_;
     auto fd = timerfd_;
     loop_->runInLoop([chlPtr, fd]() {
@@ -187,11 +196,7 @@ TimerId TimerQueue::addTimer(const TimerCallback &cb,
                              const TimePoint &when,
                              const TimeInterval &interval)
 {
-    std::shared_ptr<Timer> timerPtr =
-        std::make_shared<Timer>(cb, when, interval);
-
-    loop_->runInLoop([this, timerPtr]() { addTimerInLoop(timerPtr); });
-    return timerPtr->id();
+    return addTimer(TimerCallback(cb), when, interval);
 }
 TimerId TimerQueue::addTimer(TimerCallback &&cb,
                              const TimePoint &when,
@@ -199,9 +204,12 @@ TimerId TimerQueue::addTimer(TimerCallback &&cb,
 {
     std::shared_ptr<Timer> timerPtr =
         std::make_shared<Timer>(std::move(cb), when, interval);
-
-    loop_->runInLoop([this, timerPtr]() { addTimerInLoop(timerPtr); });
-    return timerPtr->id();
+    const TimerId id = timerPtr->id();
+    if (loop_->isInLoopThread())
+        addTimerInLoop(timerPtr);
+    else
+        stage(new StagedOp{std::move(timerPtr), InvalidTimerId, nullptr});
+    return id;
 }
 void TimerQueue::addTimerInLoop(const TimerPtr &timer)
 {
@@ -210,7 +218,7 @@ void TimerQueue::addTimerInLoop(const TimerPtr &timer)
     if (insert(timer))
     {
 // the earliest timer changed
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
         resetTimerfd(timerfd_, timer->when());
 #endif
     }
@@ -218,7 +226,68 @@ void TimerQueue::addTimerInLoop(const TimerPtr &timer)
 
 void TimerQueue::invalidateTimer(TimerId id)
 {
-    loop_->runInLoop([this, id]() { timerIdSet_.erase(id); });
+    if (loop_->isInLoopThread())
+        timerIdSet_.erase(id);
+    else
+        stage(new StagedOp{nullptr, id, nullptr});
+}
+
+void TimerQueue::stage(StagedOp *op)
+{
+    op->next = staged_.load(std::memory_order_relaxed);
+    while (!staged_.compare_exchange_weak(op->next,
+                                          op,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+    {
+    }
+    // The first operation since the last drain schedules the next one
+    if (op->next == nullptr)
+        loop_->queueInLoop([this]() { drainStaged(); });
+}
+
+void TimerQueue::drainStaged()
+{
+    loop_->assertInLoopThread();
+    // The list is in reverse order
+    StagedOp *op = staged_.exchange(nullptr, std::memory_order_acquire);
+    StagedOp *ordered = nullptr;
+    while (op)
+    {
+        auto next = op->next;
+        op->next = ordered;
+        ordered = op;
+        op = next;
+    }
+    // Timers invalidated in the batch that added them, e.g. timeouts of
+    // requests answered quickly, never get into the heap
+    for (op = ordered; op; op = op->next)
+    {
+        if (!op->timer)
+            batchInvalidated_.insert(op->invalidatedId);
+    }
+    bool earliestChanged = false;
+    while (ordered)
+    {
+        std::unique_ptr<StagedOp> current(ordered);
+        ordered = ordered->next;
+        if (!current->timer)
+        {
+            timerIdSet_.erase(current->invalidatedId);
+        }
+        else if (batchInvalidated_.count(current->timer->id()) == 0)
+        {
+            timerIdSet_.insert(current->timer->id());
+            earliestChanged = insert(current->timer) || earliestChanged;
+        }
+    }
+    batchInvalidated_.clear();
+#ifdef TRANTOR_TIMERFD
+    if (earliestChanged)
+        resetTimerfd(timerfd_, timers_.top()->when());
+#else
+    (void)earliestChanged;
+#endif
 }
 
 bool TimerQueue::insert(const TimerPtr &timerPtr)
@@ -234,7 +303,7 @@ bool TimerQueue::insert(const TimerPtr &timerPtr)
     // timer:"<<timerPtr->when().microSecondsSinceEpoch()/1000000<<std::endl;
     return earliestChanged;
 }
-#ifndef __linux__
+#ifndef TRANTOR_TIMERFD
 int64_t TimerQueue::getTimeout() const
 {
     loop_->assertInLoopThread();
@@ -247,6 +316,18 @@ int64_t TimerQueue::getTimeout() const
         return howMuchTimeFromNow(timers_.top()->when());
     }
 }
+int64_t TimerQueue::getTimeoutUs() const
+{
+    loop_->assertInLoopThread();
+    if (timers_.empty())
+        return -1;
+    auto nanoSeconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           timers_.top()->when() -
+                           std::chrono::steady_clock::now())
+                           .count();
+    // Round up, the timer hasn't expired before its time point
+    return nanoSeconds > 0 ? (nanoSeconds + 999) / 1000 : 0;
+}
 #endif
 
 std::vector<TimerPtr> TimerQueue::getExpired(const TimePoint &now)
@@ -284,7 +365,7 @@ void TimerQueue::reset(const std::vector<TimerPtr> &expired,
             }
         }
     }
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
     if (!timers_.empty())
     {
         const auto nextExpire = timers_.top()->when();
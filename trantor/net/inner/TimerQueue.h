@@ -21,6 +21,13 @@
 #include <memory>
 #include <atomic>
 #include <unordered_set>
+
+// On Linux the timers wake the loop up with a timerfd, unless trantor is
+// built with TRANTOR_USE_TIMERFD=OFF. The poll timeout is then computed from
+// the next timer, as on the other systems.
+#if defined __linux__ && !defined TRANTOR_NO_TIMERFD
+#define TRANTOR_TIMERFD
+#endif
 namespace trantor
 {
 // class Timer;
@@ -50,13 +57,17 @@ class TimerQueue : NonCopyable
     void invalidateTimer(TimerId id);
 #ifdef __linux__
     void reset();
-#else
+#endif
+#ifndef TRANTOR_TIMERFD
+    // The poll timeout in milliseconds
     int64_t getTimeout() const;
+    // The time to the next timer in microseconds, -1 if there is none
+    int64_t getTimeoutUs() const;
     void processTimers();
 #endif
   protected:
     EventLoop *loop_;
-#ifdef __linux__
+#ifdef TRANTOR_TIMERFD
     int timerfd_;
     std::shared_ptr<Channel> timerfdChannelPtr_;
     void handleRead();
@@ -72,5 +83,20 @@ class TimerQueue : NonCopyable
 
   private:
     std::unordered_set<uint64_t> timerIdSet_;
+
+    // Timers added and invalidated in other threads are staged in a lock-free
+    // list, which is drained in the loop once for all the operations staged
+    // in the meantime. Only the operation finding the list empty wakes the
+    // loop up.
+    struct StagedOp
+    {
+        TimerPtr timer;  // nullptr for invalidations
+        TimerId invalidatedId;
+        StagedOp *next;
+    };
+    void stage(StagedOp *op);
+    void drainStaged();
+    std::atomic<StagedOp *> staged_{nullptr};
+    std::unordered_set<TimerId> batchInvalidated_;
 };
 }  // namespace trantor
@@ -18,7 +18,9 @@
 #ifdef __linux__
 #include <poll.h>
 #include <sys/epoll.h>
+#include <sys/syscall.h>
 #include <unistd.h>
+#include <atomic>
 #include <assert.h>
 #include <strings.h>
 #include <iostream>
@@ -81,7 +83,46 @@ void EpollPoller::poll(int timeoutMs, ChannelList *activeChannels)
                                  &*events_.begin(),
                                  static_cast<int>(events_.size()),
                                  timeoutMs);
-    int savedErrno = errno;
+    handleResult(numEvents, errno, activeChannels);
+}
+#ifdef __linux__
+void EpollPoller::pollUs(int64_t timeoutUs, ChannelList *activeChannels)
+{
+#ifdef SYS_epoll_pwait2
+    // Linux 5.11 and later
+    static std::atomic<bool> hasPwait2{true};
+    if (hasPwait2.load(std::memory_order_relaxed))
+    {
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(timeoutUs / 1000000);
+        ts.tv_nsec = static_cast<long>((timeoutUs % 1000000) * 1000);
+        int numEvents =
+            static_cast<int>(::syscall(SYS_epoll_pwait2,
+                                       epollfd_,
+                                       &*events_.begin(),
+                                       static_cast<int>(events_.size()),
+                                       timeoutUs < 0 ? nullptr : &ts,
+                                       nullptr,
+                                       0));
+        if (numEvents >= 0 || errno == EINTR)
+        {
+            handleResult(numEvents, errno, activeChannels);
+            return;
+        }
+        // ENOSYS on older kernels, or EPERM from a seccomp filter. Any other
+        // error is reported again by epoll_wait() below.
+        LOG_DEBUG << "epoll_pwait2 failed with errno " << errno
+                  << ", using epoll_wait";
+        hasPwait2.store(false, std::memory_order_relaxed);
+    }
+#endif
+    Poller::pollUs(timeoutUs, activeChannels);
+}
+#endif
+void EpollPoller::handleResult(int numEvents,
+                               int savedErrno,
+                               ChannelList *activeChannels)
+{
     // Timestamp now(Timestamp::now());
     if (numEvents > 0)
     {
@@ -105,7 +146,6 @@ void EpollPoller::poll(int timeoutMs, ChannelList *activeChannels)
             LOG_SYSERR << "EPollEpollPoller::poll()";
         }
     }
-    return;
 }
 void EpollPoller::fillActiveChannels(int numEvents,
                                      ChannelList *activeChannels) const
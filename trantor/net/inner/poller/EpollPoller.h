@@ -33,6 +33,11 @@ class EpollPoller : public Poller
     explicit EpollPoller(EventLoop *loop);
     virtual ~EpollPoller();
     virtual void poll(int timeoutMs, ChannelList *activeChannels) override;
+#ifdef __linux__
+    // Uses epoll_pwait2() for timeouts of microseconds if the kernel has it
+    virtual void pollUs(int64_t timeoutUs,
+                        ChannelList *activeChannels) override;
+#endif
     virtual void updateChannel(Channel *channel) override;
     virtual void removeChannel(Channel *channel) override;
 #ifdef _WIN32
@@ -59,6 +64,9 @@ class EpollPoller : public Poller
     ChannelMap channels_;
 #endif
     void fillActiveChannels(int numEvents, ChannelList *activeChannels) const;
+    void handleResult(int numEvents,
+                      int savedErrno,
+                      ChannelList *activeChannels);
 #endif
 };
 }  // namespace trantor
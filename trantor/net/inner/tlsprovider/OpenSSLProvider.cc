@@ -462,7 +462,9 @@ class SessionManager
     int mexExtendSize_ = 20;
     int sessionTimeout_ = 3600;
     std::list<SessionData> sessions_;
-    std::unordered_map<std::string, std::list<SessionData>::iterator>
+    std::unordered_map<std::string,
+                       std::list<SessionData>::iterator,
+                       utils::StringHash>
         sessionMap_;
 };
 
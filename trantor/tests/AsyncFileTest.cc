@@ -0,0 +1,86 @@
+#include <trantor/net/AsyncFile.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+// Write a file in chunks with several writes in flight while a timer checks
+// that the loop stays responsive, then fsync it.
+//
+// usage: async_file_test [file] [MB] [chunk KB] [writes in flight]
+
+using namespace trantor;
+
+int main(int argc, char *argv[])
+{
+    Logger::setLogLevel(Logger::kInfo);
+    const std::string path = argc > 1 ? argv[1] : "async_file_test.tmp";
+    const size_t total = (argc > 2 ? std::stoul(argv[2]) : 256) << 20;
+    const size_t chunkSize = (argc > 3 ? std::stoul(argv[3]) : 64) << 10;
+    const size_t depth = argc > 4 ? std::stoul(argv[4]) : 16;
+    const std::string chunk(chunkSize, 'x');
+
+    EventLoop loop;
+    // The longest delay of a 1 ms timer while the file is written
+    double maxLag = 0;
+    auto last = std::chrono::steady_clock::now();
+    loop.runEvery(0.001, [&]() {
+        auto now = std::chrono::steady_clock::now();
+        maxLag = (std::max)(maxLag,
+                            std::chrono::duration<double>(now - last).count() -
+                                0.001);
+        last = now;
+    });
+
+    size_t offset = 0;
+    size_t inFlight = 0;
+    AsyncFilePtr file;
+    std::function<void()> writeNext = [&]() {
+        while (inFlight < depth && offset < total)
+        {
+            ++inFlight;
+            file->write(offset, chunk.data(), chunk.size(), [&](ssize_t n) {
+                if (n < 0)
+                    LOG_ERROR << "write: " << strerror_tl(-n);
+                --inFlight;
+                writeNext();
+            });
+            offset += chunk.size();
+        }
+        if (inFlight == 0 && offset >= total)
+            file->fsync([&](ssize_t) { loop.quit(); });
+    };
+    auto start = std::chrono::steady_clock::now();
+    AsyncFile::open(&loop,
+                    path,
+                    O_WRONLY | O_CREAT | O_TRUNC,
+                    [&](const AsyncFilePtr &opened, int err) {
+                        if (!opened)
+                        {
+                            LOG_ERROR << "open " << path << ": "
+                                      << strerror_tl(err);
+                            loop.quit();
+                            return;
+                        }
+                        file = opened;
+                        LOG_INFO << "Writing " << (total >> 20) << " MB with "
+                                 << (file->isIoUringUsed() ? "io_uring"
+                                                           : "thread pool");
+                        start = std::chrono::steady_clock::now();
+                        writeNext();
+                    });
+    loop.loop();
+
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    LOG_INFO << "Wrote and synced in " << seconds << " s, "
+             << (total >> 20) / seconds << " MB/s, max timer lag "
+             << maxLag * 1000 << " ms";
+    file.reset();
+    ::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <trantor/utils/BufferPool.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/Logger.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// Fill many connection-sized buffers and touch random bytes of them, as a
+// proxy holding gigabytes of buffered data does, with and without huge pages.
+//
+// usage: buffer_pool_test [buffers] [KB per buffer] [hugepages|explicit]
+
+using namespace trantor;
+
+namespace
+{
+size_t anonHugePagesKB()
+{
+    size_t total = 0;
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f)
+        return 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        size_t kb;
+        if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+            total += kb;
+    }
+    fclose(f);
+    return total;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    Logger::setLogLevel(Logger::kInfo);
+    const size_t bufferNum = argc > 1 ? std::stoul(argv[1]) : 65536;
+    const size_t bufferSize = (argc > 2 ? std::stoul(argv[2]) : 16) << 10;
+    if (argc > 3)
+    {
+        if (!BufferPool::enableHugePages(strcmp(argv[3], "explicit") == 0))
+        {
+            LOG_ERROR << "huge pages aren't supported";
+            return 1;
+        }
+    }
+
+    std::vector<MsgBuffer> buffers(bufferNum);
+    const std::string chunk(bufferSize, 'x');
+    for (auto &buffer : buffers)
+        buffer.append(chunk);
+
+    std::mt19937_64 rng(42);
+    const size_t accesses = 20000000;
+    std::vector<uint32_t> indexes(1 << 20);
+    for (auto &index : indexes)
+        index = static_cast<uint32_t>(rng());
+    size_t sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < accesses; ++i)
+    {
+        const uint32_t r = indexes[i & (indexes.size() - 1)];
+        const auto &buffer = buffers[(r + i) % bufferNum];
+        sum += buffer[(r >> 7) % bufferSize];
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    LOG_INFO << (BufferPool::hugePagesEnabled() ? "huge pages" : "default")
+             << ": " << bufferNum << " buffers of " << (bufferSize >> 10)
+             << " KB, " << seconds * 1e9 / accesses
+             << " ns per random access, " << (anonHugePagesKB() >> 10)
+             << " MB in huge pages (" << sum % 2 << ")";
+    return 0;
+}
@@ -0,0 +1,470 @@
+// Opens a large number of idle or trickling loopback connections to a
+// TcpServer and reports what they cost the server: resident memory per
+// connection, CPU time of every event loop, accept throughput and, with -k,
+// the cost of the idle connection kick-off timing wheels.
+//
+// The clients run in a forked child process with plain sockets, so the
+// numbers of the parent process are those of the server alone. To avoid
+// running out of ephemeral ports, the clients bind to successive source
+// addresses of 127.0.0.0/8.
+//
+// Opening a million connections needs about two million file descriptors
+// (one per side), e.g. as root:
+//   sysctl -w fs.nr_open=2100000 fs.file-max=4200000
+//   ulimit -n 2100000
+//   ./connection_scale_test -n 1000000 -s 4 -k 60 -t 30
+
+#include <trantor/net/TcpServer.h>
+#include <trantor/utils/Logger.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace trantor;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct Options
+{
+    size_t connections{10000};
+    size_t ioLoops{1};
+    size_t kickoff{0};
+    double trickleInterval{0};
+    double duration{10};
+    uint16_t port{8890};
+    // Connections per source address, below the usual ephemeral port range
+    size_t perSource{20000};
+};
+
+void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n connections] [-s io loops] [-k kickoff seconds]\n"
+            "          [-t trickle interval seconds] [-d duration seconds]\n"
+            "          [-p port] [-a connections per source address]\n"
+            "  -s 0 handles I/O in the accepting loop. -t 0 keeps the\n"
+            "  connections idle, otherwise each one sends a byte every -t\n"
+            "  seconds. -d is the time to keep the connections open once\n"
+            "  they are all established.\n",
+            prog);
+}
+
+size_t residentBytes()
+{
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f)
+    {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        fclose(f);
+    }
+    return static_cast<size_t>(resident) *
+           static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+double threadCpuSeconds(clockid_t clock)
+{
+    timespec ts;
+    if (clock_gettime(clock, &ts) != 0)
+        return 0;
+    return static_cast<double>(ts.tv_sec) + ts.tv_nsec / 1e9;
+}
+
+int64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+clockid_t currentThreadClock()
+{
+    clockid_t clock;
+    if (pthread_getcpuclockid(pthread_self(), &clock) != 0)
+        return CLOCK_THREAD_CPUTIME_ID;
+    return clock;
+}
+
+size_t raiseFdLimit(size_t wanted)
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+        return 0;
+    if (limit.rlim_cur < wanted && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = (std::min)(static_cast<rlim_t>(wanted),
+                                    limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    return static_cast<size_t>(limit.rlim_cur);
+}
+
+// The child process. It must not touch any trantor object after fork().
+[[noreturn]] void runClients(const Options &opts, int readyFd)
+{
+    char c;
+    if (read(readyFd, &c, 1) != 1)
+        _exit(1);
+    close(readyFd);
+
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(opts.port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<int> fds;
+    fds.reserve(opts.connections);
+    size_t failures = 0;
+    for (size_t i = 0; i < opts.connections; ++i)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            perror("client socket");
+            break;
+        }
+#ifdef IP_BIND_ADDRESS_NO_PORT
+        // Let connect() pick the port so that it only has to be unique per
+        // 4-tuple
+        int on = 1;
+        setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof(on));
+#endif
+        // 127.0.0.2, 127.0.0.3, ... leaving out the server address
+        sockaddr_in source{};
+        source.sin_family = AF_INET;
+        source.sin_addr.s_addr =
+            htonl(INADDR_LOOPBACK + 1 +
+                  static_cast<uint32_t>(i / opts.perSource));
+        auto sourceAddr = reinterpret_cast<sockaddr *>(&source);
+        auto serverAddr = reinterpret_cast<sockaddr *>(&server);
+        if (bind(fd, sourceAddr, sizeof(source)) != 0 ||
+            connect(fd, serverAddr, sizeof(server)) != 0)
+        {
+            if (failures++ < 10)
+                perror("client connect");
+            close(fd);
+            continue;
+        }
+        fds.push_back(fd);
+    }
+    if (failures > 0)
+        fprintf(stderr, "%zu client connections failed\n", failures);
+
+    // Spread the trickle evenly so that every connection sends one byte per
+    // interval
+    const auto slice = 10ms;
+    size_t next = 0;
+    double credit = 0;
+    const double perSlice =
+        opts.trickleInterval > 0
+            ? static_cast<double>(fds.size()) * 0.01 / opts.trickleInterval
+            : 0;
+    for (;;)
+    {
+        std::this_thread::sleep_for(slice);
+        if (perSlice == 0 || fds.empty())
+            continue;
+        credit += perSlice;
+        for (; credit >= 1; credit -= 1)
+        {
+            // Connections kicked off by the server just fail to send
+            (void)send(fds[next], "x", 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (++next == fds.size())
+                next = 0;
+        }
+    }
+}
+
+struct Sample
+{
+    std::chrono::steady_clock::time_point time;
+    std::vector<double> cpu;
+    size_t messages;
+};
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    Options opts;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:k:t:d:p:a:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                opts.connections = strtoul(optarg, nullptr, 10);
+                break;
+            case 's':
+                opts.ioLoops = strtoul(optarg, nullptr, 10);
+                break;
+            case 'k':
+                opts.kickoff = strtoul(optarg, nullptr, 10);
+                break;
+            case 't':
+                opts.trickleInterval = atof(optarg);
+                break;
+            case 'd':
+                opts.duration = atof(optarg);
+                break;
+            case 'p':
+                opts.port = static_cast<uint16_t>(atoi(optarg));
+                break;
+            case 'a':
+                opts.perSource = (std::max)(1ul, strtoul(optarg, nullptr, 10));
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (opts.connections == 0 || opts.kickoff == 1)
+    {
+        // The kick-off timing wheels need a timeout of at least 2 seconds
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Both ends of every connection live on this host
+    const size_t fdLimit = raiseFdLimit(opts.connections + 1024);
+    if (fdLimit < opts.connections + 64)
+    {
+        LOG_WARN << "RLIMIT_NOFILE is " << fdLimit << ", too low for "
+                 << opts.connections << " connections, raise it with ulimit -n";
+    }
+
+    // Fork before any thread is started
+    int readyPipe[2];
+    if (pipe(readyPipe) != 0)
+    {
+        LOG_SYSERR << "pipe";
+        return 1;
+    }
+    pid_t child = fork();
+    if (child < 0)
+    {
+        LOG_SYSERR << "fork";
+        return 1;
+    }
+    if (child == 0)
+    {
+        close(readyPipe[1]);
+        runClients(opts, readyPipe[0]);
+    }
+    close(readyPipe[0]);
+
+    Logger::setLogLevel(Logger::kInfo);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", opts.port), "scale");
+    if (opts.ioLoops > 0)
+        server.setIoLoopNum(opts.ioLoops);
+    if (opts.kickoff > 0)
+        server.kickoffIdleConnections(opts.kickoff);
+
+    std::atomic<size_t> established{0};
+    std::atomic<size_t> closed{0};
+    std::atomic<size_t> messages{0};
+    std::atomic<int64_t> firstAccept{0};
+    std::atomic<int64_t> lastAccept{0};
+    // Connections destroyed by the server, counted by their contexts
+    std::atomic<size_t> released{0};
+    struct Release
+    {
+        explicit Release(std::atomic<size_t> &counter) : released(counter)
+        {
+        }
+        ~Release()
+        {
+            ++released;
+        }
+        std::atomic<size_t> &released;
+    };
+    std::thread stopper;
+    server.setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if (conn->connected())
+        {
+            const int64_t now = steadyNanoseconds();
+            conn->setContext(std::make_shared<Release>(released));
+            const size_t n = ++established;
+            if (n == 1)
+                firstAccept = now;
+            if (n == opts.connections)
+                lastAccept = now;
+        }
+        else if (conn->disconnected())
+            ++closed;
+    });
+    server.setRecvMessageCallback(
+        [&messages](const TcpConnectionPtr &, MsgBuffer *buffer) {
+            ++messages;
+            buffer->retrieveAll();
+        });
+    server.start();
+
+    // The CPU clocks of the accepting loop (this thread) and the I/O loops
+    std::vector<std::string> loopNames{"accept"};
+    std::vector<clockid_t> clocks{currentThreadClock()};
+    if (opts.ioLoops > 0)
+    {
+        for (auto ioLoop : server.getIoLoops())
+        {
+            std::promise<clockid_t> clock;
+            ioLoop->runInLoop(
+                [&clock]() { clock.set_value(currentThreadClock()); });
+            clocks.push_back(clock.get_future().get());
+            loopNames.push_back("io" + std::to_string(loopNames.size() - 1));
+        }
+    }
+    auto sample = [&]() {
+        Sample s;
+        s.time = std::chrono::steady_clock::now();
+        for (auto clock : clocks)
+            s.cpu.push_back(threadCpuSeconds(clock));
+        s.messages = messages.load();
+        return s;
+    };
+    auto describe = [&](const Sample &from, const Sample &to) {
+        const double seconds =
+            std::chrono::duration<double>(to.time - from.time).count();
+        std::string cpu;
+        for (size_t i = 0; i < clocks.size(); ++i)
+        {
+            char buf[64];
+            snprintf(buf,
+                     sizeof(buf),
+                     " %s %.1f%%",
+                     loopNames[i].c_str(),
+                     (to.cpu[i] - from.cpu[i]) * 100 / seconds);
+            cpu += buf;
+        }
+        return cpu;
+    };
+
+    const size_t baseRss = residentBytes();
+    const auto start = std::chrono::steady_clock::now();
+    if (write(readyPipe[1], "r", 1) != 1)
+    {
+        LOG_SYSERR << "write";
+        return 1;
+    }
+    close(readyPipe[1]);
+    LOG_INFO << "server rss " << baseRss / 1024 << " KiB before connecting, "
+             << clocks.size() << " loops";
+
+    Sample last = sample();
+    Sample steadyStart = last;
+    bool allEstablished = false;
+    std::chrono::steady_clock::time_point establishedTime;
+    loop.runEvery(1.0, [&]() {
+        const Sample now = sample();
+        const size_t conns = established.load() - closed.load();
+        const size_t rss = residentBytes();
+        const double seconds =
+            std::chrono::duration<double>(now.time - last.time).count();
+        LOG_INFO << "open " << conns << " (closed " << closed.load()
+                 << "), rss " << rss / 1024 / 1024 << " MiB, "
+                 << static_cast<size_t>((now.messages - last.messages) /
+                                        seconds)
+                 << " msg/s, cpu" << describe(last, now);
+        last = now;
+
+        if (!allEstablished && lastAccept.load() != 0)
+        {
+            allEstablished = true;
+            establishedTime = now.time;
+            steadyStart = now;
+            const double acceptSeconds =
+                (std::max)(lastAccept.load() - firstAccept.load(),
+                           int64_t(1)) /
+                1e9;
+            LOG_INFO << "established " << opts.connections << " connections in "
+                     << acceptSeconds << " s, "
+                     << static_cast<size_t>(opts.connections / acceptSeconds)
+                     << " accepts/s";
+            LOG_INFO << "server memory per connection: "
+                     << (rss > baseRss ? (rss - baseRss) / opts.connections
+                                       : 0)
+                     << " bytes of user space";
+        }
+        const auto deadline =
+            allEstablished ? establishedTime + std::chrono::duration<double>(
+                                                   opts.duration)
+                           : start + std::chrono::duration<double>(
+                                         opts.duration + 600);
+        if (now.time < deadline)
+            return;
+        if (!allEstablished)
+        {
+            LOG_ERROR << "only " << established.load() << " of "
+                      << opts.connections << " connections established";
+        }
+        else
+        {
+            const double seconds =
+                std::chrono::duration<double>(now.time - steadyStart.time)
+                    .count();
+            double cpu = 0;
+            for (size_t i = 0; i < clocks.size(); ++i)
+                cpu += now.cpu[i] - steadyStart.cpu[i];
+            const size_t msgs = now.messages - steadyStart.messages;
+            LOG_INFO << "steady state over " << seconds
+                     << " s, cpu:" << describe(steadyStart, now);
+            LOG_INFO << "steady state cpu per connection per second: "
+                     << cpu * 1e9 / seconds / opts.connections << " ns"
+                     << (msgs > 0 ? ", per message: " +
+                                        std::to_string(cpu * 1e9 / msgs) +
+                                        " ns"
+                                  : std::string());
+            if (opts.kickoff > 0)
+            {
+                LOG_INFO << closed.load()
+                         << " connections closed by the server, the idle "
+                            "cpu above includes the kick-off timing wheels";
+            }
+        }
+        // Stop the server from another thread while the loop runs, as a
+        // service does when it is shut down
+        if (stopper.joinable())
+            return;
+        stopper = std::thread([&]() {
+            const size_t open = established.load() - closed.load();
+            const auto stopStart = std::chrono::steady_clock::now();
+            server.stop();
+            const auto stopped = std::chrono::steady_clock::now();
+            for (int i = 0; i < 1000 && released.load() < established.load();
+                 ++i)
+                std::this_thread::sleep_for(10ms);
+            const auto end = std::chrono::steady_clock::now();
+            LOG_INFO << "stopped the server with " << open
+                     << " open connections in "
+                     << std::chrono::duration<double>(stopped - stopStart)
+                            .count()
+                     << " s, " << released.load() << " of "
+                     << established.load() << " connections released in "
+                     << std::chrono::duration<double>(end - stopStart).count()
+                     << " s";
+            loop.quit();
+        });
+    });
+    loop.loop();
+    stopper.join();
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    return 0;
+}
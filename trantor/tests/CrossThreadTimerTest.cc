@@ -0,0 +1,82 @@
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <time.h>
+#include <vector>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// Worker threads add timeouts to a loop and cancel most of them, as request
+// handlers do with their deadlines, and the CPU time the loop spends on them
+// is measured.
+//
+// usage: cross_thread_timer_test [threads] [timers per thread]
+
+using namespace trantor;
+
+int main(int argc, char *argv[])
+{
+    Logger::setLogLevel(Logger::kInfo);
+    const size_t threadNum = argc > 1 ? std::stoul(argv[1]) : 4;
+    const size_t timersPerThread = argc > 2 ? std::stoul(argv[2]) : 200000;
+
+    EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+#ifndef _WIN32
+    std::promise<clockid_t> clockPromise;
+    loop->runInLoop([&clockPromise]() {
+        clockid_t clock;
+        pthread_getcpuclockid(pthread_self(), &clock);
+        clockPromise.set_value(clock);
+    });
+    const clockid_t loopClock = clockPromise.get_future().get();
+    auto loopCpu = [loopClock]() {
+        timespec ts;
+        clock_gettime(loopClock, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    };
+#else
+    auto loopCpu = []() { return 0.0; };
+#endif
+
+    std::atomic<size_t> fired{0};
+    const double cpuBefore = loopCpu();
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadNum; ++t)
+    {
+        workers.emplace_back([&]() {
+            for (size_t i = 0; i < timersPerThread; ++i)
+            {
+                auto id = loop->runAfter(0.2, [&fired]() { ++fired; });
+                // One timeout in a hundred expires
+                if (i % 100 != 0)
+                    loop->invalidateTimer(id);
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    const size_t total = threadNum * timersPerThread;
+    const size_t expected = threadNum * ((timersPerThread + 99) / 100);
+    // Wait for the loop to catch up and the timeouts to expire
+    for (int i = 0; i < 100 && fired.load() < expected; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const double loopSeconds = loopCpu() - cpuBefore;
+
+    LOG_INFO << total << " timers added and " << total - expected
+             << " invalidated by " << threadNum << " threads in " << seconds
+             << " s, " << total / seconds << " timers/s";
+    LOG_INFO << "loop CPU " << loopSeconds << " s, "
+             << loopSeconds * 1e9 / total << " ns per timer";
+    LOG_INFO << fired.load() << " timers fired, expected " << expected;
+    return fired.load() == expected ? 0 : 1;
+}
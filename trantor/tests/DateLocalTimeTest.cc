@@ -0,0 +1,102 @@
+#include <trantor/utils/Date.h>
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+// Compare the cached local time conversion of trantor::Date with plain
+// localtime_r() when several threads format local timestamps concurrently.
+// Usage: date_local_time_test [threads] [iterations per thread]
+
+static std::string formatWithLibc(int64_t microSec)
+{
+    char buf[64];
+    time_t seconds = static_cast<time_t>(microSec / MICRO_SECONDS_PRE_SEC);
+    struct tm tmTime;
+#ifndef _WIN32
+    localtime_r(&seconds, &tmTime);
+#else
+    localtime_s(&tmTime, &seconds);
+#endif
+    snprintf(buf,
+             sizeof(buf),
+             "%4d%02d%02d %02d:%02d:%02d",
+             tmTime.tm_year + 1900,
+             tmTime.tm_mon + 1,
+             tmTime.tm_mday,
+             tmTime.tm_hour,
+             tmTime.tm_min,
+             tmTime.tm_sec);
+    return buf;
+}
+
+template <typename F>
+static double runThreads(size_t threadNum, size_t iterations, F &&func)
+{
+    std::atomic<size_t> totalLen{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threadNum; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            // one second apart, like a logger formatting once per second
+            int64_t t = trantor::Date::now().microSecondsSinceEpoch() +
+                        static_cast<int64_t>(i) * MICRO_SECONDS_PRE_SEC;
+            size_t len = 0;
+            for (size_t j = 0; j < iterations; ++j)
+            {
+                len += func(t).length();
+                t += MICRO_SECONDS_PRE_SEC;
+            }
+            totalLen += len;
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    LOG_TRACE << "formatted " << totalLen.load() << " bytes";
+    return static_cast<double>(elapsed) /
+           static_cast<double>(iterations * threadNum);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t threadNum = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 4;
+    size_t iterations =
+        argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 1000000;
+    if (threadNum == 0 || iterations == 0)
+    {
+        LOG_ERROR << "usage: " << argv[0] << " [threads] [iterations]";
+        return 1;
+    }
+
+    // Check both ways agree before timing them
+    auto now = trantor::Date::now();
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto t = now.after(i * 3600.0 * 7);
+        if (t.toFormattedStringLocal(false) !=
+            formatWithLibc(t.microSecondsSinceEpoch()))
+        {
+            LOG_ERROR << "mismatch at " << t.toFormattedString(false);
+            return 1;
+        }
+    }
+
+    auto libcNs = runThreads(threadNum, iterations, [](int64_t t) {
+        return formatWithLibc(t);
+    });
+    auto dateNs = runThreads(threadNum, iterations, [](int64_t t) {
+        return trantor::Date(t).toFormattedStringLocal(false);
+    });
+    LOG_INFO << threadNum << " threads, " << iterations << " iterations each";
+    LOG_INFO << "localtime_r:                  " << libcNs << " ns/op";
+    LOG_INFO << "Date::toFormattedStringLocal: " << dateNs << " ns/op";
+    return 0;
+}
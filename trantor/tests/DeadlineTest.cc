@@ -0,0 +1,168 @@
+#include <trantor/net/TcpServer.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/Logger.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <future>
+#include <map>
+#include <string>
+#include <thread>
+
+// The server expects a line within 1 second of the previous one and must
+// write its responses within 1 second. Three clients:
+// - "steady" sends a line every 300 ms and stays connected,
+// - "slowloris" sends a byte every 300 ms without ever ending the line, the
+//   read deadline closes it,
+// - "flood" asks for a large response and never reads it, the write deadline
+//   closes it.
+
+using namespace trantor;
+
+namespace
+{
+const uint16_t kPort = 8896;
+
+int connectToServer()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        LOG_SYSERR << "connect";
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void sendEvery(int fd, const std::string &chunk, int times)
+{
+    for (int i = 0; i < times; ++i)
+    {
+        if (::send(fd, chunk.data(), chunk.size(), MSG_NOSIGNAL) < 0)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+}
+}  // namespace
+
+int main()
+{
+    Logger::setLogLevel(Logger::kInfo);
+    EventLoopThread serverThread;
+    serverThread.run();
+    auto loop = serverThread.getLoop();
+
+    // Peer port -> how the connection ended
+    std::map<uint16_t, std::string> outcomes;
+    TcpServer server(loop, InetAddress("127.0.0.1", kPort), "deadlines");
+    server.setConnectionCallback([&outcomes](const TcpConnectionPtr &conn) {
+        if (conn->connected())
+        {
+            conn->setReadDeadline(1.0);
+            conn->setDeadlineCallback(
+                [&outcomes](const TcpConnectionPtr &conn,
+                            TcpConnection::Deadline deadline) {
+                    outcomes[conn->peerAddr().toPort()] =
+                        deadline == TcpConnection::Deadline::Read
+                            ? "read deadline"
+                            : "write deadline";
+                    conn->forceClose();
+                });
+        }
+        else
+        {
+            outcomes.emplace(conn->peerAddr().toPort(), "closed by peer");
+        }
+    });
+    server.setRecvMessageCallback(
+        [](const TcpConnectionPtr &conn, MsgBuffer *buf) {
+            while (auto eol = buf->findCRLF())
+            {
+                const std::string line(buf->peek(), eol);
+                buf->retrieveUntil(eol + 2);
+                conn->setReadDeadline(1.0);
+                if (line == "flood")
+                {
+                    conn->send(std::string(16 * 1024 * 1024, 'x'));
+                    conn->setWriteDeadline(1.0);
+                }
+                else
+                {
+                    conn->send(line + "\r\n");
+                }
+            }
+        });
+    server.start();
+    // start() listens in the loop, wait for it
+    std::promise<void> listening;
+    loop->runInLoop([&listening]() { listening.set_value(); });
+    listening.get_future().wait();
+
+    std::map<uint16_t, std::string> names;
+    auto localPort = [](int fd) {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+        return ntohs(addr.sin_port);
+    };
+    int steady = connectToServer();
+    int slowloris = connectToServer();
+    int flood = connectToServer();
+    if (steady < 0 || slowloris < 0 || flood < 0)
+        return 1;
+    names[localPort(steady)] = "steady";
+    names[localPort(slowloris)] = "slowloris";
+    names[localPort(flood)] = "flood";
+
+    std::thread steadyThread([steady]() {
+        std::thread reader([steady]() {
+            char buf[256];
+            while (::recv(steady, buf, sizeof(buf), 0) > 0)
+            {
+            }
+        });
+        sendEvery(steady, "ping\r\n", 10);
+        ::shutdown(steady, SHUT_RDWR);
+        reader.join();
+    });
+    std::thread slowlorisThread(
+        [slowloris]() { sendEvery(slowloris, "p", 10); });
+    ::send(flood, "flood\r\n", 7, MSG_NOSIGNAL);
+
+    steadyThread.join();
+    slowlorisThread.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    std::promise<bool> result;
+    loop->runInLoop([&]() {
+        bool ok = true;
+        for (auto &name : names)
+        {
+            auto iter = outcomes.find(name.first);
+            const std::string outcome =
+                iter == outcomes.end() ? "open" : iter->second;
+            LOG_INFO << name.second << ": " << outcome;
+            const std::string expected = name.second == "steady"
+                                             ? "closed by peer"
+                                         : name.second == "slowloris"
+                                             ? "read deadline"
+                                             : "write deadline";
+            ok = ok && outcome == expected;
+        }
+        server.stop();
+        result.set_value(ok);
+    });
+    const bool ok = result.get_future().get();
+    ::close(steady);
+    ::close(slowloris);
+    ::close(flood);
+    LOG_INFO << (ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#include <trantor/net/TcpServer.h>
+#include <trantor/net/TcpClient.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+// A client pipelines numbered requests, the server answers each of them with
+// several small sends, as a handler writing a response field by field does.
+// In the deferred flush mode the responses to the requests received together
+// are written together.
+//
+// usage: deferred_flush_test [requests] [off]
+
+using namespace trantor;
+
+int main(int argc, char *argv[])
+{
+    Logger::setLogLevel(Logger::kInfo);
+    const size_t requestNum = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const bool deferred = argc <= 2 || std::string(argv[2]) != "off";
+
+    EventLoopThread serverThread;
+    serverThread.run();
+    InetAddress addr("127.0.0.1", 8898);
+    TcpServer server(serverThread.getLoop(), addr, "deferred_flush");
+    server.setConnectionCallback([deferred](const TcpConnectionPtr &conn) {
+        if (conn->connected())
+            conn->setDeferredFlush(deferred);
+    });
+    server.setRecvMessageCallback(
+        [](const TcpConnectionPtr &conn, MsgBuffer *buffer) {
+            while (const char *eol = buffer->findCRLF())
+            {
+                std::string request(buffer->peek(), eol);
+                buffer->retrieveUntil(eol + 2);
+                conn->send("id: ");
+                conn->send(request);
+                conn->send(", status: ok");
+                conn->send("\r\n");
+            }
+        });
+    serverThread.getLoop()->runInLoop([&server]() { server.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EventLoop loop;
+    auto client =
+        std::make_shared<TcpClient>(&loop, addr, "deferred_flush_client");
+    size_t next = 0;
+    bool inOrder = true;
+    auto start = std::chrono::steady_clock::now();
+    client->setConnectionCallback(
+        [requestNum, &start](const TcpConnectionPtr &conn) {
+            if (!conn->connected())
+                return;
+            std::string requests;
+            for (size_t i = 0; i < requestNum; ++i)
+                requests += std::to_string(i) + "\r\n";
+            start = std::chrono::steady_clock::now();
+            conn->send(std::move(requests));
+        });
+    client->setMessageCallback(
+        [&](const TcpConnectionPtr &, MsgBuffer *buffer) {
+            while (const char *eol = buffer->findCRLF())
+            {
+                std::string response(buffer->peek(), eol);
+                buffer->retrieveUntil(eol + 2);
+                if (response !=
+                    "id: " + std::to_string(next) + ", status: ok")
+                {
+                    LOG_ERROR << "unexpected response " << response;
+                    inOrder = false;
+                    loop.quit();
+                    return;
+                }
+                if (++next == requestNum)
+                    loop.quit();
+            }
+        });
+    client->connect();
+    loop.loop();
+
+    if (!inOrder)
+        return 1;
+    LOG_INFO << requestNum << " pipelined requests answered with "
+             << (deferred ? "deferred" : "immediate") << " flushes in "
+             << std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                        .count() *
+                    1000
+             << " ms";
+    client->disconnect();
+    serverThread.getLoop()->runInLoop([&server]() { server.stop(); });
+    serverThread.getLoop()->quit();
+    serverThread.wait();
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <trantor/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <string>
+
+// Measure the throughput of the hex and base64 codecs in trantor::utils.
+
+template <typename F>
+static double measure(size_t bytes, F &&func)
+{
+    size_t rounds = 256 * 1024 * 1024 / bytes;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        func();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    // bytes per nanosecond is GB/s
+    return static_cast<double>(rounds * bytes) / static_cast<double>(elapsed);
+}
+
+int main()
+{
+    using namespace trantor::utils;
+    for (size_t len : {16, 64, 1024, 65536})
+    {
+        std::string data(len, '\0');
+        for (size_t i = 0; i < len; ++i)
+            data[i] = static_cast<char>(i * 131 + 7);
+        std::string hex(len * 2, '\0');
+        std::string decoded(len, '\0');
+        std::string base64(base64EncodedLength(len), '\0');
+        std::string base64Decoded(base64DecodedMaxLength(base64.size()), '\0');
+        size_t decodedLen = 0;
+
+        auto hexEnc = measure(len, [&]() {
+            toHexString(data.data(), len, &hex[0]);
+        });
+        auto hexDec = measure(len, [&]() {
+            if (!fromHexString(hex.data(), hex.size(), &decoded[0]))
+                LOG_FATAL << "invalid hex";
+        });
+        auto b64Enc = measure(len, [&]() {
+            base64Encode(data.data(), len, &base64[0]);
+        });
+        auto b64Dec = measure(len, [&]() {
+            if (!base64Decode(base64.data(),
+                              base64.size(),
+                              &base64Decoded[0],
+                              decodedLen))
+                LOG_FATAL << "invalid base64";
+        });
+        if (decoded != data || base64Decoded.substr(0, decodedLen) != data)
+        {
+            LOG_ERROR << "round trip failed for length " << len;
+            return 1;
+        }
+        LOG_INFO << "len " << len << ": hex encode " << hexEnc
+                 << " GB/s, hex decode " << hexDec << " GB/s, base64 encode "
+                 << b64Enc << " GB/s, base64 decode " << b64Dec << " GB/s";
+    }
+    return 0;
+}
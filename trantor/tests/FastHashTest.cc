@@ -0,0 +1,75 @@
+#include <trantor/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Compare trantor::utils::fastHash64 with std::hash<std::string>, both on raw
+// hashing throughput and as the hasher of an unordered_map with string keys.
+
+template <typename F>
+static double measure(const std::vector<std::string> &keys,
+                      size_t rounds,
+                      F &&func)
+{
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        for (auto &key : keys)
+            sink += func(key);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    LOG_TRACE << sink;
+    return static_cast<double>(elapsed) /
+           static_cast<double>(rounds * keys.size());
+}
+
+int main()
+{
+    for (size_t len : {8, 16, 32, 64, 256, 4096})
+    {
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < 1024; ++i)
+        {
+            std::string key(len, 'a');
+            for (size_t j = 0; j < len; ++j)
+                key[j] = static_cast<char>('a' + (i * 31 + j * 7) % 26);
+            keys.push_back(std::move(key));
+        }
+        size_t rounds = 4 * 1024 * 1024 / (len + 16);
+        auto stdNs = measure(keys, rounds, [](const std::string &key) {
+            return std::hash<std::string>{}(key);
+        });
+        auto fastNs = measure(keys, rounds, [](const std::string &key) {
+            return trantor::utils::StringHash{}(key);
+        });
+        LOG_INFO << "len " << len << ": std::hash " << stdNs
+                 << " ns, fastHash64 " << fastNs << " ns";
+    }
+
+    std::vector<std::string> hostnames;
+    for (size_t i = 0; i < 100000; ++i)
+        hostnames.push_back("host" + std::to_string(i) + ".example.com");
+    std::unordered_map<std::string, size_t> stdMap;
+    std::unordered_map<std::string, size_t, trantor::utils::StringHash>
+        fastMap;
+    for (size_t i = 0; i < hostnames.size(); ++i)
+    {
+        stdMap[hostnames[i]] = i;
+        fastMap[hostnames[i]] = i;
+    }
+    auto stdNs = measure(hostnames, 20, [&](const std::string &key) {
+        return stdMap.find(key)->second;
+    });
+    auto fastNs = measure(hostnames, 20, [&](const std::string &key) {
+        return fastMap.find(key)->second;
+    });
+    LOG_INFO << "unordered_map lookup: std::hash " << stdNs
+             << " ns, StringHash " << fastNs << " ns";
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <trantor/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <string>
+
+// Compare Hmac, which absorbs the key once, with computing HMAC-SHA256 on top
+// of trantor::utils::sha256() for every message.
+
+using namespace trantor::utils;
+
+static Hash256 naiveHmacSha256(const std::string &key, const std::string &data)
+{
+    std::string k = key;
+    if (k.size() > 64)
+        k.assign((const char *)sha256(key).bytes, sizeof(Hash256));
+    k.resize(64, '\0');
+    std::string inner(64, '\0'), outer(64, '\0');
+    for (size_t i = 0; i < 64; ++i)
+    {
+        inner[i] = static_cast<char>(k[i] ^ 0x36);
+        outer[i] = static_cast<char>(k[i] ^ 0x5c);
+    }
+    auto innerHash = sha256(inner + data);
+    return sha256(outer + std::string((const char *)innerHash.bytes,
+                                      sizeof(innerHash)));
+}
+
+template <typename F>
+static double measure(size_t rounds, F &&func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        func();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    return static_cast<double>(elapsed) / static_cast<double>(rounds);
+}
+
+int main()
+{
+    const std::string key = "webhook signing secret";
+    for (size_t len : {32, 256, 4096})
+    {
+        std::string payload(len, 'x');
+        Hmac hmac(HashAlgorithm::SHA256, key);
+        auto expected = naiveHmacSha256(key, payload);
+        if (hmac.sign(payload) !=
+            std::string((const char *)expected.bytes, sizeof(expected)))
+        {
+            LOG_ERROR << "HMAC mismatch";
+            return 1;
+        }
+        size_t rounds = 64 * 1024 * 1024 / (len + 256);
+        size_t sink = 0;
+        auto naiveNs = measure(rounds, [&]() {
+            sink += naiveHmacSha256(key, payload).bytes[0];
+        });
+        unsigned char mac[32];
+        auto hmacNs = measure(rounds, [&]() {
+            hmac.sign(payload.data(), payload.size(), mac);
+            sink += mac[0];
+        });
+        LOG_TRACE << sink;
+        LOG_INFO << "len " << len << ": sha256 based " << naiveNs
+                 << " ns, Hmac " << hmacNs << " ns";
+    }
+    for (auto algorithm : {HashAlgorithm::MD5,
+                           HashAlgorithm::SHA1,
+                           HashAlgorithm::SHA3,
+                           HashAlgorithm::BLAKE2b})
+    {
+        std::string payload(256, 'x');
+        Hmac hmac(algorithm, key);
+        unsigned char mac[32];
+        auto ns = measure(100000, [&]() {
+            hmac.sign(payload.data(), payload.size(), mac);
+        });
+        LOG_INFO << "algorithm " << static_cast<int>(algorithm)
+                 << ", 256 bytes: " << ns << " ns";
+    }
+    return 0;
+}
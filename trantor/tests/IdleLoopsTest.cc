@@ -0,0 +1,98 @@
+#include <trantor/net/EventLoopThreadPool.h>
+#include <trantor/utils/Logger.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Many loops that are idle but for a periodic timer, as on a host running
+// thousands of them. The CPU time of the process and how late the timers
+// fire are measured, to compare builds with and without TRANTOR_USE_TIMERFD.
+//
+// usage: idle_loops_test [loops] [timer interval ms] [seconds]
+
+using namespace trantor;
+
+namespace
+{
+double cpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+struct Lateness
+{
+    std::chrono::steady_clock::time_point next;
+    double total{0};
+    double max{0};
+    size_t count{0};
+};
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    Logger::setLogLevel(Logger::kInfo);
+    const size_t loopNum = argc > 1 ? std::stoul(argv[1]) : 100;
+    const double interval = (argc > 2 ? std::stod(argv[2]) : 5) / 1000;
+    const double seconds = argc > 3 ? std::stod(argv[3]) : 5;
+
+    EventLoopThreadPool pool(loopNum);
+    pool.start();
+    const auto period = std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(interval));
+    std::vector<Lateness> lateness(loopNum);
+    const double cpuBefore = cpuSeconds();
+    for (size_t i = 0; i < loopNum; ++i)
+    {
+        auto loop = pool.getNextLoop();
+        loop->runInLoop([loop, &lateness, i, interval, period]() {
+            auto &l = lateness[i];
+            l.next = std::chrono::steady_clock::now() + period;
+            loop->runEvery(interval, [&l, period]() {
+                auto now = std::chrono::steady_clock::now();
+                double late =
+                    std::chrono::duration<double>(now - l.next).count();
+                l.total += late;
+                l.max = (std::max)(l.max, late);
+                ++l.count;
+                l.next = now + period;
+            });
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    const double cpu = cpuSeconds() - cpuBefore;
+
+    std::atomic<size_t> stopped{0};
+    double total = 0, max = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < loopNum; ++i)
+    {
+        auto loop = pool.getNextLoop();
+        loop->runInLoop([loop, &stopped]() {
+            loop->quit();
+            ++stopped;
+        });
+    }
+    while (stopped.load() < loopNum)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (auto &l : lateness)
+    {
+        total += l.total;
+        max = (std::max)(max, l.max);
+        count += l.count;
+    }
+    LOG_INFO << loopNum << " loops, " << count << " timers fired in "
+             << seconds << " s, " << cpu * 1e6 / count
+             << " us of CPU per timer";
+    LOG_INFO << "timer lateness: average " << total / count * 1e6
+             << " us, max " << max * 1e6 << " us";
+    pool.wait();
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <trantor/net/LoopChannel.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <future>
+#include <memory>
+
+// Pass messages from one loop to another, with runInLoop() and with a
+// LoopChannel, and compare the time it takes.
+
+using namespace trantor;
+
+struct Message
+{
+    uint64_t id;
+    uint64_t payload[3];
+};
+
+template <typename Send>
+static double measure(EventLoop *producer,
+                      size_t total,
+                      std::promise<void> &done,
+                      Send &&send)
+{
+    auto start = std::chrono::steady_clock::now();
+    producer->runInLoop([&]() {
+        for (size_t i = 0; i < total; ++i)
+            send(Message{i, {i, i, i}});
+    });
+    done.get_future().wait();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+               .count();
+}
+
+int main()
+{
+    EventLoopThread producerThread;
+    EventLoopThread consumerThread;
+    producerThread.run();
+    consumerThread.run();
+    auto producer = producerThread.getLoop();
+    auto consumer = consumerThread.getLoop();
+    const size_t total = 2000000;
+
+    for (int round = 0; round < 3; ++round)
+    {
+        uint64_t sum = 0;
+        size_t received = 0;
+        std::promise<void> queued;
+        auto handle = [&](const Message &msg) {
+            sum += msg.payload[0];
+            if (++received == total)
+                queued.set_value();
+        };
+        double funcSeconds = measure(producer, total, queued, [&](Message msg) {
+            consumer->runInLoop([&handle, msg]() { handle(msg); });
+        });
+
+        received = 0;
+        std::promise<void> channelDone;
+        auto channel =
+            std::make_shared<LoopChannel<Message>>(producer, consumer, 4096);
+        channel->setHandler([&](Message &&msg) {
+            sum += msg.payload[0];
+            if (++received == total)
+                channelDone.set_value();
+        });
+        double channelSeconds =
+            measure(producer, total, channelDone, [&](Message msg) {
+                channel->send(std::move(msg));
+            });
+        LOG_INFO << total << " messages: runInLoop "
+                 << funcSeconds * 1e9 / total << " ns/msg, LoopChannel "
+                 << channelSeconds * 1e9 / total
+                 << " ns/msg (" << sum << ")";
+    }
+    return 0;
+}
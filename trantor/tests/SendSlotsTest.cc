@@ -0,0 +1,99 @@
+#include <trantor/net/TcpServer.h>
+#include <trantor/net/TcpClient.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/ConcurrentTaskQueue.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+// A client pipelines numbered requests, the server processes them on a pool
+// of worker threads, each taking some time, and responds through send slots.
+// The client checks the responses arrive in the order of the requests.
+//
+// usage: send_slots_test [requests] [worker threads]
+
+using namespace trantor;
+
+int main(int argc, char *argv[])
+{
+    Logger::setLogLevel(Logger::kInfo);
+    const size_t requestNum = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const size_t threadNum = argc > 2 ? std::stoul(argv[2]) : 4;
+
+    ConcurrentTaskQueue workers(threadNum, "workers");
+    EventLoopThread serverThread;
+    serverThread.run();
+    InetAddress addr("127.0.0.1", 8897);
+    TcpServer server(serverThread.getLoop(), addr, "send_slots");
+    server.setRecvMessageCallback([&workers](const TcpConnectionPtr &conn,
+                                             MsgBuffer *buffer) {
+        while (const char *eol = buffer->findCRLF())
+        {
+            std::string request(buffer->peek(), eol);
+            buffer->retrieveUntil(eol + 2);
+            auto slot = conn->reserveSendSlot();
+            workers.runTaskInQueue([conn, slot, request]() {
+                // Some requests take longer than the following ones
+                std::this_thread::sleep_for(
+                    std::chrono::microseconds(std::stoul(request) % 7 * 20));
+                conn->fillSendSlot(slot, request + "\r\n");
+            });
+        }
+    });
+    serverThread.getLoop()->runInLoop([&server]() { server.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EventLoop loop;
+    auto client =
+        std::make_shared<TcpClient>(&loop, addr, "send_slots_client");
+    size_t next = 0;
+    bool inOrder = true;
+    auto start = std::chrono::steady_clock::now();
+    client->setConnectionCallback(
+        [requestNum, &start](const TcpConnectionPtr &conn) {
+            if (!conn->connected())
+                return;
+            std::string requests;
+            for (size_t i = 0; i < requestNum; ++i)
+                requests += std::to_string(i) + "\r\n";
+            start = std::chrono::steady_clock::now();
+            conn->send(std::move(requests));
+        });
+    client->setMessageCallback(
+        [&](const TcpConnectionPtr &, MsgBuffer *buffer) {
+            while (const char *eol = buffer->findCRLF())
+            {
+                std::string response(buffer->peek(), eol);
+                buffer->retrieveUntil(eol + 2);
+                if (response != std::to_string(next))
+                {
+                    LOG_ERROR << "expected response " << next << ", got "
+                              << response;
+                    inOrder = false;
+                    loop.quit();
+                    return;
+                }
+                if (++next == requestNum)
+                    loop.quit();
+            }
+        });
+    client->connect();
+    loop.loop();
+
+    if (!inOrder)
+        return 1;
+    LOG_INFO << requestNum << " pipelined requests on " << threadNum
+             << " worker threads answered in order in "
+             << std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                        .count() *
+                    1000
+             << " ms";
+    client->disconnect();
+    serverThread.getLoop()->runInLoop([&server]() { server.stop(); });
+    serverThread.getLoop()->quit();
+    serverThread.wait();
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <trantor/utils/Logger.h>
+#include <trantor/utils/AsyncFileLogger.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Three loggers, for the default output and the indexed outputs 1 and 2,
+// share one writing thread. Each of them writes its own files.
+//
+// usage: shared_log_writer_test
+
+int main()
+{
+    auto writer = std::make_shared<trantor::AsyncFileLogWriter>();
+    std::vector<std::unique_ptr<trantor::AsyncFileLogger>> loggers;
+    for (auto name : {"shared_main", "shared_access", "shared_audit"})
+    {
+        loggers.emplace_back(new trantor::AsyncFileLogger);
+        loggers.back()->setFileName(name);
+        loggers.back()->startLogging(writer);
+    }
+    const int indexes[] = {-1, 1, 2};
+    for (size_t i = 0; i < loggers.size(); ++i)
+    {
+        auto logger = loggers[i].get();
+        trantor::Logger::setOutputFunction(
+            [logger](const char *msg, const uint64_t len) {
+                logger->output(msg, len);
+            },
+            [logger]() { logger->flush(); },
+            indexes[i]);
+    }
+    auto start = std::chrono::steady_clock::now();
+    const int threadNum = 4;
+    const int logNum = 200000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadNum; ++t)
+    {
+        threads.emplace_back([t, logNum]() {
+            for (int i = 0; i < logNum; ++i)
+            {
+                LOG_INFO << "thread " << t << ": this is the " << i
+                         << "th log";
+                LOG_INFO_TO(1) << "GET /index.html 200 " << i;
+                if (i % 10 == 0)
+                    LOG_WARN_TO(2) << "thread " << t << " audit " << i;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+    LOG_INFO << threadNum * (logNum * 2 + logNum / 10) << " logs in " << us
+             << " us";
+    // Let the writer flush the partially filled buffers
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    for (auto index : indexes)
+        trantor::Logger::setOutputFunction(
+            [](const char *, const uint64_t) {}, []() {}, index);
+    loggers.clear();
+}
@@ -0,0 +1,132 @@
+#include <trantor/net/ShmClient.h>
+#include <trantor/net/ShmServer.h>
+#include <trantor/net/TcpClient.h>
+#include <trantor/net/TcpServer.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Echo servers over loopback TCP and over shared memory, in another thread of
+// the same process. A client measures the round trip of small messages, then
+// the time to echo a large amount of data.
+//
+// usage: shm_transport_test [round trips] [bulk megabytes]
+
+using namespace trantor;
+using namespace std::chrono;
+
+template <typename Client>
+void runClient(const std::shared_ptr<Client> &client,
+               EventLoop &loop,
+               size_t roundTrips,
+               size_t bulkBytes)
+{
+    const std::string ping(64, 'p');
+    const std::string chunk(64 * 1024, 'b');
+    size_t trips = 0;
+    size_t received = 0;
+    bool bulk = false;
+    auto start = steady_clock::now();
+    client->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if (!conn->connected())
+        {
+            loop.quit();
+            return;
+        }
+        conn->setTcpNoDelay(true);
+        start = steady_clock::now();
+        conn->send(ping);
+    });
+    client->setMessageCallback([&](const TcpConnectionPtr &conn,
+                                   MsgBuffer *buffer) {
+        received += buffer->readableBytes();
+        buffer->retrieveAll();
+        if (!bulk)
+        {
+            if (received < ping.size())
+                return;
+            received = 0;
+            if (++trips < roundTrips)
+            {
+                conn->send(ping);
+                return;
+            }
+            auto us = duration_cast<nanoseconds>(steady_clock::now() - start)
+                          .count() /
+                      1000.0 / roundTrips;
+            LOG_INFO << "  round trip: " << us << " us";
+            bulk = true;
+            start = steady_clock::now();
+            for (size_t sent = 0; sent < bulkBytes; sent += chunk.size())
+                conn->send(chunk);
+            return;
+        }
+        if (received < bulkBytes)
+            return;
+        auto ms =
+            duration_cast<milliseconds>(steady_clock::now() - start).count();
+        LOG_INFO << "  echo of " << bulkBytes / (1024 * 1024)
+                 << " MB: " << ms << " ms";
+        conn->forceClose();
+    });
+    client->connect();
+    loop.loop();
+}
+
+int main(int argc, char *argv[])
+{
+    Logger::setLogLevel(Logger::kInfo);
+    const size_t roundTrips = argc > 1 ? std::stoul(argv[1]) : 20000;
+    const size_t bulkBytes =
+        (argc > 2 ? std::stoul(argv[2]) : 256) * 1024 * 1024;
+    const std::string path = "/tmp/trantor_shm_transport_test.sock";
+
+    EventLoopThread serverThread;
+    serverThread.run();
+    auto serverLoop = serverThread.getLoop();
+    auto echo = [](const TcpConnectionPtr &conn, MsgBuffer *buffer) {
+        conn->send(buffer->peek(), buffer->readableBytes());
+        buffer->retrieveAll();
+    };
+    InetAddress addr("127.0.0.1", 8899);
+    TcpServer tcpServer(serverLoop, addr, "tcp_echo");
+    tcpServer.setRecvMessageCallback(echo);
+    ShmServer shmServer(serverLoop, path, "shm_echo");
+    shmServer.setRecvMessageCallback(echo);
+    serverLoop->runInLoop([&]() {
+        tcpServer.start();
+        shmServer.start();
+    });
+    std::this_thread::sleep_for(milliseconds(100));
+
+    {
+        LOG_INFO << "loopback TCP:";
+        EventLoop loop;
+        auto client = std::make_shared<TcpClient>(&loop, addr, "tcp_client");
+        runClient(client, loop, roundTrips, bulkBytes);
+    }
+    {
+        LOG_INFO << "shared memory:";
+        EventLoop loop;
+        auto client = std::make_shared<ShmClient>(&loop, path, "shm_client");
+        client->setConnectionErrorCallback([&loop]() {
+            LOG_ERROR << "Can't connect to the shared memory server";
+            loop.quit();
+        });
+        runClient(client, loop, roundTrips, bulkBytes);
+    }
+
+    // The server loop may still be echoing, wait until the servers stop
+    std::promise<void> stopped;
+    serverLoop->runInLoop([&]() {
+        shmServer.stop();
+        tcpServer.stop();
+        stopped.set_value();
+    });
+    stopped.get_future().wait();
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <trantor/net/UpstreamBalancer.h>
+#include <trantor/net/TcpServer.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/Logger.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+// Three upstreams answer "ok" to every line: a fast one, a slow one and one
+// that answers "err". The balancer should send most requests to the fast one
+// and eject the failing one.
+
+using namespace trantor;
+
+int main()
+{
+    trantor::Logger::setLogLevel(trantor::Logger::kInfo);
+    EventLoopThread serverThread;
+    serverThread.run();
+    auto serverLoop = serverThread.getLoop();
+
+    const uint16_t basePort = 8891;
+    std::vector<std::shared_ptr<TcpServer>> servers;
+    std::vector<InetAddress> endpoints;
+    for (uint16_t i = 0; i < 3; ++i)
+    {
+        InetAddress addr("127.0.0.1", basePort + i);
+        endpoints.push_back(addr);
+        auto server = std::make_shared<TcpServer>(serverLoop,
+                                                  addr,
+                                                  "upstream" +
+                                                      std::to_string(i));
+        server->setRecvMessageCallback(
+            [i, serverLoop](const TcpConnectionPtr &conn, MsgBuffer *buf) {
+                while (auto eol = buf->findCRLF())
+                {
+                    buf->retrieveUntil(eol + 2);
+                    if (i == 0)
+                        conn->send("ok\r\n");
+                    else if (i == 1)
+                        serverLoop->runAfter(0.005, [conn]() {
+                            conn->send("ok\r\n");
+                        });
+                    else
+                        conn->send("err\r\n");
+                }
+            });
+        serverLoop->runInLoop([server]() { server->start(); });
+        servers.push_back(std::move(server));
+    }
+
+    EventLoop loop;
+    auto balancer = std::make_shared<UpstreamBalancer>(&loop, "balancer");
+    balancer->setLoadMetric(UpstreamBalancer::LoadMetric::Latency);
+    balancer->setOutlierEjection(5, 10.0);
+
+    // Responses come back in order on each connection
+    std::map<TcpConnection *, std::deque<UpstreamBalancer::Request>> inflight;
+    std::map<std::string, size_t> answered;
+    const size_t total = 20000;
+    const size_t concurrency = 32;
+    size_t sent = 0;
+    size_t done = 0;
+    size_t failed = 0;
+    std::function<void()> sendOne = [&]() {
+        auto request = balancer->pick(5);
+        if (!request)
+        {
+            loop.runAfter(0.01, sendOne);
+            return;
+        }
+        ++sent;
+        request.connection()->send("req\r\n");
+        inflight[request.connection().get()].push_back(std::move(request));
+    };
+    balancer->setMessageCallback(
+        [&](const TcpConnectionPtr &conn, MsgBuffer *buf) {
+            auto &queue = inflight[conn.get()];
+            while (auto eol = buf->findCRLF())
+            {
+                const bool ok = std::string(buf->peek(), eol) == "ok";
+                buf->retrieveUntil(eol + 2);
+                balancer->finish(queue.front(), ok);
+                queue.pop_front();
+                ++answered[conn->peerAddr().toIpPort()];
+                if (!ok)
+                    ++failed;
+                if (++done == total)
+                {
+                    loop.quit();
+                    return;
+                }
+                if (sent < total)
+                    sendOne();
+            }
+        });
+    balancer->setEndpoints(endpoints);
+
+    auto start = Date::now();
+    loop.runAfter(0.5, [&]() {
+        start = Date::now();
+        for (size_t i = 0; i < concurrency; ++i)
+            sendOne();
+    });
+    loop.loop();
+
+    const double seconds = Date::now().microSecondsSinceEpoch() / 1e6 -
+                           start.microSecondsSinceEpoch() / 1e6;
+    LOG_INFO << total << " requests in " << seconds << " s, " << failed
+             << " failed";
+    for (auto &stats : balancer->endpointStats())
+    {
+        LOG_INFO << stats.address.toIpPort() << ": "
+                 << answered[stats.address.toIpPort()] << " requests, latency "
+                 << stats.latency * 1e6 << " us"
+                 << (stats.ejected ? ", ejected" : "");
+    }
+    balancer.reset();
+    for (auto &server : servers)
+        serverLoop->runInLoop([server]() { server->stop(); });
+    servers.clear();
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <trantor/net/AsyncFile.h>
+#include <trantor/net/EventLoopThread.h>
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <future>
+#include <string>
+#include <vector>
+using namespace trantor;
+
+namespace
+{
+AsyncFilePtr openFile(EventLoop *loop, const std::string &path, int flags)
+{
+    std::promise<AsyncFilePtr> opened;
+    AsyncFile::open(loop, path, flags, [&](const AsyncFilePtr &file, int) {
+        opened.set_value(file);
+    });
+    return opened.get_future().get();
+}
+}  // namespace
+
+TEST(AsyncFile, OpenMissingFile)
+{
+    EventLoopThread thread;
+    thread.run();
+    std::promise<int> result;
+    AsyncFile::open(thread.getLoop(),
+                    "/nonexistent/async_file_unittest",
+                    O_RDONLY,
+                    [&](const AsyncFilePtr &file, int err) {
+                        EXPECT_EQ(nullptr, file);
+                        result.set_value(err);
+                    });
+    EXPECT_EQ(ENOENT, result.get_future().get());
+}
+
+TEST(AsyncFile, WriteReadBack)
+{
+    EventLoopThread thread;
+    thread.run();
+    auto loop = thread.getLoop();
+    const std::string path = "async_file_unittest.tmp";
+    auto file = openFile(loop, path, O_RDWR | O_CREAT | O_TRUNC);
+    ASSERT_NE(nullptr, file);
+
+    // More writes than fit in the rings at once, followed by a large one
+    const size_t chunks = 1000;
+    const size_t chunkSize = 100;
+    const std::string large(8 * 1024 * 1024, 'L');
+    std::promise<void> written;
+    size_t pending = chunks + 1;
+    bool allWritten = true;
+    loop->runInLoop([&]() {
+        for (size_t i = 0; i < chunks; ++i)
+        {
+            file->write(i * chunkSize,
+                        std::string(chunkSize, static_cast<char>('a' + i % 26)),
+                        [&](ssize_t n) {
+                            allWritten = allWritten && n == (ssize_t)chunkSize;
+                            if (--pending == 0)
+                                written.set_value();
+                        });
+        }
+        file->write(chunks * chunkSize,
+                    large.data(),
+                    large.size(),
+                    [&](ssize_t n) {
+                        allWritten = allWritten && n == (ssize_t)large.size();
+                        if (--pending == 0)
+                            written.set_value();
+                    });
+    });
+    written.get_future().get();
+    EXPECT_TRUE(allWritten);
+
+    std::promise<ssize_t> synced;
+    file->fsync([&](ssize_t result) { synced.set_value(result); }, true);
+    EXPECT_EQ(0, synced.get_future().get());
+
+    // Read across the end of the file
+    const size_t offset = chunks * chunkSize - chunkSize;
+    std::vector<char> buffer(chunkSize + large.size() + 100);
+    std::promise<ssize_t> read;
+    file->read(offset, buffer.data(), buffer.size(), [&](ssize_t n) {
+        read.set_value(n);
+    });
+    ASSERT_EQ(static_cast<ssize_t>(chunkSize + large.size()),
+              read.get_future().get());
+    EXPECT_EQ(std::string(chunkSize, static_cast<char>('a' + 999 % 26)),
+              std::string(buffer.data(), chunkSize));
+    EXPECT_EQ(large, std::string(buffer.data() + chunkSize, large.size()));
+
+    std::promise<void> released;
+    loop->runInLoop([&]() {
+        file.reset();
+        released.set_value();
+    });
+    released.get_future().get();
+    ::remove(path.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,83 @@
+#include <trantor/utils/BufferPool.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+using namespace trantor;
+
+TEST(BufferPool, HugePages)
+{
+    // Allocated before the pool, freed to operator delete
+    MsgBuffer before;
+    before.append(std::string(100, 'a'));
+    EXPECT_FALSE(BufferPool::contains(before.peek()));
+
+#ifdef __linux__
+    ASSERT_TRUE(BufferPool::enableHugePages(false, size_t(64) << 20));
+    EXPECT_FALSE(BufferPool::enableHugePages());
+    EXPECT_TRUE(BufferPool::hugePagesEnabled());
+
+    MsgBuffer buffer;
+    EXPECT_TRUE(BufferPool::contains(buffer.peek()));
+    // Grow past a huge page, to a block given back to the system when freed
+    const std::string data(5 << 20, 'x');
+    buffer.append(data);
+    EXPECT_TRUE(BufferPool::contains(buffer.peek()));
+    EXPECT_EQ(data, std::string(buffer.peek(), buffer.readableBytes()));
+
+    auto view = buffer.readView(data.size());
+    before.append(std::string(1 << 20, 'b'));
+    EXPECT_EQ(data, view.toString());
+    view = MsgBufferView();
+
+    // Freed blocks are reused
+    const char *first;
+    {
+        MsgBuffer small;
+        first = small.peek();
+    }
+    MsgBuffer small;
+    EXPECT_EQ(first, small.peek());
+
+    std::vector<MsgBuffer> buffers(1000);
+    for (auto &b : buffers)
+    {
+        b.append(std::string(3000, 'c'));
+        EXPECT_TRUE(BufferPool::contains(b.peek()));
+    }
+    // Large blocks of varying sizes are split from the freed ones, and
+    // merged again, so cycling through them doesn't exhaust the range
+    std::vector<std::pair<void *, size_t>> blocks;
+    for (size_t i = 0; i < 300; ++i)
+    {
+        const size_t size = ((i * 7) % 13 + 2) << 20;
+        auto block = BufferPool::allocate(size);
+        EXPECT_TRUE(BufferPool::contains(block)) << i;
+        blocks.emplace_back(block, size);
+        if (blocks.size() > 1)
+        {
+            BufferPool::deallocate(blocks.front().first,
+                                   blocks.front().second);
+            blocks.erase(blocks.begin());
+        }
+    }
+    for (auto &block : blocks)
+        BufferPool::deallocate(block.first, block.second);
+    auto merged = BufferPool::allocate(size_t(30) << 20);
+    EXPECT_TRUE(BufferPool::contains(merged));
+    BufferPool::deallocate(merged, size_t(30) << 20);
+
+    // Full, allocated from operator new
+    auto huge = BufferPool::allocate(size_t(128) << 20);
+    EXPECT_FALSE(BufferPool::contains(huge));
+    BufferPool::deallocate(huge, size_t(128) << 20);
+#else
+    EXPECT_FALSE(BufferPool::enableHugePages());
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
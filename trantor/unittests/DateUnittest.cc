@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <iostream>
+#include <stdlib.h>
+#include <time.h>
 using namespace trantor;
 TEST(Date, constructorTest)
 {
@@ -107,6 +109,115 @@ TEST(Date, DatabaseStringTest)
     us = (dbDate.microSecondsSinceEpoch() % 1000000);
     EXPECT_EQ(us, 3);
 }
+#ifndef _WIN32
+TEST(Date, LocalTimeCacheTest)
+{
+    const char *oldTz = getenv("TZ");
+    std::string savedTz = oldTz ? oldTz : "";
+    // US eastern time with DST, no tzdata needed
+    setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+    tzset();
+    trantor::Date::resetLocalTimeZoneCache();
+
+    auto expected = [](int64_t seconds) {
+        time_t t = static_cast<time_t>(seconds);
+        struct tm tmTime;
+        localtime_r(&t, &tmTime);
+        char buf[64];
+        strftime(buf, sizeof(buf), "%Y%m%d %H:%M:%S", &tmTime);
+        return std::string(buf);
+    };
+    // 2021-03-14 07:00:00 UTC is the spring forward transition
+    const int64_t springForward = 1615705200LL;
+    // 2021-11-07 06:00:00 UTC is the fall back transition
+    const int64_t fallBack = 1636264800LL;
+    for (int64_t base : {springForward, fallBack})
+    {
+        for (int64_t s = base - 7200; s <= base + 7200; s += 599)
+        {
+            EXPECT_EQ(expected(s),
+                      trantor::Date(s * MICRO_SECONDS_PRE_SEC)
+                          .toFormattedStringLocal(false));
+        }
+        EXPECT_EQ(expected(base - 1),
+                  trantor::Date((base - 1) * MICRO_SECONDS_PRE_SEC)
+                      .toFormattedStringLocal(false));
+        EXPECT_EQ(expected(base),
+                  trantor::Date(base * MICRO_SECONDS_PRE_SEC)
+                      .toFormattedStringLocal(false));
+    }
+    // Walk over several years, jumping back and forth
+    for (int64_t s = 315532800LL; s < 2208988800LL; s += 86400LL * 37 + 3607)
+    {
+        EXPECT_EQ(expected(s),
+                  trantor::Date(s * MICRO_SECONDS_PRE_SEC)
+                      .toFormattedStringLocal(false));
+        EXPECT_EQ(expected(springForward),
+                  trantor::Date(springForward * MICRO_SECONDS_PRE_SEC)
+                      .toFormattedStringLocal(false));
+    }
+    // Midnight of a DST day
+    EXPECT_STREQ("2021-07-01 00:00:00",
+                 trantor::Date(2021, 7, 1, 15, 30)
+                     .roundDay()
+                     .toCustomFormattedStringLocal("%Y-%m-%d %H:%M:%S")
+                     .c_str());
+    EXPECT_EQ(trantor::Date(2021, 7, 1),
+              trantor::Date(2021, 7, 1, 15).roundDay());
+    EXPECT_EQ(trantor::Date(2021, 12, 1),
+              trantor::Date(2021, 12, 1, 23, 59, 59).roundDay());
+
+    if (oldTz)
+        setenv("TZ", savedTz.c_str(), 1);
+    else
+        unsetenv("TZ");
+    tzset();
+    trantor::Date::resetLocalTimeZoneCache();
+}
+
+TEST(Date, LocalTimeShortDstTest)
+{
+    const char *oldTz = getenv("TZ");
+    std::string savedTz = oldTz ? oldTz : "";
+    // DST for two days only, from the 100th to the 102nd day of the year
+    setenv("TZ", "XST0XDT,J100,J102", 1);
+    tzset();
+    trantor::Date::resetLocalTimeZoneCache();
+
+    auto expected = [](int64_t seconds) {
+        time_t t = static_cast<time_t>(seconds);
+        struct tm tmTime;
+        localtime_r(&t, &tmTime);
+        char buf[64];
+        strftime(buf, sizeof(buf), "%Y%m%d %H:%M:%S", &tmTime);
+        return std::string(buf);
+    };
+    // Walk forward and backward over 2021-04-10, with steps that extend the
+    // cached period
+    const int64_t dstStart = 1618020000LL;
+    for (int64_t s = dstStart - 86400LL * 5; s < dstStart + 86400LL * 5;
+         s += 1801)
+    {
+        EXPECT_EQ(expected(s),
+                  trantor::Date(s * MICRO_SECONDS_PRE_SEC)
+                      .toFormattedStringLocal(false));
+    }
+    for (int64_t s = dstStart + 86400LL * 5; s > dstStart - 86400LL * 5;
+         s -= 1801)
+    {
+        EXPECT_EQ(expected(s),
+                  trantor::Date(s * MICRO_SECONDS_PRE_SEC)
+                      .toFormattedStringLocal(false));
+    }
+
+    if (oldTz)
+        setenv("TZ", savedTz.c_str(), 1);
+    else
+        unsetenv("TZ");
+    tzset();
+    trantor::Date::resetLocalTimeZoneCache();
+}
+#endif
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -2,7 +2,10 @@
 
 #include <trantor/utils/Utilities.h>
 
+#include <set>
+#include <string.h>
 #include <string>
+#include <vector>
 #include <iostream>
 using namespace trantor;
 using namespace trantor::utils;
@@ -51,6 +54,263 @@ TEST(Hash, BLAKE2b)
         "2D03B3D7E76C52DD7A32689ADE4406798B50BC5B09428E3F90F56182898873C8");
 }
 
+TEST(Hash, FastHash)
+{
+    // Every length goes through a different tail path of the algorithm
+    std::string data(200, '\0');
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>(i * 7 + 1);
+    std::set<uint64_t> hashes;
+    for (size_t len = 0; len <= data.size(); ++len)
+    {
+        auto h = fastHash64(data.data(), len);
+        EXPECT_EQ(h, fastHash64(std::string(data.data(), len)));
+        hashes.insert(h);
+    }
+    EXPECT_EQ(hashes.size(), data.size() + 1);
+
+    const std::string trantor = "trantor";
+    EXPECT_NE(fastHash64(trantor),
+              fastHash64(trantor.data(), trantor.size(), 1));
+    EXPECT_NE(fastHash64("trantor"), fastHash64("Trantor"));
+    // Flipping any bit changes the hash
+    auto base = fastHash64(data);
+    for (size_t i = 0; i < data.size(); i += 13)
+    {
+        auto flipped = data;
+        flipped[i] ^= 0x10;
+        EXPECT_NE(base, fastHash64(flipped));
+    }
+
+    auto h128 = fastHash128("hello");
+    auto low = fastHash64("hello");
+    uint64_t lowPart = 0;
+    for (int i = 7; i >= 0; --i)
+        lowPart = (lowPart << 8) | h128.bytes[i];
+    EXPECT_EQ(lowPart, low);
+    EXPECT_NE(toHexString(fastHash128("hello")),
+              toHexString(fastHash128("hello", 5, 42)));
+    EXPECT_EQ(StringHash{}("hello"), static_cast<size_t>(low));
+}
+
+TEST(Hash, FastHashKnownAnswers)
+{
+    // The test vectors of the reference wyhash (final version 4), the seed
+    // of each vector is its index
+    struct
+    {
+        const char *data;
+        uint64_t hash;
+    } vectors[] = {
+        {"", 0x93228a4de0eec5a2ull},
+        {"a", 0xc5bac3db178713c4ull},
+        {"abc", 0xa97f2f7b1d9b3314ull},
+        {"message digest", 0x786d1f1df3801df4ull},
+        {"abcdefghijklmnopqrstuvwxyz", 0xdca5a8138ad37c87ull},
+        {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+         0xb9e734f117cfaf70ull},
+        {"123456789012345678901234567890123456789012345678901234567890123456"
+         "78901234567890",
+         0x6cc5eab49a92d617ull},
+    };
+    for (uint64_t seed = 0; seed < sizeof(vectors) / sizeof(vectors[0]);
+         ++seed)
+    {
+        auto &v = vectors[seed];
+        EXPECT_EQ(fastHash64(v.data, strlen(v.data), seed), v.hash);
+    }
+    EXPECT_EQ(fastHash64("a"), fastHash64("a", 1, 0));
+}
+
+TEST(Hash, Hmac)
+{
+    const std::string data = "what do ya want for nothing?";
+    const std::string longKey(200, '\xaa');
+    struct
+    {
+        HashAlgorithm algorithm;
+        const char *mac;
+        const char *longKeyMac;
+    } vectors[] = {
+        {HashAlgorithm::MD5,
+         "750C783E6AB0B503EAA86E310A5DB738",
+         "D2A56B2BB938CFD94EA3AC18265178A7"},
+        {HashAlgorithm::SHA1,
+         "EFFCDF6AE5EB2FA2D27416D5F184DF9C259A7C79",
+         "E9456775243B29A73E31B13C1DACB3154F7DE601"},
+        {HashAlgorithm::SHA256,
+         "5BDCC146BF60754E6A042426089575C75A003F089D2739839DEC58B964EC3843",
+         "236DC696F86D22507D0019971024037BC617B123867784DE342136DE829694B2"},
+        {HashAlgorithm::SHA3,
+         "C7D4072E788877AE3596BBB0DA73B887C9171F93095B294AE857FBE2645E1BA5",
+         "1385879C388E876B30AE6386A301518508BF6B3199FDB120F222F5342FF4C898"},
+        // keyed BLAKE2b-256
+        {HashAlgorithm::BLAKE2b,
+         "44A4B7E70BB4DCF7416A764DDBC4485238283605DD7781DC1EA7E1CE22707834",
+         "4E85B2FC83D637DC39D07839B3AF84F91B2933CD375F21DA7FE6D498CD99B452"},
+    };
+    for (auto &v : vectors)
+    {
+        Hmac hmac(v.algorithm, "Jefe");
+        auto mac = hmac.sign(data);
+        EXPECT_EQ(mac.size(), hmac.digestLength());
+        EXPECT_EQ(toHexString(mac.data(), mac.size()), v.mac);
+        // the key state is reused, signing again gives the same result
+        EXPECT_EQ(hmac.sign(data), mac);
+        EXPECT_TRUE(hmac.verify(data, mac));
+        auto bad = mac;
+        bad.back() ^= 1;
+        EXPECT_FALSE(hmac.verify(data, bad));
+        EXPECT_FALSE(hmac.verify(data, mac.substr(0, mac.size() - 1)));
+
+        Hmac longKeyHmac(v.algorithm, longKey);
+        auto longKeyMac = longKeyHmac.sign(data);
+        EXPECT_EQ(toHexString(longKeyMac.data(), longKeyMac.size()),
+                  v.longKeyMac);
+
+        // copies are independent, moved objects keep the key
+        Hmac copy(hmac);
+        EXPECT_EQ(copy.sign(data), mac);
+        copy = longKeyHmac;
+        EXPECT_EQ(copy.sign(data), longKeyMac);
+        Hmac moved(std::move(copy));
+        EXPECT_EQ(moved.sign(data), longKeyMac);
+
+        std::vector<std::string> messages{data, "", "trantor", data};
+        auto macs = hmac.signBatch(messages);
+        ASSERT_EQ(macs.size(), messages.size());
+        std::string flat(messages.size() * hmac.digestLength(), '\0');
+        std::vector<const void *> ptrs;
+        std::vector<size_t> lens;
+        for (auto &m : messages)
+        {
+            ptrs.push_back(m.data());
+            lens.push_back(m.size());
+        }
+        hmac.signBatch(ptrs.data(), lens.data(), messages.size(), &flat[0]);
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            EXPECT_EQ(macs[i], hmac.sign(messages[i]));
+            EXPECT_EQ(flat.substr(i * hmac.digestLength(),
+                                  hmac.digestLength()),
+                      macs[i]);
+        }
+        EXPECT_EQ(macs[0], mac);
+        EXPECT_NE(macs[1], macs[2]);
+    }
+}
+
+TEST(Encoding, Hex)
+{
+    EXPECT_EQ(toHexString("\x01\xab\xff", 3), "01ABFF");
+    char lower[6];
+    toHexString("\x01\xab\xff", 3, lower, true);
+    EXPECT_EQ(std::string(lower, 6), "01abff");
+
+    // Long enough inputs go through the vectorized code, check every tail
+    static const char digits[] = "0123456789abcdef";
+    for (size_t len = 0; len <= 100; ++len)
+    {
+        std::string data(len, '\0');
+        std::string expected;
+        for (size_t i = 0; i < len; ++i)
+        {
+            data[i] = static_cast<char>(i * 37 + len);
+            expected += digits[(unsigned char)data[i] >> 4];
+            expected += digits[(unsigned char)data[i] & 0xf];
+        }
+        std::string hex(len * 2, '\0');
+        toHexString(data.data(), len, &hex[0], true);
+        EXPECT_EQ(hex, expected);
+
+        std::string decoded;
+        EXPECT_TRUE(fromHexString(hex, decoded));
+        EXPECT_EQ(decoded, data);
+        EXPECT_TRUE(fromHexString(toHexString(data.data(), len), decoded));
+        EXPECT_EQ(decoded, data);
+        // An invalid character is found wherever it is
+        for (size_t i = 0; i < hex.size(); i += 7)
+        {
+            auto bad = hex;
+            bad[i] = 'g';
+            EXPECT_FALSE(fromHexString(bad, decoded));
+            bad[i] = ':';
+            EXPECT_FALSE(fromHexString(bad, decoded));
+        }
+    }
+    std::string out;
+    EXPECT_FALSE(fromHexString("abc", out));
+}
+
+TEST(Encoding, Base64)
+{
+    // RFC 4648 test vectors
+    const char *vectors[][2] = {{"", ""},
+                                {"f", "Zg=="},
+                                {"fo", "Zm8="},
+                                {"foo", "Zm9v"},
+                                {"foob", "Zm9vYg=="},
+                                {"fooba", "Zm9vYmE="},
+                                {"foobar", "Zm9vYmFy"}};
+    for (auto &v : vectors)
+    {
+        EXPECT_EQ(base64Encode(std::string(v[0])), v[1]);
+        std::string decoded;
+        EXPECT_TRUE(base64Decode(v[1], decoded));
+        EXPECT_EQ(decoded, v[0]);
+    }
+    EXPECT_EQ(base64Encode(std::string("fo"), false, false), "Zm8");
+    EXPECT_EQ(base64Encode(std::string("\xfb\xff"), true), "-_8=");
+    EXPECT_EQ(base64Encode(std::string("\xfb\xff"), false), "+/8=");
+
+    static const char chars[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (size_t len = 0; len <= 100; ++len)
+    {
+        std::string data(len, '\0');
+        for (size_t i = 0; i < len; ++i)
+            data[i] = static_cast<char>(i * 151 + len * 3);
+        std::string expected;
+        for (size_t i = 0; i < len; i += 3)
+        {
+            uint32_t n = (uint32_t)(unsigned char)data[i] << 16;
+            if (i + 1 < len)
+                n |= (uint32_t)(unsigned char)data[i + 1] << 8;
+            if (i + 2 < len)
+                n |= (unsigned char)data[i + 2];
+            expected += chars[n >> 18];
+            expected += chars[(n >> 12) & 0x3f];
+            expected += i + 1 < len ? chars[(n >> 6) & 0x3f] : '=';
+            expected += i + 2 < len ? chars[n & 0x3f] : '=';
+        }
+        auto encoded = base64Encode(data);
+        EXPECT_EQ(encoded, expected);
+        EXPECT_EQ(encoded.size(), base64EncodedLength(len));
+
+        std::string decoded;
+        EXPECT_TRUE(base64Decode(encoded, decoded));
+        EXPECT_EQ(decoded, data);
+
+        auto urlSafe = base64Encode(data, true, false);
+        EXPECT_EQ(urlSafe.size(), base64EncodedLength(len, false));
+        EXPECT_EQ(urlSafe.find_first_of("+/="), std::string::npos);
+        EXPECT_TRUE(base64Decode(urlSafe, decoded));
+        EXPECT_EQ(decoded, data);
+
+        for (size_t i = 0; i < encoded.size(); i += 5)
+        {
+            auto bad = encoded;
+            bad[i] = '*';
+            EXPECT_FALSE(base64Decode(bad, decoded));
+        }
+    }
+    std::string out;
+    EXPECT_FALSE(base64Decode("Zm9vY", out));
+    EXPECT_FALSE(base64Decode("Zg=", out));
+    EXPECT_FALSE(base64Decode("Z===", out));
+    EXPECT_FALSE(base64Decode("Zg==Zg==", out));
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
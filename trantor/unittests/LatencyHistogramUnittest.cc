@@ -0,0 +1,133 @@
+#include <trantor/utils/LatencyHistogram.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace trantor;
+
+TEST(LatencyHistogram, Buckets)
+{
+    // Exact below 64, then 32 buckets per power of two
+    for (uint64_t v = 0; v < 64; ++v)
+    {
+        EXPECT_EQ(v, LatencyHistogram::bucketIndex(v));
+        EXPECT_EQ(v, LatencyHistogram::bucketUpperBound(v));
+    }
+    EXPECT_EQ(64, LatencyHistogram::bucketIndex(64));
+    EXPECT_EQ(64, LatencyHistogram::bucketIndex(65));
+    EXPECT_EQ(65, LatencyHistogram::bucketIndex(66));
+    EXPECT_EQ(96, LatencyHistogram::bucketIndex(128));
+    EXPECT_EQ(LatencyHistogram::kBucketCount - 1,
+              LatencyHistogram::bucketIndex(UINT64_MAX));
+    EXPECT_EQ(UINT64_MAX,
+              LatencyHistogram::bucketUpperBound(
+                  LatencyHistogram::kBucketCount - 1));
+    // The buckets are contiguous and the error is bounded
+    for (size_t i = 64; i < LatencyHistogram::kBucketCount; ++i)
+    {
+        auto lower = LatencyHistogram::bucketUpperBound(i - 1) + 1;
+        auto upper = LatencyHistogram::bucketUpperBound(i);
+        EXPECT_EQ(i, LatencyHistogram::bucketIndex(lower));
+        EXPECT_EQ(i, LatencyHistogram::bucketIndex(upper));
+        EXPECT_LE(static_cast<double>(upper - lower),
+                  static_cast<double>(lower) / 32);
+    }
+}
+
+TEST(LatencyHistogram, Percentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.valueAtPercentile(50));
+    EXPECT_EQ(0, histogram.min());
+    for (uint64_t v = 1; v <= 100000; ++v)
+        histogram.record(v);
+    EXPECT_EQ(100000, histogram.count());
+    EXPECT_EQ(1, histogram.min());
+    EXPECT_EQ(100000, histogram.max());
+    EXPECT_DOUBLE_EQ(50000.5, histogram.mean());
+    for (double p : {1.0, 50.0, 90.0, 99.0, 99.9})
+    {
+        auto expected = static_cast<double>(p * 1000);
+        EXPECT_NEAR(expected,
+                    static_cast<double>(histogram.valueAtPercentile(p)),
+                    expected / 32);
+    }
+    EXPECT_EQ(100000, histogram.valueAtPercentile(100));
+    histogram.reset();
+    EXPECT_EQ(0, histogram.count());
+    EXPECT_EQ(0, histogram.max());
+}
+
+TEST(LatencyHistogram, Merge)
+{
+    LatencyHistogram fast;
+    LatencyHistogram slow;
+    fast.record(10, 99);
+    slow.record(1000000);
+    fast.merge(slow);
+    EXPECT_EQ(100, fast.count());
+    EXPECT_EQ(10, fast.min());
+    EXPECT_EQ(1000000, fast.max());
+    EXPECT_EQ(10, fast.valueAtPercentile(99));
+    EXPECT_EQ(1000000, fast.valueAtPercentile(99.5));
+}
+
+TEST(ConcurrentLatencyHistogram, ManyThreads)
+{
+    ConcurrentLatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&histogram, t]() {
+            for (uint64_t i = 0; i < 100000; ++i)
+                histogram.record(t * 1000 + i % 10);
+        });
+    }
+    // Read while the threads record
+    LatencyHistogram partial;
+    histogram.mergeTo(partial);
+    EXPECT_LE(partial.count(), 400000);
+    for (auto &thread : threads)
+        thread.join();
+    LatencyHistogram total;
+    histogram.mergeTo(total);
+    EXPECT_EQ(400000, total.count());
+    EXPECT_EQ(0, total.min());
+    EXPECT_EQ(3009, total.max());
+    histogram.reset();
+    LatencyHistogram empty;
+    histogram.mergeTo(empty);
+    EXPECT_EQ(0, empty.count());
+}
+
+TEST(ConcurrentLatencyHistogram, ShortLived)
+{
+    // Like per-connection histograms, while others stay alive
+    std::vector<std::unique_ptr<ConcurrentLatencyHistogram>> alive;
+    for (int i = 0; i < 50; ++i)
+    {
+        alive.emplace_back(new ConcurrentLatencyHistogram);
+        alive.back()->record(1);
+    }
+    for (int i = 0; i < 10000; ++i)
+    {
+        ConcurrentLatencyHistogram histogram;
+        histogram.record(static_cast<uint64_t>(i));
+        alive[static_cast<size_t>(i) % alive.size()]->record(2);
+        LatencyHistogram merged;
+        histogram.mergeTo(merged);
+        ASSERT_EQ(1, merged.count());
+    }
+    for (auto &histogram : alive)
+    {
+        LatencyHistogram merged;
+        histogram->mergeTo(merged);
+        EXPECT_EQ(201, merged.count());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
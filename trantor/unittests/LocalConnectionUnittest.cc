@@ -0,0 +1,102 @@
+#include <trantor/net/TcpConnection.h>
+#include <trantor/net/EventLoopThread.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <string>
+using namespace trantor;
+
+TEST(LocalConnection, EchoAcrossLoops)
+{
+    EventLoopThread thread1;
+    EventLoopThread thread2;
+    thread1.run();
+    thread2.run();
+    auto pair = TcpConnection::newLocalPair(thread1.getLoop(),
+                                            thread2.getLoop());
+    auto client = pair.first;
+    auto server = pair.second;
+    server->setRecvMsgCallback(
+        [](const TcpConnectionPtr &conn, MsgBuffer *buffer) {
+            conn->send(buffer->peek(), buffer->readableBytes());
+            buffer->retrieveAll();
+        });
+    // More than the inbox holds, so the senders wait for the deliveries
+    std::string data;
+    for (int i = 0; data.size() < 8 * 1024 * 1024; ++i)
+        data += std::to_string(i) + ",";
+    std::string received;
+    std::promise<void> echoed;
+    client->setRecvMsgCallback(
+        [&](const TcpConnectionPtr &, MsgBuffer *buffer) {
+            received.append(buffer->peek(), buffer->readableBytes());
+            buffer->retrieveAll();
+            if (received.size() == data.size())
+                echoed.set_value();
+        });
+    std::promise<void> closed;
+    server->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if (conn->disconnected())
+            closed.set_value();
+    });
+    server->connectEstablished();
+    client->connectEstablished();
+    client->send(data);
+    ASSERT_EQ(std::future_status::ready,
+              echoed.get_future().wait_for(std::chrono::seconds(30)));
+    EXPECT_EQ(data, received);
+    EXPECT_EQ(data.size(), client->bytesSent());
+    EXPECT_EQ(data.size(), server->bytesReceived());
+
+    // Shutting one end down closes the other one
+    client->shutdown();
+    ASSERT_EQ(std::future_status::ready,
+              closed.get_future().wait_for(std::chrono::seconds(30)));
+}
+
+TEST(LocalConnection, SameLoop)
+{
+    EventLoopThread thread;
+    thread.run();
+    auto pair =
+        TcpConnection::newLocalPair(thread.getLoop(), thread.getLoop());
+    std::promise<std::string> reply;
+    pair.second->setRecvMsgCallback(
+        [](const TcpConnectionPtr &conn, MsgBuffer *buffer) {
+            if (buffer->readableBytes() < 4)
+                return;
+            conn->send("pong");
+            buffer->retrieveAll();
+            conn->forceClose();
+        });
+    pair.first->setRecvMsgCallback(
+        [&](const TcpConnectionPtr &, MsgBuffer *buffer) {
+            reply.set_value(buffer->read(buffer->readableBytes()));
+        });
+    std::promise<bool> closed;
+    pair.first->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if (conn->disconnected())
+            closed.set_value(true);
+    });
+    thread.getLoop()->runInLoop([&]() {
+        pair.first->connectEstablished();
+        pair.second->connectEstablished();
+        // Sent before the other end handles its connection
+        pair.first->send("pi");
+        pair.first->send("ng");
+    });
+    auto replyFuture = reply.get_future();
+    ASSERT_EQ(std::future_status::ready,
+              replyFuture.wait_for(std::chrono::seconds(30)));
+    EXPECT_EQ("pong", replyFuture.get());
+    // The data sent before the close is delivered before it
+    auto closedFuture = closed.get_future();
+    ASSERT_EQ(std::future_status::ready,
+              closedFuture.wait_for(std::chrono::seconds(30)));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,85 @@
+#include <trantor/net/LoopChannel.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/LockFreeQueue.h>
+#include <gtest/gtest.h>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace trantor;
+
+TEST(SpscQueue, RingWrapAround)
+{
+    SpscQueue<std::string> queue(3);
+    EXPECT_EQ(4, queue.capacity());
+    std::string out;
+    EXPECT_FALSE(queue.dequeue(out));
+    for (int round = 0; round < 10; ++round)
+    {
+        for (int i = 0; i < 4; ++i)
+            EXPECT_TRUE(queue.enqueue(std::to_string(round * 4 + i)));
+        std::string extra = "extra";
+        EXPECT_FALSE(queue.enqueue(std::move(extra)));
+        EXPECT_EQ("extra", extra);
+        EXPECT_TRUE(queue.dequeue(out));
+        EXPECT_EQ(std::to_string(round * 4), out);
+        std::vector<std::string> rest;
+        auto collect = [&rest](std::string &&s) {
+            rest.push_back(std::move(s));
+        };
+        EXPECT_EQ(3, queue.consume(collect));
+        EXPECT_EQ(std::to_string(round * 4 + 3), rest.back());
+        EXPECT_TRUE(queue.empty());
+    }
+    // Items left in the queue are destroyed with it
+    auto item = std::make_shared<int>(1);
+    {
+        SpscQueue<std::shared_ptr<int>> ptrs(2);
+        ptrs.enqueue(item);
+        EXPECT_EQ(2, item.use_count());
+    }
+    EXPECT_EQ(1, item.use_count());
+}
+
+TEST(LoopChannel, OrderedDelivery)
+{
+    EventLoopThread producer;
+    EventLoopThread consumer;
+    producer.run();
+    consumer.run();
+    // A small ring so that the producer has to wait for room
+    auto channel = std::make_shared<LoopChannel<std::unique_ptr<int>>>(
+        producer.getLoop(), consumer.getLoop(), 16);
+    channel->setMaxBatchSize(5);
+    const int total = 100000;
+    int expected = 0;
+    bool inOrder = true;
+    std::promise<void> done;
+    channel->setHandler([&](std::unique_ptr<int> &&value) {
+        inOrder = inOrder && *value == expected;
+        if (++expected == total)
+            done.set_value();
+    });
+    size_t maxBacklog = 0;
+    producer.getLoop()->runInLoop([&]() {
+        for (int i = 0; i < total; ++i)
+        {
+            channel->send(std::unique_ptr<int>(new int(i)));
+            maxBacklog = (std::max)(maxBacklog, channel->backlogSize());
+        }
+    });
+    ASSERT_EQ(std::future_status::ready,
+              done.get_future().wait_for(std::chrono::seconds(30)));
+    EXPECT_TRUE(inOrder);
+    EXPECT_GT(maxBacklog, 0);
+    std::promise<size_t> backlog;
+    producer.getLoop()->runInLoop(
+        [&]() { backlog.set_value(channel->backlogSize()); });
+    EXPECT_EQ(0, backlog.get_future().get());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,6 +1,9 @@
 #include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/WireCodec.h>
 #include <gtest/gtest.h>
+#include <limits>
 #include <string>
+#include <vector>
 #include <iostream>
 using namespace trantor;
 TEST(MsgBufferTest, readableTest)
@@ -71,6 +74,166 @@ TEST(Msgbuffer, MoveAssignmentOperator)
     EXPECT_EQ(bufptr, buffnew.peek());
     EXPECT_EQ(writable, buffnew.writableBytes());
 }
+TEST(MsgBufferTest, readView)
+{
+    MsgBuffer buffer(100);
+    const std::string body(1000, 'b');
+    buffer.append("head");
+    buffer.append(body);
+    buffer.append("tail");
+    buffer.retrieve(4);
+
+    // The body is the larger part, its memory is taken by the view
+    const char *bodyData = buffer.peek();
+    auto view = buffer.readView(body.size());
+    EXPECT_EQ(bodyData, view.data());
+    EXPECT_EQ(body, view.toString());
+    EXPECT_EQ("tail", std::string(buffer.peek(), buffer.readableBytes()));
+
+    // The buffer goes on with its own memory
+    buffer.append(std::string(200, 'c'));
+    EXPECT_EQ(body, view.toString());
+    auto copy = view.subView(10, 20);
+    view = MsgBufferView();
+    EXPECT_EQ(std::string(20, 'b'), copy.toString());
+
+    // A small view is copied out of the buffer
+    bodyData = buffer.peek();
+    auto small = buffer.readView(4);
+    EXPECT_NE(bodyData, small.data());
+    EXPECT_EQ("tail", small.toString());
+    EXPECT_EQ(200, buffer.readableBytes());
+
+    auto rest = buffer.readView(1000);
+    EXPECT_EQ(200, rest.size());
+    EXPECT_EQ(0, buffer.readableBytes());
+    EXPECT_TRUE(buffer.readView(10).empty());
+}
+TEST(MsgBufferTest, WireCodec)
+{
+    MsgBuffer buffer(16);
+    buffer.appendFields(wire::fixed(uint16_t(0x1234)),
+                        wire::fixed(int32_t(-2)),
+                        wire::fixed(1.5),
+                        wire::varint(uint32_t(300)),
+                        wire::varint(-1),
+                        wire::bytes(std::string("abc")));
+    // the fixed width fields are compatible with appendInt*/readInt*
+    EXPECT_EQ(buffer.peekInt16(), 0x1234);
+    EXPECT_EQ(buffer.readableBytes(), 2 + 4 + 8 + 2 + 1 + 3);
+
+    wire::Reader reader(buffer);
+    uint16_t u16 = 0;
+    int32_t i32 = 0;
+    double d = 0;
+    uint32_t v1 = 0;
+    int v2 = 0;
+    char str[3];
+    EXPECT_TRUE(reader.readFixed(u16, i32, d));
+    EXPECT_EQ(u16, 0x1234);
+    EXPECT_EQ(i32, -2);
+    EXPECT_EQ(d, 1.5);
+    EXPECT_TRUE(reader.readVarint(v1));
+    EXPECT_EQ(v1, 300);
+    EXPECT_TRUE(reader.readVarint(v2));
+    EXPECT_EQ(v2, -1);
+    EXPECT_TRUE(reader.readBytes(str, 3));
+    EXPECT_EQ(std::string(str, 3), "abc");
+    EXPECT_EQ(reader.remaining(), 0);
+    EXPECT_FALSE(reader.readFixed(u16));
+    EXPECT_FALSE(reader.readVarint(v1));
+    buffer.retrieve(reader.consumed());
+    EXPECT_EQ(buffer.readableBytes(), 0);
+
+    // varint boundaries and zigzag
+    const int64_t signedValues[] = {0,
+                                    1,
+                                    -1,
+                                    63,
+                                    -64,
+                                    64,
+                                    (std::numeric_limits<int64_t>::max)(),
+                                    (std::numeric_limits<int64_t>::min)()};
+    for (auto v : signedValues)
+        buffer.appendFields(wire::varint(v));
+    EXPECT_EQ(buffer[0], 0);
+    EXPECT_EQ(buffer[1], 2);
+    EXPECT_EQ(buffer[2], 1);
+    const uint64_t unsignedValues[] = {
+        127, 128, 16383, 16384, (std::numeric_limits<uint64_t>::max)()};
+    for (auto v : unsignedValues)
+        buffer.appendFields(wire::varint(v));
+    wire::Reader varints(buffer);
+    for (auto v : signedValues)
+    {
+        int64_t decoded = 0;
+        EXPECT_TRUE(varints.readVarint(decoded));
+        EXPECT_EQ(decoded, v);
+    }
+    for (auto v : unsignedValues)
+    {
+        uint64_t decoded = 0;
+        EXPECT_TRUE(varints.readVarint(decoded));
+        EXPECT_EQ(decoded, v);
+    }
+    EXPECT_EQ(varints.remaining(), 0);
+    buffer.retrieveAll();
+
+    // values too large for the type, and truncated input
+    buffer.appendFields(wire::varint(uint32_t(256)));
+    uint8_t small = 0;
+    EXPECT_FALSE(wire::Reader(buffer).readVarint(small));
+    uint16_t medium = 0;
+    EXPECT_TRUE(wire::Reader(buffer).readVarint(medium));
+    EXPECT_EQ(medium, 256);
+    wire::Reader truncated(buffer.peek(), 1);
+    EXPECT_FALSE(truncated.readVarint(medium));
+    EXPECT_EQ(truncated.consumed(), 0);
+    const char tooLong[] = "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01";
+    uint64_t big = 0;
+    EXPECT_FALSE(wire::Reader(tooLong, sizeof(tooLong) - 1).readVarint(big));
+    // non-canonical encodings of 0 and 1
+    EXPECT_FALSE(wire::Reader("\x80\x00", 2).readVarint(big));
+    EXPECT_FALSE(wire::Reader("\x81\x80\x00", 3).readVarint(big));
+    buffer.retrieveAll();
+
+    // arrays of every width, at lengths around the vector size
+    for (size_t n = 0; n < 20; ++n)
+    {
+        std::vector<uint16_t> a16(n);
+        std::vector<int32_t> a32(n);
+        std::vector<double> a64(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            a16[i] = static_cast<uint16_t>(i * 0x0101 + 0x1234);
+            a32[i] = static_cast<int32_t>(i * 0x01020304) - 7;
+            a64[i] = static_cast<double>(i) / 3;
+        }
+        buffer.appendFields(wire::array(a16.data(), n),
+                            wire::array(a32.data(), n),
+                            wire::array(a64.data(), n));
+        ASSERT_EQ(buffer.readableBytes(), n * 14);
+        for (size_t i = 0; i < n; ++i)
+        {
+            MsgBuffer single;
+            single.appendInt16(a16[i]);
+            EXPECT_EQ(memcmp(single.peek(), buffer.peek() + i * 2, 2), 0);
+        }
+        std::vector<uint16_t> b16(n);
+        std::vector<int32_t> b32(n);
+        std::vector<double> b64(n);
+        wire::Reader arrays(buffer);
+        EXPECT_TRUE(arrays.readArray(b16.data(), n));
+        EXPECT_TRUE(arrays.readArray(b32.data(), n));
+        EXPECT_TRUE(arrays.readArray(b64.data(), n));
+        EXPECT_EQ(a16, b16);
+        EXPECT_EQ(a32, b32);
+        EXPECT_EQ(a64, b64);
+        EXPECT_FALSE(arrays.readArray(b16.data(), 1));
+        buffer.retrieveAll();
+    }
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
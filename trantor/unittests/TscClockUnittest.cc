@@ -0,0 +1,92 @@
+#include <trantor/utils/TscClock.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace trantor;
+
+// Read during the static initialization of this file, which may come before
+// the one of the library
+static const bool staticInitUsesTsc = TscClock::usesTsc();
+static const uint64_t staticInitTicks = TscClock::ticks();
+
+TEST(TscClock, Monotonic)
+{
+    auto last = TscClock::ticks();
+    for (int i = 0; i < 100000; ++i)
+    {
+        auto now = i % 2 ? TscClock::ticks() : TscClock::ticksOrdered();
+        ASSERT_GE(now, last);
+        last = now;
+    }
+}
+
+TEST(TscClock, AgreesWithSteadyClock)
+{
+    TscClock::calibrate();
+    auto steadyStart = std::chrono::steady_clock::now();
+    auto start = TscClock::ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto end = TscClock::ticksOrdered();
+    auto steadyEnd = std::chrono::steady_clock::now();
+    double steadyNs = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(steadyEnd -
+                                                             steadyStart)
+            .count());
+    double ns = TscClock::toNanoseconds(static_cast<int64_t>(end - start));
+    EXPECT_NEAR(steadyNs, ns, steadyNs * 0.02);
+
+    // The same epoch as the steady clock
+    auto steadyNow = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+    EXPECT_NEAR(static_cast<double>(steadyNow),
+                static_cast<double>(TscClock::nanoseconds()),
+                1e6);
+}
+
+TEST(TscClock, ReanchoredToSteadyClock)
+{
+    TscClock::calibrate();
+    auto steadyNow = []() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    };
+    // The anchor is moved every second, while the threads read it
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&steadyNow]() {
+            const auto end = std::chrono::steady_clock::now() +
+                             std::chrono::milliseconds(2500);
+            while (std::chrono::steady_clock::now() < end)
+            {
+                auto before = steadyNow();
+                auto ns = TscClock::nanoseconds();
+                auto after = steadyNow();
+                EXPECT_GT(ns, before - 1000000);
+                EXPECT_LT(ns, after + 1000000);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+}
+
+TEST(TscClock, UsableDuringStaticInitialization)
+{
+    EXPECT_EQ(staticInitUsesTsc, TscClock::usesTsc());
+    auto ns =
+        TscClock::toNanoseconds(static_cast<int64_t>(TscClock::ticks() -
+                                                     staticInitTicks));
+    EXPECT_GE(ns, 0.0);
+    EXPECT_LT(ns, 60e9);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,213 @@
+#include <trantor/net/UpstreamBalancer.h>
+#include <trantor/net/TcpServer.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace trantor;
+using namespace std::chrono;
+
+namespace
+{
+// Run the loop until the condition holds, or 10 seconds pass
+bool runUntil(EventLoop &loop, const std::function<bool()> &condition)
+{
+    const auto start = steady_clock::now();
+    bool done = condition();
+    if (done)
+        return true;
+    // The timer is invalidated while the loop runs, it's ignored afterwards
+    TimerId timerId = 0;
+    timerId = loop.runEvery(0.005, [&]() {
+        done = condition();
+        if (done || steady_clock::now() - start > seconds(10))
+        {
+            loop.invalidateTimer(timerId);
+            loop.quit();
+        }
+    });
+    loop.loop();
+    return done;
+}
+
+void runFor(EventLoop &loop, double seconds)
+{
+    loop.runAfter(seconds, [&loop]() { loop.quit(); });
+    loop.loop();
+}
+
+// Upstreams on the loop of the test, which count their connections
+struct Upstreams
+{
+    Upstreams(EventLoop *loop, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto server =
+                std::make_shared<TcpServer>(loop,
+                                            InetAddress("127.0.0.1", 0),
+                                            "upstream" + std::to_string(i));
+            connections.push_back(0);
+            server->setConnectionCallback(
+                [this, i](const TcpConnectionPtr &conn) {
+                    if (conn->connected())
+                        ++connections[i];
+                    else
+                        --connections[i];
+                });
+            server->start();
+            addresses.push_back(server->address());
+            servers.push_back(std::move(server));
+        }
+    }
+    std::vector<std::shared_ptr<TcpServer>> servers;
+    std::vector<InetAddress> addresses;
+    std::vector<int> connections;
+};
+
+UpstreamBalancer::EndpointStats statsOf(const UpstreamBalancer &balancer,
+                                        const InetAddress &address)
+{
+    for (auto &stats : balancer.endpointStats())
+    {
+        if (stats.address.toIpPort() == address.toIpPort())
+            return stats;
+    }
+    ADD_FAILURE() << "No endpoint " << address.toIpPort();
+    return {};
+}
+
+bool allConnected(const UpstreamBalancer &balancer)
+{
+    for (auto &stats : balancer.endpointStats())
+    {
+        if (!stats.connected)
+            return false;
+    }
+    return true;
+}
+
+bool routedTo(const UpstreamBalancer::Request &request,
+              const InetAddress &address)
+{
+    return request.connection()->peerAddr().toIpPort() == address.toIpPort();
+}
+
+// Fail the requests routed to bad, and succeed the others, until bad is
+// ejected
+bool failUntilEjected(UpstreamBalancer &balancer, const InetAddress &bad)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto request = balancer.pick();
+        if (!request)
+            return false;
+        balancer.finish(request, !routedTo(request, bad));
+        if (statsOf(balancer, bad).ejected)
+            return true;
+    }
+    return false;
+}
+}  // namespace
+
+TEST(UpstreamBalancer, EjectionAndBackoff)
+{
+    EventLoop loop;
+    Upstreams upstreams(&loop, 2);
+    auto &bad = upstreams.addresses[0];
+    auto &good = upstreams.addresses[1];
+    UpstreamBalancer balancer(&loop, "balancer");
+    balancer.setOutlierEjection(2, 0.3);
+    balancer.setEndpoints(upstreams.addresses);
+    ASSERT_TRUE(runUntil(loop, [&]() { return allConnected(balancer); }));
+
+    ASSERT_TRUE(failUntilEjected(balancer, bad));
+    auto ejectedAt = steady_clock::now();
+    // The requests go to the other endpoint meanwhile
+    for (int i = 0; i < 20; ++i)
+    {
+        auto request = balancer.pick();
+        ASSERT_TRUE(request);
+        EXPECT_TRUE(routedTo(request, good));
+        balancer.finish(request, true);
+    }
+    // At most half of the endpoints are ejected
+    for (int i = 0; i < 5; ++i)
+    {
+        auto request = balancer.pick();
+        ASSERT_TRUE(request);
+        balancer.finish(request, false);
+    }
+    EXPECT_FALSE(statsOf(balancer, good).ejected);
+    auto request = balancer.pick();
+    ASSERT_TRUE(request);
+    balancer.finish(request, true);
+
+    ASSERT_TRUE(runUntil(loop, [&]() {
+        return !statsOf(balancer, bad).ejected;
+    }));
+    EXPECT_GE(steady_clock::now() - ejectedAt, milliseconds(300));
+
+    // Failing again without a success in between doubles the ejection time
+    ASSERT_TRUE(failUntilEjected(balancer, bad));
+    ejectedAt = steady_clock::now();
+    ASSERT_TRUE(runUntil(loop, [&]() {
+        return !statsOf(balancer, bad).ejected;
+    }));
+    EXPECT_GE(steady_clock::now() - ejectedAt, milliseconds(600));
+}
+
+TEST(UpstreamBalancer, RemovedEndpointDrains)
+{
+    EventLoop loop;
+    Upstreams upstreams(&loop, 2);
+    auto &removed = upstreams.addresses[0];
+    auto &kept = upstreams.addresses[1];
+    UpstreamBalancer balancer(&loop, "balancer");
+    balancer.setEndpoints(upstreams.addresses);
+    ASSERT_TRUE(runUntil(loop, [&]() { return allConnected(balancer); }));
+
+    UpstreamBalancer::Request inflight;
+    for (int i = 0; i < 1000 && !inflight; ++i)
+    {
+        auto request = balancer.pick();
+        ASSERT_TRUE(request);
+        if (routedTo(request, removed))
+            inflight = request;
+        else
+            balancer.finish(request, true);
+    }
+    ASSERT_TRUE(inflight);
+
+    balancer.setEndpoints({kept});
+    auto stats = balancer.endpointStats();
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_EQ(stats[0].address.toIpPort(), kept.toIpPort());
+    for (int i = 0; i < 20; ++i)
+    {
+        auto request = balancer.pick();
+        ASSERT_TRUE(request);
+        EXPECT_TRUE(routedTo(request, kept));
+        balancer.finish(request, true);
+    }
+
+    // The request in flight keeps the connection open
+    runFor(loop, 0.1);
+    EXPECT_TRUE(inflight.connection()->connected());
+    EXPECT_EQ(upstreams.connections[0], 1);
+
+    // It's closed when the request is finished
+    balancer.finish(inflight, true);
+    EXPECT_TRUE(runUntil(loop, [&]() {
+        return upstreams.connections[0] == 0;
+    }));
+    EXPECT_EQ(upstreams.connections[1], 1);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
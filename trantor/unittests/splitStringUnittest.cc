@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include <trantor/utils/Funcs.h>
 #include <iostream>
+#include <string>
+#include <vector>
 using namespace trantor;
 TEST(splitString, ACCEPT_EMPTY_STRING1)
 {
@@ -152,6 +154,93 @@ TEST(splitString, NO_ACCEPT_EMPTY_STRING10)
     auto out = splitString(originString, "");
     EXPECT_EQ(out.size(), 0);
 }
+// The reference implementation splitString() had before using StringSplitter
+static std::vector<std::string> referenceSplit(const std::string &s,
+                                               const std::string &delimiter,
+                                               bool acceptEmptyString)
+{
+    if (delimiter.empty())
+        return std::vector<std::string>{};
+    std::vector<std::string> v;
+    size_t last = 0;
+    size_t next = 0;
+    while ((next = s.find(delimiter, last)) != std::string::npos)
+    {
+        if (next > last || acceptEmptyString)
+            v.push_back(s.substr(last, next - last));
+        last = next + delimiter.length();
+    }
+    if (s.length() > last || acceptEmptyString)
+        v.push_back(s.substr(last));
+    return v;
+}
+TEST(splitString, StringSplitter)
+{
+    // Long inputs with delimiters at every offset of the 16 byte blocks
+    std::vector<std::string> inputs{"",
+                                    ",",
+                                    ",,",
+                                    "a",
+                                    "a,b",
+                                    "::a:::b::",
+                                    "gzip, deflate, br",
+                                    "a=1&b=2&&c=3&"};
+    for (size_t len = 1; len < 70; ++len)
+    {
+        std::string s;
+        for (size_t i = 0; i < len; ++i)
+            s += (i * 7 + len) % 5 == 0 ? ',' : (i % 3 == 0 ? ':' : 'x');
+        inputs.push_back(s);
+    }
+    std::vector<StringView> views;
+    for (auto &input : inputs)
+    {
+        for (std::string delimiter : {",", ":", "::", ",x", "xx:"})
+        {
+            for (bool acceptEmpty : {false, true})
+            {
+                auto expected = referenceSplit(input, delimiter, acceptEmpty);
+                EXPECT_EQ(splitString(input, delimiter, acceptEmpty),
+                          expected);
+                splitString(input, delimiter, views, acceptEmpty);
+                ASSERT_EQ(views.size(), expected.size());
+                size_t i = 0;
+                for (auto token :
+                     StringSplitter(input, delimiter, acceptEmpty))
+                {
+                    ASSERT_LT(i, expected.size());
+                    EXPECT_EQ(std::string(token.data(), token.size()),
+                              expected[i]);
+                    EXPECT_TRUE(views[i] == token);
+                    // views point into the input
+                    EXPECT_GE(token.data(), input.data());
+                    EXPECT_LE(token.data() + token.size(),
+                              input.data() + input.size());
+                    ++i;
+                }
+                EXPECT_EQ(i, expected.size());
+            }
+        }
+    }
+
+    // The output vector is reused
+    splitString("a,b,c,d", ",", views);
+    auto capacity = views.capacity();
+    splitString("e,f", ",", views);
+    EXPECT_EQ(views.size(), 2);
+    EXPECT_EQ(views.capacity(), capacity);
+    EXPECT_TRUE(views[1] == "f");
+
+    StringSplitter splitter("k1=v1&k2=v2", "&");
+    auto it = splitter.begin();
+    EXPECT_TRUE(*it == "k1=v1");
+    EXPECT_EQ(it->size(), 5);
+    ++it;
+    EXPECT_TRUE(*it++ == "k2=v2");
+    EXPECT_TRUE(it == splitter.end());
+    EXPECT_TRUE(StringSplitter("abc", "").begin() ==
+                StringSplitter("abc", "").end());
+}
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -40,7 +40,7 @@ extern const char *strerror_tl(int savedErrno);
 using namespace trantor;
 
 AsyncFileLogger::AsyncFileLogger()
-    : logBufferPtr_(new std::string), nextBufferPtr_(new std::string)
+    : logBufferPtr_(new LogBuffer), nextBufferPtr_(new LogBuffer)
 {
     logBufferPtr_->reserve(kMemBufferSize);
     nextBufferPtr_->reserve(kMemBufferSize);
@@ -50,6 +50,10 @@ AsyncFileLogger::~AsyncFileLogger()
 {
     // std::cout << "~AsyncFileLogger" << std::endl;
     stopFlag_ = true;
+    // The writer doesn't write the buffers of this logger any more after
+    // this call
+    if (writerPtr_)
+        writerPtr_->removeLogger(this);
     if (threadPtr_)
     {
         cond_.notify_all();
@@ -64,7 +68,7 @@ AsyncFileLogger::~AsyncFileLogger()
         }
         while (!writeBuffers_.empty())
         {
-            StringPtr tmpPtr = (StringPtr &&) writeBuffers_.front();
+            LogBufferPtr tmpPtr = (LogBufferPtr &&) writeBuffers_.front();
             writeBuffers_.pop();
             writeLogToFile(tmpPtr);
         }
@@ -78,13 +82,13 @@ void AsyncFileLogger::output(const char *msg, const uint64_t len)
         return;
     if (!logBufferPtr_)
     {
-        logBufferPtr_ = std::make_shared<std::string>();
+        logBufferPtr_ = std::make_shared<LogBuffer>();
         logBufferPtr_->reserve(kMemBufferSize);
     }
     if (logBufferPtr_->capacity() - logBufferPtr_->length() < len)
     {
         swapBuffer();
-        cond_.notify_one();
+        notifyWriter();
     }
     if (writeBuffers_.size() > 25)  // 100M bytes logs in buffer
     {
@@ -114,11 +118,11 @@ void AsyncFileLogger::flush()
         // std::cout<<"flush log buffer
         // len:"<<logBufferPtr_->length()<<std::endl;
         swapBuffer();
-        cond_.notify_one();
+        notifyWriter();
     }
 }
 
-void AsyncFileLogger::writeLogToFile(const StringPtr buf)
+void AsyncFileLogger::writeLogToFile(const LogBufferPtr buf)
 {
     if (!loggerFilePtr_)
     {
@@ -160,28 +164,140 @@ void AsyncFileLogger::logThreadFunc()
             tmpBuffers_.swap(writeBuffers_);
         }
 
-        while (!tmpBuffers_.empty())
-        {
-            StringPtr tmpPtr = (StringPtr &&) tmpBuffers_.front();
-            tmpBuffers_.pop();
-            writeLogToFile(tmpPtr);
-            tmpPtr->clear();
-            {
-                std::unique_lock<std::mutex> lock(mutex_);
-                nextBufferPtr_ = tmpPtr;
-            }
-        }
+        writeTakenBuffers();
         if (loggerFilePtr_)
             loggerFilePtr_->flush();
     }
 }
 
+void AsyncFileLogger::writeTakenBuffers()
+{
+    while (!tmpBuffers_.empty())
+    {
+        LogBufferPtr tmpPtr = (LogBufferPtr &&) tmpBuffers_.front();
+        tmpBuffers_.pop();
+        writeLogToFile(tmpPtr);
+        tmpPtr->clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            nextBufferPtr_ = tmpPtr;
+        }
+    }
+}
+
+bool AsyncFileLogger::takeBuffers(bool flushPartial)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (flushPartial && logBufferPtr_->length() > 0)
+        swapBuffer();
+    tmpBuffers_.swap(writeBuffers_);
+    return !tmpBuffers_.empty();
+}
+
+void AsyncFileLogger::notifyWriter()
+{
+    if (writerPtr_)
+        writerPtr_->wakeup();
+    else
+        cond_.notify_one();
+}
+
 void AsyncFileLogger::startLogging()
 {
     threadPtr_ = std::unique_ptr<std::thread>(
         new std::thread(std::bind(&AsyncFileLogger::logThreadFunc, this)));
 }
 
+void AsyncFileLogger::startLogging(
+    const std::shared_ptr<AsyncFileLogWriter> &writer)
+{
+    writerPtr_ = writer;
+    writerPtr_->addLogger(this);
+}
+
+AsyncFileLogWriter::AsyncFileLogWriter(double flushInterval)
+    : flushInterval_(
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(flushInterval)))
+{
+    thread_ = std::thread(&AsyncFileLogWriter::threadFunc, this);
+}
+
+AsyncFileLogWriter::~AsyncFileLogWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopFlag_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+void AsyncFileLogWriter::addLogger(AsyncFileLogger *logger)
+{
+    std::lock_guard<std::mutex> lock(loggersMutex_);
+    loggers_.insert(logger);
+}
+
+void AsyncFileLogWriter::removeLogger(AsyncFileLogger *logger)
+{
+    std::lock_guard<std::mutex> lock(loggersMutex_);
+    loggers_.erase(logger);
+    unflushed_.erase(logger);
+}
+
+void AsyncFileLogWriter::wakeup()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_)
+            return;
+        pending_ = true;
+    }
+    cond_.notify_one();
+}
+
+void AsyncFileLogWriter::threadFunc()
+{
+#ifdef __linux__
+    prctl(PR_SET_NAME, "AsyncLogWriter");
+#endif
+    auto nextFlush = std::chrono::steady_clock::now() + flushInterval_;
+    bool stop = false;
+    while (!stop)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait_until(lock, nextFlush, [this]() {
+                return pending_ || stopFlag_;
+            });
+            pending_ = false;
+            stop = stopFlag_;
+        }
+        auto now = std::chrono::steady_clock::now();
+        bool flushing = stop || now >= nextFlush;
+        if (flushing)
+            nextFlush = now + flushInterval_;
+        std::lock_guard<std::mutex> lock(loggersMutex_);
+        // The buffers of all the loggers are written in one pass
+        for (auto logger : loggers_)
+        {
+            if (!logger->takeBuffers(flushing))
+                continue;
+            logger->writeTakenBuffers();
+            unflushed_.insert(logger);
+        }
+        if (!flushing)
+            continue;
+        for (auto logger : unflushed_)
+        {
+            if (logger->loggerFilePtr_)
+                logger->loggerFilePtr_->flush();
+        }
+        unflushed_.clear();
+    }
+}
+
 AsyncFileLogger::LoggerFile::LoggerFile(const std::string &filePath,
                                         const std::string &fileBaseName,
                                         const std::string &fileExtName,
@@ -223,7 +339,7 @@ void AsyncFileLogger::LoggerFile::open()
 }
 
 uint64_t AsyncFileLogger::LoggerFile::fileSeq_{0};
-void AsyncFileLogger::LoggerFile::writeLog(const StringPtr buf)
+void AsyncFileLogger::LoggerFile::writeLog(const LogBufferPtr buf)
 {
     if (fp_)
     {
@@ -406,7 +522,7 @@ void AsyncFileLogger::swapBuffer()
     }
     else
     {
-        logBufferPtr_ = std::make_shared<std::string>();
+        logBufferPtr_ = std::make_shared<LogBuffer>();
         logBufferPtr_->reserve(kMemBufferSize);
     }
 }
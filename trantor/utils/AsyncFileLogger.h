@@ -15,8 +15,10 @@
 #pragma once
 
 #include <trantor/utils/NonCopyable.h>
+#include <trantor/utils/BufferPool.h>
 #include <trantor/utils/Date.h>
 #include <trantor/exports.h>
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <string>
@@ -24,11 +26,60 @@
 #include <sstream>
 #include <memory>
 #include <queue>
+#include <set>
 
 namespace trantor
 {
 using StringPtr = std::shared_ptr<std::string>;
 using StringPtrQueue = std::queue<StringPtr>;
+// The log buffers are allocated from BufferPool
+using LogBuffer =
+    std::basic_string<char, std::char_traits<char>, BufferAllocator<char>>;
+using LogBufferPtr = std::shared_ptr<LogBuffer>;
+using LogBufferPtrQueue = std::queue<LogBufferPtr>;
+
+class AsyncFileLogger;
+
+/**
+ * @brief A thread which writes the logs of several AsyncFileLogger objects,
+ * instead of one thread per logger. The buffers of all the loggers are
+ * written in the same pass, and the files are flushed together once per
+ * flush interval.
+ *
+ */
+class TRANTOR_EXPORT AsyncFileLogWriter : NonCopyable
+{
+  public:
+    /**
+     * @brief Start the writing thread.
+     *
+     * @param flushInterval The interval in seconds between the flushes of the
+     * partially filled buffers and of the files.
+     */
+    explicit AsyncFileLogWriter(double flushInterval = 1.0);
+    ~AsyncFileLogWriter();
+
+  private:
+    friend class AsyncFileLogger;
+    void addLogger(AsyncFileLogger *logger);
+    void removeLogger(AsyncFileLogger *logger);
+    // Called by the loggers when they have buffers to write
+    void wakeup();
+    void threadFunc();
+
+    std::chrono::steady_clock::duration flushInterval_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool pending_{false};   // @GuardedBy mutex_
+    bool stopFlag_{false};  // @GuardedBy mutex_
+    // Held during a writing pass, so a logger isn't removed while its
+    // buffers are written
+    std::mutex loggersMutex_;
+    std::set<AsyncFileLogger *> loggers_;  // @GuardedBy loggersMutex_
+    // The loggers written since the last flush
+    std::set<AsyncFileLogger *> unflushed_;  // @GuardedBy loggersMutex_
+    std::thread thread_;
+};
 
 /**
  * @brief This class implements utility functions for writing logs to files
@@ -58,6 +109,14 @@ class TRANTOR_EXPORT AsyncFileLogger : NonCopyable
      */
     void startLogging();
 
+    /**
+     * @brief Start writing log files in the thread of the writer, which is
+     * shared with other loggers, instead of a thread of this logger.
+     *
+     * @param writer
+     */
+    void startLogging(const std::shared_ptr<AsyncFileLogWriter> &writer);
+
     /**
      * @brief Set the size limit of log files. When the log file size reaches
      * the limit, the log file is switched.
@@ -116,16 +175,26 @@ class TRANTOR_EXPORT AsyncFileLogger : NonCopyable
     AsyncFileLogger();
 
   protected:
+    friend class AsyncFileLogWriter;
     std::mutex mutex_;
     std::condition_variable cond_;
-    StringPtr logBufferPtr_;
-    StringPtr nextBufferPtr_;
-    StringPtrQueue writeBuffers_;
-    StringPtrQueue tmpBuffers_;
-    void writeLogToFile(const StringPtr buf);
+    LogBufferPtr logBufferPtr_;
+    LogBufferPtr nextBufferPtr_;
+    LogBufferPtrQueue writeBuffers_;
+    LogBufferPtrQueue tmpBuffers_;
+    void writeLogToFile(const LogBufferPtr buf);
     std::unique_ptr<std::thread> threadPtr_;
+    std::shared_ptr<AsyncFileLogWriter> writerPtr_;
     bool stopFlag_{false};
     void logThreadFunc();
+    // Move the buffers to write to tmpBuffers_, with the partially filled
+    // buffer if flushPartial is true. Returns false if there is nothing to
+    // write.
+    bool takeBuffers(bool flushPartial);
+    // Write tmpBuffers_ to the file and recycle them
+    void writeTakenBuffers();
+    // Wake the writing thread up
+    void notifyWriter();
     std::string filePath_{"./"};
     std::string fileBaseName_{"trantor"};
     std::string fileExtName_{".log"};
@@ -143,7 +212,7 @@ class TRANTOR_EXPORT AsyncFileLogger : NonCopyable
                    bool switchOnLimitOnly = false,
                    size_t maxFiles = 0);
         ~LoggerFile();
-        void writeLog(const StringPtr buf);
+        void writeLog(const LogBufferPtr buf);
         void open();
         void switchLog(bool openNewOne);
         uint64_t getLength();
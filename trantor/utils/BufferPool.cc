@@ -0,0 +1,384 @@
+/**
+ *
+ *  @file BufferPool.cc
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include <trantor/utils/BufferPool.h>
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <errno.h>
+#include <iterator>
+#include <map>
+#include <mutex>
+#endif
+
+using namespace trantor;
+
+#ifdef __linux__
+namespace
+{
+// The size of a huge page on x86-64 and of most arm64 kernels
+constexpr size_t kChunkSize = size_t(2) << 20;
+constexpr size_t kMinBlockSize = 256;
+// Blocks up to kChunkSize: kMinBlockSize, then 4 sizes per power of two
+constexpr size_t kClassNum = 1 + 13 * 4;
+
+size_t roundUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// Get the class of a block of at most kChunkSize bytes and its size
+size_t sizeClass(size_t size, size_t &blockSize)
+{
+    if (size <= kMinBlockSize)
+    {
+        blockSize = kMinBlockSize;
+        return 0;
+    }
+    const size_t shift = 63 - __builtin_clzll(size - 1);
+    const size_t step = size_t(1) << (shift - 2);
+    blockSize = roundUp(size, step);
+    return (shift - 8) * 4 + (blockSize >> (shift - 2)) - 4;
+}
+
+/**
+ * @brief Blocks of a size class are carved from an address range backed by
+ * huge pages and kept in a free list when freed. Larger blocks are carved in
+ * multiples of huge pages, their memory is given back to the system when
+ * they are freed. Free large blocks are merged with their free neighbors, and
+ * a large block is split from the smallest free block that fits it.
+ */
+class HugePagePool
+{
+  public:
+    bool init(bool explicitPages, size_t maxBytes)
+    {
+        maxBytes = roundUp(maxBytes, kChunkSize);
+        // Only address space is reserved, the chunks are mapped on demand
+        void *range = ::mmap(nullptr,
+                             maxBytes + kChunkSize,
+                             PROT_NONE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                             -1,
+                             0);
+        if (range == MAP_FAILED)
+        {
+            LOG_SYSERR << "mmap";
+            return false;
+        }
+        base_ = reinterpret_cast<char *>(
+            roundUp(reinterpret_cast<uintptr_t>(range), kChunkSize));
+        end_ = base_ + maxBytes;
+        next_ = committed_ = base_;
+        explicitPages_ = explicitPages;
+        return true;
+    }
+
+    bool contains(const void *ptr) const
+    {
+        auto p = static_cast<const char *>(ptr);
+        return p >= base_ && p < end_;
+    }
+
+    void *allocate(size_t size)
+    {
+        if (size > kChunkSize)
+        {
+            size = roundUp(size, kChunkSize);
+            CommitFailure failure;
+            void *block;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                block = takeLargeBlock(size);
+                if (block)
+                    return block;
+                block = carve(size, failure);
+            }
+            failure.log();
+            return block;
+        }
+        size_t blockSize;
+        auto &freeList = freeLists_[sizeClass(size, blockSize)];
+        {
+            std::lock_guard<std::mutex> lock(freeList.mutex);
+            if (freeList.head)
+            {
+                auto block = freeList.head;
+                freeList.head = *static_cast<void **>(block);
+                return block;
+            }
+        }
+        CommitFailure failure;
+        void *block;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            block = carve(blockSize, failure);
+        }
+        failure.log();
+        return block;
+    }
+
+    void deallocate(void *ptr, size_t size)
+    {
+        if (size > kChunkSize)
+        {
+            size = roundUp(size, kChunkSize);
+            // Give the whole huge pages of the block back to the system
+            auto begin = roundUp(reinterpret_cast<uintptr_t>(ptr), kChunkSize);
+            auto end = (reinterpret_cast<uintptr_t>(ptr) + size) /
+                       kChunkSize * kChunkSize;
+            if (end > begin)
+                ::madvise(reinterpret_cast<void *>(begin),
+                          end - begin,
+                          MADV_DONTNEED);
+            std::lock_guard<std::mutex> lock(mutex_);
+            putLargeBlock(static_cast<char *>(ptr), size);
+            return;
+        }
+        size_t blockSize;
+        auto &freeList = freeLists_[sizeClass(size, blockSize)];
+        std::lock_guard<std::mutex> lock(freeList.mutex);
+        *static_cast<void **>(ptr) = freeList.head;
+        freeList.head = ptr;
+    }
+
+  private:
+    // What went wrong while committing memory. It is logged after mutex_ is
+    // unlocked, since logging may allocate a buffer from this pool.
+    struct CommitFailure
+    {
+        bool noHugePages{false};
+        int mmapErrno{0};
+
+        void log() const
+        {
+            if (noHugePages)
+                LOG_WARN << "No reserved huge page left, using transparent "
+                            "huge pages for the buffers";
+            if (mmapErrno != 0)
+            {
+                errno = mmapErrno;
+                LOG_SYSERR << "mmap";
+            }
+        }
+    };
+
+    // Called with mutex_ locked, returns nullptr when the range is full
+    void *carve(size_t size, CommitFailure &failure)
+    {
+        if (size > static_cast<size_t>(end_ - next_))
+            return nullptr;
+        while (committed_ < next_ + size)
+        {
+            if (!commitChunk(failure))
+                return nullptr;
+        }
+        auto block = next_;
+        next_ += size;
+        return block;
+    }
+
+    // Called with mutex_ locked, returns nullptr if no free block fits
+    void *takeLargeBlock(size_t size)
+    {
+        auto iter = largeBySize_.lower_bound(size);
+        if (iter == largeBySize_.end())
+            return nullptr;
+        const size_t blockSize = iter->first;
+        char *block = iter->second;
+        largeBySize_.erase(iter);
+        largeByAddress_.erase(block);
+        if (blockSize > size)
+            addLargeBlock(block + size, blockSize - size);
+        return block;
+    }
+
+    // Called with mutex_ locked
+    void putLargeBlock(char *block, size_t size)
+    {
+        auto next = largeByAddress_.lower_bound(block);
+        if (next != largeByAddress_.end() && block + size == next->first)
+        {
+            size += next->second;
+            removeLargeBlock(next++);
+        }
+        if (next != largeByAddress_.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == block)
+            {
+                block = prev->first;
+                size += prev->second;
+                removeLargeBlock(prev);
+            }
+        }
+        // The end of the carved part is carved again later
+        if (block + size == next_)
+            next_ = block;
+        else
+            addLargeBlock(block, size);
+    }
+
+    void addLargeBlock(char *block, size_t size)
+    {
+        largeByAddress_.emplace(block, size);
+        largeBySize_.emplace(size, block);
+    }
+
+    void removeLargeBlock(std::map<char *, size_t>::iterator iter)
+    {
+        auto range = largeBySize_.equal_range(iter->second);
+        for (auto bySize = range.first; bySize != range.second; ++bySize)
+        {
+            if (bySize->second == iter->first)
+            {
+                largeBySize_.erase(bySize);
+                break;
+            }
+        }
+        largeByAddress_.erase(iter);
+    }
+
+    bool commitChunk(CommitFailure &failure)
+    {
+        if (explicitPages_)
+        {
+            if (::mmap(committed_,
+                       kChunkSize,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB,
+                       -1,
+                       0) != MAP_FAILED)
+            {
+                committed_ += kChunkSize;
+                return true;
+            }
+            failure.noHugePages = true;
+            explicitPages_ = false;
+        }
+        // A failed MAP_FIXED mapping may have unmapped the range, so it is
+        // mapped again
+        if (::mmap(committed_,
+                   kChunkSize,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE,
+                   -1,
+                   0) == MAP_FAILED)
+        {
+            failure.mmapErrno = errno;
+            return false;
+        }
+        ::madvise(committed_, kChunkSize, MADV_HUGEPAGE);
+        committed_ += kChunkSize;
+        return true;
+    }
+
+    struct FreeList
+    {
+        std::mutex mutex;
+        void *head{nullptr};
+    };
+
+    char *base_{nullptr};
+    char *end_{nullptr};
+    FreeList freeLists_[kClassNum];
+
+    // Guards the members below
+    std::mutex mutex_;
+    char *next_{nullptr};
+    char *committed_{nullptr};
+    bool explicitPages_{false};
+    // The free large blocks, by address to merge them and by size to fit them
+    std::map<char *, size_t> largeByAddress_;
+    std::multimap<size_t, char *> largeBySize_;
+};
+
+// Never destroyed, buffers may be freed during static destruction
+std::atomic<HugePagePool *> hugePagePool{nullptr};
+}  // namespace
+
+bool BufferPool::enableHugePages(bool explicitPages, size_t maxBytes)
+{
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (hugePagePool.load(std::memory_order_acquire))
+        return false;
+    auto pool = new HugePagePool;
+    if (!pool->init(explicitPages, maxBytes))
+    {
+        delete pool;
+        return false;
+    }
+    hugePagePool.store(pool, std::memory_order_release);
+    return true;
+}
+
+bool BufferPool::hugePagesEnabled()
+{
+    return hugePagePool.load(std::memory_order_acquire) != nullptr;
+}
+
+bool BufferPool::contains(const void *ptr)
+{
+    auto pool = hugePagePool.load(std::memory_order_acquire);
+    return pool && pool->contains(ptr);
+}
+
+void *BufferPool::allocate(size_t size)
+{
+    auto pool = hugePagePool.load(std::memory_order_acquire);
+    if (pool)
+    {
+        auto ptr = pool->allocate(size);
+        if (ptr)
+            return ptr;
+    }
+    return ::operator new(size);
+}
+
+void BufferPool::deallocate(void *ptr, size_t size) noexcept
+{
+    auto pool = hugePagePool.load(std::memory_order_acquire);
+    if (pool && pool->contains(ptr))
+        pool->deallocate(ptr, size);
+    else
+        ::operator delete(ptr);
+}
+#else
+bool BufferPool::enableHugePages(bool, size_t)
+{
+    return false;
+}
+
+bool BufferPool::hugePagesEnabled()
+{
+    return false;
+}
+
+bool BufferPool::contains(const void *)
+{
+    return false;
+}
+
+void *BufferPool::allocate(size_t size)
+{
+    return ::operator new(size);
+}
+
+void BufferPool::deallocate(void *ptr, size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+#endif
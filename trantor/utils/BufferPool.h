@@ -0,0 +1,104 @@
+/**
+ *
+ *  @file BufferPool.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/exports.h>
+#include <cstddef>
+#include <new>
+
+namespace trantor
+{
+/**
+ * @brief This class represents the pool from which the buffers of the
+ * library (MsgBuffer storage, the buffers of sent data and of
+ * AsyncFileLogger) are allocated.
+ *
+ * By default the buffers come from operator new. After enableHugePages(),
+ * they come from a memory range backed by huge pages, which saves TLB misses
+ * on servers holding gigabytes in their buffers.
+ */
+class TRANTOR_EXPORT BufferPool
+{
+  public:
+    /**
+     * @brief Back the buffers allocated from now on by huge pages. Buffers
+     * allocated before are still freed to operator delete.
+     *
+     * @param explicitPages If true, the pages are taken from the huge pages
+     * reserved in /proc/sys/vm/nr_hugepages (MAP_HUGETLB), falling back to
+     * transparent huge pages once there are none left. Otherwise transparent
+     * huge pages are used (MADV_HUGEPAGE), which need
+     * /sys/kernel/mm/transparent_hugepage/enabled to be "madvise" or
+     * "always".
+     * @param maxBytes The size of the address range reserved for the pool,
+     * memory is only used for the buffers allocated in it. Buffers are
+     * allocated from operator new when it's full.
+     * @return false if huge pages aren't supported on this system (only
+     * Linux is supported), or if they are already enabled.
+     * @note This method can't be undone.
+     */
+    static bool enableHugePages(bool explicitPages = false,
+                                size_t maxBytes = size_t(64) << 30);
+
+    /**
+     * @brief Check whether the buffers are allocated from huge pages.
+     */
+    static bool hugePagesEnabled();
+
+    /**
+     * @brief Check whether the memory was allocated from huge pages.
+     */
+    static bool contains(const void *ptr);
+
+    static void *allocate(size_t size);
+    static void deallocate(void *ptr, size_t size) noexcept;
+};
+
+/**
+ * @brief The allocator of the buffers allocated from BufferPool.
+ */
+template <typename T>
+struct BufferAllocator
+{
+    using value_type = T;
+
+    BufferAllocator() = default;
+    template <typename U>
+    BufferAllocator(const BufferAllocator<U> &)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(BufferPool::allocate(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, size_t n) noexcept
+    {
+        BufferPool::deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const BufferAllocator<T> &, const BufferAllocator<U> &)
+{
+    return true;
+}
+template <typename T, typename U>
+bool operator!=(const BufferAllocator<T> &, const BufferAllocator<U> &)
+{
+    return false;
+}
+
+}  // namespace trantor
@@ -17,6 +17,8 @@
 #ifndef _WIN32
 #include <sys/time.h>
 #endif
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <string.h>
@@ -49,6 +51,196 @@ int gettimeofday(timeval *tp, void *tzp)
     return (0);
 }
 #endif
+
+namespace
+{
+constexpr int64_t kSecondsPerDay = 24LL * 3600LL;
+// A period is extended by at most kProbeStep at a time, which is only right if
+// the offset never changes and changes back within kProbeStep: then the same
+// offset at both ends means that there is no transition in between. The
+// shortest such excursion in tzdata lasts about four days (Africa/Freetown in
+// 1939), the next ones a week (Ramadan in Morocco, Gaza and Hebron).
+constexpr int64_t kProbeStep = kSecondsPerDay;
+
+int64_t floorDiv(int64_t a, int64_t b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, see
+// http://howardhinnant.github.io/date_algorithms.html
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const int64_t era = floorDiv(y, 400);
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civilFromDays(int64_t z, int64_t &y, unsigned &m, unsigned &d)
+{
+    z += 719468;
+    const int64_t era = floorDiv(z, 146097);
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+void systemLocalTime(time_t seconds, struct tm &tmTime)
+{
+#ifndef _WIN32
+    localtime_r(&seconds, &tmTime);
+#else
+    localtime_s(&tmTime, &seconds);
+#endif
+}
+
+// The UTC offset of the local time zone at a time point, computed by libc.
+int64_t systemLocalOffset(int64_t seconds, struct tm *tmOut = nullptr)
+{
+    struct tm tmTime;
+    systemLocalTime(static_cast<time_t>(seconds), tmTime);
+    if (tmOut)
+        *tmOut = tmTime;
+    int64_t local =
+        daysFromCivil(tmTime.tm_year + 1900LL,
+                      static_cast<unsigned>(tmTime.tm_mon + 1),
+                      static_cast<unsigned>(tmTime.tm_mday)) *
+            kSecondsPerDay +
+        tmTime.tm_hour * 3600LL + tmTime.tm_min * 60LL + tmTime.tm_sec;
+    return local - seconds;
+}
+
+/**
+ * A span of time [begin_, end_) in which the local time zone has a constant
+ * UTC offset. tmTemplate_ keeps the libc result for the span so that the
+ * non-calendar fields (tm_isdst, and tm_gmtoff/tm_zone where available) are
+ * still right when the calendar fields are computed arithmetically.
+ */
+struct LocalTimePeriod
+{
+    int64_t begin_{1};
+    int64_t end_{0};
+    int64_t offset_{0};
+    uint64_t generation_{0};
+    struct tm tmTemplate_;
+};
+
+std::atomic<uint64_t> localTimeGeneration{1};
+
+// Find the first second in (good, bad] whose offset is not goodOffset.
+int64_t searchTransition(int64_t good, int64_t bad, int64_t goodOffset)
+{
+    while ((good < bad ? bad - good : good - bad) > 1)
+    {
+        int64_t mid = good + (bad - good) / 2;
+        if (systemLocalOffset(mid) == goodOffset)
+            good = mid;
+        else
+            bad = mid;
+    }
+    return bad;
+}
+
+void updateLocalTimePeriod(int64_t seconds, LocalTimePeriod &period)
+{
+    struct tm tmTime;
+    int64_t offset = systemLocalOffset(seconds, &tmTime);
+    uint64_t generation = localTimeGeneration.load(std::memory_order_acquire);
+    if (generation != period.generation_ || offset != period.offset_ ||
+        tmTime.tm_isdst != period.tmTemplate_.tm_isdst ||
+        seconds < period.begin_ - kProbeStep ||
+        seconds >= period.end_ + kProbeStep)
+    {
+        // A lone miss costs no more than the localtime_r() call it replaces,
+        // the period only grows when the next misses come close to it.
+        period.begin_ = seconds;
+        period.end_ = seconds + 1;
+        period.offset_ = offset;
+        period.generation_ = generation;
+        period.tmTemplate_ = tmTime;
+        return;
+    }
+
+    // A repeated miss next to the period: extend it to the time point, and
+    // one probe step further in the same direction, up to the transition if
+    // there is one.
+    if (seconds >= period.end_)
+    {
+        period.end_ = systemLocalOffset(seconds + kProbeStep) == offset
+                          ? seconds + kProbeStep + 1
+                          : searchTransition(seconds,
+                                             seconds + kProbeStep,
+                                             offset);
+    }
+    else
+    {
+        // searchTransition() returns the last second with the other offset
+        // when searching backward.
+        period.begin_ = systemLocalOffset(seconds - kProbeStep) == offset
+                            ? seconds - kProbeStep
+                            : searchTransition(seconds,
+                                               seconds - kProbeStep,
+                                               offset) +
+                                  1;
+    }
+}
+
+/**
+ * Get the UTC offset period containing the given time point. Each thread keeps
+ * the last period it used, so the hot path is a couple of comparisons and no
+ * libc call (localtime_r() takes a global lock on the time zone state). A miss
+ * calls localtime_r() once, and a few more times when the period is extended.
+ */
+const LocalTimePeriod &localTimePeriod(int64_t seconds)
+{
+    static thread_local LocalTimePeriod period;
+    if (seconds < period.begin_ || seconds >= period.end_ ||
+        period.generation_ !=
+            localTimeGeneration.load(std::memory_order_relaxed))
+    {
+        updateLocalTimePeriod(seconds, period);
+    }
+    return period;
+}
+
+void secondsToTm(int64_t seconds, struct tm &tmTime)
+{
+    int64_t days = floorDiv(seconds, kSecondsPerDay);
+    int64_t secondsOfDay = seconds - days * kSecondsPerDay;
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    tmTime.tm_year = static_cast<int>(year - 1900);
+    tmTime.tm_mon = static_cast<int>(month - 1);
+    tmTime.tm_mday = static_cast<int>(day);
+    tmTime.tm_hour = static_cast<int>(secondsOfDay / 3600);
+    tmTime.tm_min = static_cast<int>(secondsOfDay % 3600 / 60);
+    tmTime.tm_sec = static_cast<int>(secondsOfDay % 60);
+    // 1970-01-01 was a Thursday
+    tmTime.tm_wday = static_cast<int>((days % 7 + 11) % 7);
+    tmTime.tm_yday = static_cast<int>(days - daysFromCivil(year, 1, 1));
+}
+
+void localTm(int64_t seconds, struct tm &tmTime)
+{
+    const auto &period = localTimePeriod(seconds);
+    tmTime = period.tmTemplate_;
+    secondsToTm(seconds + period.offset_, tmTime);
+}
+}  // namespace
+
+void Date::resetLocalTimeZoneCache()
+{
+    localTimeGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
 const Date Date::date()
 {
 #ifndef _WIN32
@@ -75,18 +267,13 @@ const Date Date::roundSecond() const
 }
 const Date Date::roundDay() const
 {
-    struct tm t;
-    time_t seconds =
-        static_cast<time_t>(microSecondsSinceEpoch_ / MICRO_SECONDS_PRE_SEC);
-#ifndef _WIN32
-    localtime_r(&seconds, &t);
-#else
-    localtime_s(&t, &seconds);
-#endif
-    t.tm_hour = 0;
-    t.tm_min = 0;
-    t.tm_sec = 0;
-    return Date(mktime(&t) * MICRO_SECONDS_PRE_SEC);
+    int64_t seconds = floorDiv(microSecondsSinceEpoch_, MICRO_SECONDS_PRE_SEC);
+    // Like mktime() with the tm_isdst of the original time point, the offset
+    // of *this is used for the midnight of the same local day.
+    int64_t offset = localTimePeriod(seconds).offset_;
+    int64_t dayStart =
+        floorDiv(seconds + offset, kSecondsPerDay) * kSecondsPerDay;
+    return Date((dayStart - offset) * MICRO_SECONDS_PRE_SEC);
 }
 struct tm Date::tmStruct() const
 {
@@ -185,11 +372,7 @@ std::string Date::toFormattedStringLocal(bool showMicroseconds) const
     time_t seconds =
         static_cast<time_t>(microSecondsSinceEpoch_ / MICRO_SECONDS_PRE_SEC);
     struct tm tm_time;
-#ifndef _WIN32
-    localtime_r(&seconds, &tm_time);
-#else
-    localtime_s(&tm_time, &seconds);
-#endif
+    localTm(seconds, tm_time);
 
     if (showMicroseconds)
     {
@@ -226,11 +409,7 @@ std::string Date::toDbStringLocal() const
     time_t seconds =
         static_cast<time_t>(microSecondsSinceEpoch_ / MICRO_SECONDS_PRE_SEC);
     struct tm tm_time;
-#ifndef _WIN32
-    localtime_r(&seconds, &tm_time);
-#else
-    localtime_s(&tm_time, &seconds);
-#endif
+    localTm(seconds, tm_time);
     bool showMicroseconds =
         (microSecondsSinceEpoch_ % MICRO_SECONDS_PRE_SEC != 0);
     if (showMicroseconds)
@@ -330,11 +509,7 @@ std::string Date::toCustomFormattedStringLocal(const std::string &fmtStr,
     time_t seconds =
         static_cast<time_t>(microSecondsSinceEpoch_ / MICRO_SECONDS_PRE_SEC);
     struct tm tm_time;
-#ifndef _WIN32
-    localtime_r(&seconds, &tm_time);
-#else
-    localtime_s(&tm_time, &seconds);
-#endif
+    localTm(seconds, tm_time);
     strftime(buf, sizeof(buf), fmtStr.c_str(), &tm_time);
     if (!showMicroseconds)
         return std::string(buf);
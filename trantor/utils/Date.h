@@ -82,6 +82,18 @@ class TRANTOR_EXPORT Date
         return offset;
     }
 
+    /**
+     * @brief Drop the cached UTC offsets of the local time zone.
+     *
+     * The local time methods (toFormattedStringLocal(), toDbStringLocal(),
+     * roundDay(), etc.) convert time points with a per-thread cache of the
+     * local UTC offset and its DST transition boundaries instead of calling
+     * localtime_r() each time.
+     * @note Call this method after changing the TZ environment variable or
+     * calling tzset() at runtime, so all threads pick up the new time zone.
+     */
+    static void resetLocalTimeZoneCache();
+
     /**
      * @brief Return a new Date instance that represents the time after some
      * seconds from *this.
@@ -13,9 +13,21 @@
  */
 
 #pragma once
+#include <trantor/utils/StringView.h>
 #include <algorithm>
-#include <vector>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANTOR_SPLIT_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 namespace trantor
 {
 inline uint64_t hton64(uint64_t n)
@@ -32,23 +44,279 @@ inline uint64_t ntoh64(uint64_t n)
 {
     return hton64(n);
 }
+namespace internal
+{
+// Finds the occurrences of a single character one after another. With SSE2,
+// 16 bytes are compared at once and the matches of a block are remembered,
+// so short tokens don't pay for a memchr() call each.
+class CharFinder
+{
+  public:
+    CharFinder() = default;
+    CharFinder(const char *begin, const char *end, char c)
+        : scan_(begin), end_(end), c_(c)
+    {
+    }
+
+    // Returns the next occurrence at or after pos, or end if there is none.
+    // pos must not go backwards between calls.
+    const char *next(const char *pos)
+    {
+#ifdef TRANTOR_SPLIT_SSE2
+        const __m128i needle = _mm_set1_epi8(c_);
+        for (;;)
+        {
+            while (mask_ != 0)
+            {
+                const char *match = block_ + lowestBit(mask_);
+                mask_ &= mask_ - 1;
+                if (match >= pos)
+                    return match;
+            }
+            if (scan_ < pos)
+                scan_ = pos;
+            if (end_ - scan_ < 16)
+                break;
+            const __m128i chunk =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(scan_));
+            mask_ = static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+            block_ = scan_;
+            scan_ += 16;
+        }
+#else
+        if (scan_ < pos)
+            scan_ = pos;
+#endif
+        if (scan_ >= end_)
+            return end_;
+        auto match = static_cast<const char *>(
+            memchr(scan_, c_, static_cast<size_t>(end_ - scan_)));
+        if (match == nullptr)
+            return end_;
+        scan_ = match + 1;
+        return match;
+    }
+
+  private:
+#ifdef TRANTOR_SPLIT_SSE2
+    static int lowestBit(unsigned mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+    const char *block_{nullptr};
+    unsigned mask_{0};
+#endif
+    const char *scan_{nullptr};
+    const char *end_{nullptr};
+    char c_{0};
+};
+
+// Returns the first occurrence of str in [pos, end), or end
+inline const char *findString(const char *pos, const char *end, StringView str)
+{
+    const size_t len = str.size();
+    while (static_cast<size_t>(end - pos) >= len)
+    {
+        auto match = static_cast<const char *>(
+            memchr(pos, str[0], static_cast<size_t>(end - pos) - len + 1));
+        if (match == nullptr)
+            break;
+        if (memcmp(match + 1, str.data() + 1, len - 1) == 0)
+            return match;
+        pos = match + 1;
+    }
+    return end;
+}
+
+// Calls func with each token, a tighter loop than StringSplitter for
+// collecting all tokens at once
+template <typename F>
+inline void forEachToken(StringView s,
+                         StringView delimiter,
+                         bool acceptEmptyString,
+                         F &&func)
+{
+    if (delimiter.empty())
+        return;
+    const char *pos = s.data();
+    const char *end = pos + s.size();
+    CharFinder finder(pos, end, delimiter[0]);
+    for (;;)
+    {
+        const char *delim = delimiter.size() == 1
+                                ? finder.next(pos)
+                                : findString(pos, end, delimiter);
+        if (delim > pos || acceptEmptyString)
+            func(StringView(pos, static_cast<size_t>(delim - pos)));
+        if (delim == end)
+            return;
+        pos = delim + delimiter.size();
+    }
+}
+}  // namespace internal
+
+/**
+ * @brief Iterate over the parts of a string separated by a delimiter without
+ * copying them. The tokens are the same as those of splitString(), as views
+ * into the original string, which must outlive the splitter.
+ * @code
+   for (auto token : trantor::StringSplitter(header, ","))
+       handle(token);
+   @endcode
+ */
+class StringSplitter
+{
+  public:
+    class Iterator
+    {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = StringView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const StringView *;
+        using reference = const StringView &;
+
+        Iterator() = default;
+        reference operator*() const
+        {
+            return token_;
+        }
+        pointer operator->() const
+        {
+            return &token_;
+        }
+        Iterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            auto tmp = *this;
+            advance();
+            return tmp;
+        }
+        bool operator==(const Iterator &other) const
+        {
+            return done_ == other.done_ &&
+                   (done_ || token_.data() == other.token_.data());
+        }
+        bool operator!=(const Iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+      private:
+        friend class StringSplitter;
+        Iterator(StringView str, StringView delimiter, bool acceptEmptyString)
+            : next_(str.data()),
+              end_(str.data() + str.size()),
+              delimiter_(delimiter),
+              acceptEmptyString_(acceptEmptyString),
+              done_(false)
+        {
+            if (delimiter_.size() == 1)
+                finder_ = internal::CharFinder(next_, end_, delimiter_[0]);
+            advance();
+        }
+
+        const char *findDelimiter(const char *pos)
+        {
+            if (delimiter_.size() == 1)
+                return finder_.next(pos);
+            return internal::findString(pos, end_, delimiter_);
+        }
+
+        void advance()
+        {
+            while (!finished_)
+            {
+                const char *start = next_;
+                const char *delim = findDelimiter(start);
+                if (delim == end_)
+                    finished_ = true;
+                else
+                    next_ = delim + delimiter_.size();
+                if (delim > start || acceptEmptyString_)
+                {
+                    token_ =
+                        StringView(start, static_cast<size_t>(delim - start));
+                    return;
+                }
+            }
+            done_ = true;
+        }
+
+        const char *next_{nullptr};
+        const char *end_{nullptr};
+        StringView delimiter_;
+        internal::CharFinder finder_;
+        StringView token_;
+        bool acceptEmptyString_{false};
+        bool finished_{false};
+        bool done_{true};
+    };
+
+    StringSplitter(StringView str,
+                   StringView delimiter,
+                   bool acceptEmptyString = false)
+        : str_(str),
+          delimiter_(delimiter),
+          acceptEmptyString_(acceptEmptyString)
+    {
+    }
+    Iterator begin() const
+    {
+        if (delimiter_.empty())
+            return Iterator();
+        return Iterator(str_, delimiter_, acceptEmptyString_);
+    }
+    Iterator end() const
+    {
+        return Iterator();
+    }
+
+  private:
+    StringView str_;
+    StringView delimiter_;
+    bool acceptEmptyString_;
+};
+
 inline std::vector<std::string> splitString(const std::string &s,
                                             const std::string &delimiter,
                                             bool acceptEmptyString = false)
 {
-    if (delimiter.empty())
-        return std::vector<std::string>{};
     std::vector<std::string> v;
-    size_t last = 0;
-    size_t next = 0;
-    while ((next = s.find(delimiter, last)) != std::string::npos)
-    {
-        if (next > last || acceptEmptyString)
-            v.push_back(s.substr(last, next - last));
-        last = next + delimiter.length();
-    }
-    if (s.length() > last || acceptEmptyString)
-        v.push_back(s.substr(last));
+    internal::forEachToken(s,
+                           delimiter,
+                           acceptEmptyString,
+                           [&v](StringView token) {
+                               v.emplace_back(token.data(), token.size());
+                           });
     return v;
 }
+
+/**
+ * @brief Split a string into views of its parts, see splitString().
+ * @param out Cleared and filled with the tokens. Reuse the same vector to
+ * avoid allocating once its capacity is large enough.
+ */
+inline void splitString(StringView s,
+                        StringView delimiter,
+                        std::vector<StringView> &out,
+                        bool acceptEmptyString = false)
+{
+    out.clear();
+    internal::forEachToken(s,
+                           delimiter,
+                           acceptEmptyString,
+                           [&out](StringView token) { out.push_back(token); });
+}
 }  // namespace trantor
@@ -0,0 +1,200 @@
+/**
+ *
+ *  @file LatencyHistogram.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include <trantor/utils/LatencyHistogram.h>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+using namespace trantor;
+
+constexpr int LatencyHistogram::kSubBucketBits;
+constexpr size_t LatencyHistogram::kSubBucketCount;
+constexpr size_t LatencyHistogram::kBucketCount;
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (auto &bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (size_t i = 0; i < kBucketCount; ++i)
+    {
+        auto n = other.buckets_[i].load(std::memory_order_relaxed);
+        if (n > 0)
+            buckets_[i].fetch_add(n, std::memory_order_relaxed);
+    }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+    auto otherMin = other.min_.load(std::memory_order_relaxed);
+    auto min = min_.load(std::memory_order_relaxed);
+    while (otherMin < min &&
+           !min_.compare_exchange_weak(min,
+                                       otherMin,
+                                       std::memory_order_relaxed))
+    {
+    }
+    auto otherMax = other.max_.load(std::memory_order_relaxed);
+    auto max = max_.load(std::memory_order_relaxed);
+    while (otherMax > max &&
+           !max_.compare_exchange_weak(max,
+                                       otherMax,
+                                       std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    auto n = count();
+    return n == 0 ? 0.0
+                  : static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                        static_cast<double>(n);
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const
+{
+    // The counters may be recorded meanwhile, the total is taken from the
+    // buckets read
+    uint64_t counts[kBucketCount];
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBucketCount; ++i)
+    {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0)
+        return 0;
+    percentile = (std::min)((std::max)(percentile, 0.0), 100.0);
+    auto rank = static_cast<uint64_t>(
+        std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    rank = (std::max)(rank, uint64_t(1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return (std::min)(bucketUpperBound(i), max());
+    }
+    return max();
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+    if (index < 2 * kSubBucketCount)
+        return index;
+    auto shift = index / kSubBucketCount - 1;
+    uint64_t mantissa = index % kSubBucketCount + kSubBucketCount;
+    // Wraps around to UINT64_MAX for the last bucket
+    return ((mantissa + 1) << shift) - 1;
+}
+
+namespace
+{
+std::atomic<uint64_t> nextHistogramId{1};
+
+// The histograms of the current thread, by the id of their
+// ConcurrentLatencyHistogram. The last one used is looked up first.
+struct LocalHistograms
+{
+    struct Entry
+    {
+        LatencyHistogram *histogram;
+        // Expires when the ConcurrentLatencyHistogram is destroyed
+        std::weak_ptr<LatencyHistogram> owner;
+    };
+    uint64_t lastId{0};
+    LatencyHistogram *last{nullptr};
+    std::unordered_map<uint64_t, Entry> histograms;
+    // The entries of destroyed histograms are removed when the map reaches
+    // this size, so it stays within twice the histograms alive
+    size_t sweepSize{16};
+
+    void sweep()
+    {
+        for (auto iter = histograms.begin(); iter != histograms.end();)
+        {
+            if (iter->second.owner.expired())
+                iter = histograms.erase(iter);
+            else
+                ++iter;
+        }
+        sweepSize = (std::max)(size_t(16), histograms.size() * 2);
+    }
+};
+thread_local LocalHistograms localHistograms;
+}  // namespace
+
+ConcurrentLatencyHistogram::ConcurrentLatencyHistogram()
+    : id_(nextHistogramId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+LatencyHistogram *ConcurrentLatencyHistogram::localHistogram()
+{
+    auto &local = localHistograms;
+    if (local.lastId == id_)
+        return local.last;
+    // Ids aren't reused, an entry found belongs to this object
+    auto iter = local.histograms.find(id_);
+    LatencyHistogram *histogram;
+    if (iter != local.histograms.end())
+    {
+        histogram = iter->second.histogram;
+    }
+    else
+    {
+        // Not made with make_shared, so that the memory is freed with this
+        // object rather than with the last weak_ptr
+        std::shared_ptr<LatencyHistogram> histogramPtr(new LatencyHistogram);
+        histogram = histogramPtr.get();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            histograms_.push_back(histogramPtr);
+        }
+        if (local.histograms.size() >= local.sweepSize)
+            local.sweep();
+        local.histograms.emplace(
+            id_, LocalHistograms::Entry{histogram, std::move(histogramPtr)});
+    }
+    local.lastId = id_;
+    local.last = histogram;
+    return histogram;
+}
+
+void ConcurrentLatencyHistogram::mergeTo(LatencyHistogram &histogram) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &threadHistogram : histograms_)
+        histogram.merge(*threadHistogram);
+}
+
+void ConcurrentLatencyHistogram::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &threadHistogram : histograms_)
+        threadHistogram->reset();
+}
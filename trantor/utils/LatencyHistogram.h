@@ -0,0 +1,186 @@
+/**
+ *
+ *  @file LatencyHistogram.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <trantor/exports.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trantor
+{
+/**
+ * @brief A histogram of values, such as latencies in nanoseconds, with a
+ * fixed size and a bounded relative error, for percentile reporting.
+ *
+ * The values below 64 have a bucket each. Above, each power of two range is
+ * split into 32 buckets, so a value is reported with an error of less than
+ * 1/32 (about 3%). The whole uint64_t range is covered by 1920 buckets.
+ *
+ * Values can be recorded and read in any thread without locks. The counters
+ * are updated separately, so a histogram read while it is recorded may count
+ * the last values in some counters only.
+ */
+class TRANTOR_EXPORT LatencyHistogram : NonCopyable
+{
+  public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr size_t kSubBucketCount = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBucketCount =
+        (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+    LatencyHistogram();
+
+    /**
+     * @brief Record a value count times.
+     */
+    void record(uint64_t value, uint64_t count = 1)
+    {
+        buckets_[bucketIndex(value)].fetch_add(count,
+                                               std::memory_order_relaxed);
+        count_.fetch_add(count, std::memory_order_relaxed);
+        sum_.fetch_add(value * count, std::memory_order_relaxed);
+        auto min = min_.load(std::memory_order_relaxed);
+        while (value < min &&
+               !min_.compare_exchange_weak(min,
+                                           value,
+                                           std::memory_order_relaxed))
+        {
+        }
+        auto max = max_.load(std::memory_order_relaxed);
+        while (value > max &&
+               !max_.compare_exchange_weak(max,
+                                           value,
+                                           std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief Add the values of another histogram to this one.
+     */
+    void merge(const LatencyHistogram &other);
+
+    /**
+     * @brief Remove all the values.
+     */
+    void reset();
+
+    uint64_t count() const
+    {
+        return count_.load(std::memory_order_relaxed);
+    }
+    /**
+     * @brief The smallest value recorded, 0 if there is none.
+     */
+    uint64_t min() const
+    {
+        return count() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+    }
+    uint64_t max() const
+    {
+        return max_.load(std::memory_order_relaxed);
+    }
+    double mean() const;
+
+    /**
+     * @brief Return the value which percentile percent of the values are
+     * less than or equal to, within the error of the buckets.
+     *
+     * @param percentile From 0 to 100.
+     */
+    uint64_t valueAtPercentile(double percentile) const;
+
+    /**
+     * @brief The index of the bucket counting value.
+     */
+    static size_t bucketIndex(uint64_t value)
+    {
+        if (value < 2 * kSubBucketCount)
+            return static_cast<size_t>(value);
+        int msb = 63 - countLeadingZeros(value);
+        int shift = msb - kSubBucketBits;
+        return static_cast<size_t>(shift) * kSubBucketCount +
+               static_cast<size_t>(value >> shift);
+    }
+    /**
+     * @brief The largest value counted by a bucket.
+     */
+    static uint64_t bucketUpperBound(size_t index);
+
+  private:
+    static int countLeadingZeros(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(value);
+#else
+        int n = 0;
+        for (uint64_t bit = uint64_t(1) << 63; !(value & bit); bit >>= 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    std::atomic<uint64_t> buckets_[kBucketCount];
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * @brief A histogram recorded by many threads, each of which records to a
+ * histogram of its own, so the threads don't contend for the counters.
+ * Reading it doesn't block the recording.
+ */
+class TRANTOR_EXPORT ConcurrentLatencyHistogram : NonCopyable
+{
+  public:
+    ConcurrentLatencyHistogram();
+
+    /**
+     * @brief Record a value in the histogram of the current thread.
+     */
+    void record(uint64_t value, uint64_t count = 1)
+    {
+        localHistogram()->record(value, count);
+    }
+
+    /**
+     * @brief Add the values recorded by all the threads to a histogram.
+     */
+    void mergeTo(LatencyHistogram &histogram) const;
+
+    /**
+     * @brief Remove the values recorded by all the threads.
+     */
+    void reset();
+
+  private:
+    LatencyHistogram *localHistogram();
+
+    // Unique for each object, the histograms of the threads are looked up by
+    // it
+    const uint64_t id_;
+    mutable std::mutex mutex_;
+    // The histograms of the threads which recorded values. The threads only
+    // keep weak references, which expire with this object.
+    std::vector<std::shared_ptr<LatencyHistogram>> histograms_;
+};
+
+}  // namespace trantor
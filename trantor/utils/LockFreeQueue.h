@@ -15,8 +15,11 @@
 #pragma once
 #include <trantor/utils/NonCopyable.h>
 #include <atomic>
+#include <cstddef>
 #include <type_traits>
 #include <memory>
+#include <new>
+#include <utility>
 #include <assert.h>
 namespace trantor
 {
@@ -111,4 +114,158 @@ class MpscQueue : public NonCopyable
     std::atomic<BufferNode *> tail_;
 };
 
+/**
+ * @brief This class template represents a bounded lock-free single producer
+ * single consumer queue. Items are stored in a ring, so unlike MpscQueue it
+ * doesn't allocate per item.
+ *
+ * @tparam T The type of the items in the queue.
+ */
+template <typename T>
+class SpscQueue : public NonCopyable
+{
+  public:
+    /**
+     * @brief Construct a new queue.
+     *
+     * @param capacity The maximum number of items in the queue, rounded up to
+     * a power of two.
+     */
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask_ = size - 1;
+        slots_.reset(new Slot[size]);
+    }
+    ~SpscQueue()
+    {
+        size_t head = head_.index.load(std::memory_order_relaxed);
+        size_t tail = tail_.index.load(std::memory_order_relaxed);
+        for (; head != tail; ++head)
+            slot(head)->~T();
+    }
+
+    /**
+     * @brief Put a item into the queue.
+     *
+     * @param input
+     * @return false if the queue is full, the input is left untouched then.
+     * @note This method must be called in a single thread.
+     */
+    bool enqueue(T &&input)
+    {
+        return emplace(std::move(input));
+    }
+    bool enqueue(const T &input)
+    {
+        return emplace(input);
+    }
+    template <typename... Args>
+    bool emplace(Args &&...args)
+    {
+        const size_t tail = tail_.index.load(std::memory_order_relaxed);
+        if (tail - tail_.cached > mask_)
+        {
+            tail_.cached = head_.index.load(std::memory_order_acquire);
+            if (tail - tail_.cached > mask_)
+                return false;
+        }
+        new (slot(tail)) T(std::forward<Args>(args)...);
+        tail_.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Get a item from the queue.
+     *
+     * @param output
+     * @return false if the queue is empty.
+     * @note This method must be called in a single thread.
+     */
+    bool dequeue(T &output)
+    {
+        const size_t head = head_.index.load(std::memory_order_relaxed);
+        if (head == head_.cached)
+        {
+            head_.cached = tail_.index.load(std::memory_order_acquire);
+            if (head == head_.cached)
+                return false;
+        }
+        T *item = slot(head);
+        output = std::move(*item);
+        item->~T();
+        head_.index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pass up to maxItems items to func, in order, and remove them from
+     * the queue.
+     *
+     * @param func Called with T&& for each item.
+     * @return The number of items consumed.
+     * @note This method must be called in the consumer thread.
+     */
+    template <typename F>
+    size_t consume(F &&func, size_t maxItems = static_cast<size_t>(-1))
+    {
+        size_t head = head_.index.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (count < maxItems)
+        {
+            if (head == head_.cached)
+            {
+                head_.cached = tail_.index.load(std::memory_order_acquire);
+                if (head == head_.cached)
+                    break;
+            }
+            T *item = slot(head);
+            func(std::move(*item));
+            item->~T();
+            head_.index.store(++head, std::memory_order_release);
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Check whether the queue is empty, from the consumer thread.
+     */
+    bool empty() const
+    {
+        return head_.index.load(std::memory_order_relaxed) ==
+               tail_.index.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+  private:
+    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    T *slot(size_t index)
+    {
+        return reinterpret_cast<T *>(&slots_[index & mask_]);
+    }
+
+    // The index of one side and its cached copy of the other side's index,
+    // padded to keep the consumer and the producer on separate cache lines
+    struct Cursor
+    {
+        char padBefore[64];
+        std::atomic<size_t> index{0};
+        size_t cached{0};
+        char padAfter[64 - 2 * sizeof(size_t)];
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    // The indices only grow, they are masked to find the slot
+    Cursor head_;  // consumer
+    Cursor tail_;  // producer
+};
+
 }  // namespace trantor
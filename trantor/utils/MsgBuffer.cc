@@ -180,6 +180,33 @@ std::string MsgBuffer::read(size_t len)
     retrieve(len);
     return ret;
 }
+MsgBufferView MsgBuffer::readView(size_t len)
+{
+    if (len > readableBytes())
+        len = readableBytes();
+    if (len == 0)
+        return MsgBufferView();
+    const size_t remaining = readableBytes() - len;
+    if (len < remaining)
+    {
+        auto storage =
+            std::make_shared<MsgBufferStorage>(peek(), peek() + len);
+        retrieve(len);
+        return MsgBufferView(storage, storage->data(), len);
+    }
+    // Hand the memory over to the view and go on with new memory. initCap_
+    // follows the growth of the buffer, so it doesn't size the new memory.
+    const size_t newCap = (std::max)((std::min)(initCap_, kBufferDefaultLength),
+                                     remaining);
+    MsgBufferStorage newBuffer(kBufferOffset + newCap);
+    memcpy(&newBuffer[kBufferOffset], peek() + len, remaining);
+    auto storage = std::make_shared<MsgBufferStorage>(std::move(buffer_));
+    const char *data = storage->data() + head_;
+    buffer_.swap(newBuffer);
+    head_ = kBufferOffset;
+    tail_ = head_ + remaining;
+    return MsgBufferView(std::move(storage), data, len);
+}
 uint8_t MsgBuffer::readInt8()
 {
     uint8_t ret = peekInt8();
@@ -15,13 +15,16 @@
 #pragma once
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/exports.h>
+#include <trantor/utils/BufferPool.h>
 #include <vector>
 #include <string>
+#include <memory>
 #include <algorithm>
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <cstdint>
+#include <initializer_list>
 #if defined(_WIN32) && !defined(_SSIZE_T_DEFINED)
 using ssize_t = std::intptr_t;
 #endif
@@ -31,6 +34,84 @@ namespace trantor
 static constexpr size_t kBufferDefaultLength{2048};
 static constexpr char CRLF[]{"\r\n"};
 
+// The memory of MsgBuffer, allocated from BufferPool
+using MsgBufferStorage = std::vector<char, BufferAllocator<char>>;
+
+/**
+ * @brief This class represents an immutable slice of the data of a
+ * MsgBuffer, taken with MsgBuffer::readView().
+ *
+ * The slice keeps the memory it points to alive, and copies of it share the
+ * memory, so it can be passed to other threads without copying the data.
+ */
+class TRANTOR_EXPORT MsgBufferView
+{
+  public:
+    MsgBufferView() = default;
+
+    /**
+     * @brief Get the beginning of the data.
+     */
+    const char *data() const
+    {
+        return data_;
+    }
+
+    /**
+     * @brief Get the size of the data.
+     */
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Get a part of the slice, sharing the memory with it.
+     *
+     * @param offset
+     * @param len The length of the part, it stops at the end of the slice.
+     */
+    MsgBufferView subView(size_t offset, size_t len = std::string::npos) const
+    {
+        assert(offset <= size_);
+        return MsgBufferView(storage_,
+                             data_ + offset,
+                             (std::min)(len, size_ - offset));
+    }
+
+    /**
+     * @brief Copy the data into a string.
+     */
+    std::string toString() const
+    {
+        return std::string(data_, size_);
+    }
+
+    const char &operator[](size_t offset) const
+    {
+        assert(offset < size_);
+        return data_[offset];
+    }
+
+  private:
+    friend class MsgBuffer;
+    MsgBufferView(std::shared_ptr<const MsgBufferStorage> storage,
+                  const char *data,
+                  size_t size)
+        : storage_(std::move(storage)), data_(data), size_(size)
+    {
+    }
+
+    std::shared_ptr<const MsgBufferStorage> storage_;
+    const char *data_{nullptr};
+    size_t size_{0};
+};
+
 /**
  * @brief This class represents a memory buffer used for sending and receiving
  * data.
@@ -110,6 +191,19 @@ class TRANTOR_EXPORT MsgBuffer
      */
     std::string read(size_t len);
 
+    /**
+     * @brief Get and remove some bytes from the buffer as a view, without
+     * copying them when they are the larger part of the buffer.
+     *
+     * In that case the view takes the memory of the buffer, and the bytes
+     * after the view are copied into new memory of the buffer. Otherwise the
+     * bytes of the view are copied, so taking a large body or message out of
+     * a receive buffer costs no copy of it.
+     *
+     * @param len The length of the view, it stops at the end of the data.
+     */
+    MsgBufferView readView(size_t len);
+
     /**
      * @brief Get the remove a byte value from the buffer.
      *
@@ -213,6 +307,31 @@ class TRANTOR_EXPORT MsgBuffer
      */
     void appendInt64(const uint64_t l);
 
+    /**
+     * @brief Append several encoded fields, reserving room for all of them
+     * once.
+     * @details A field is any object with maxEncodedSize() and
+     * char *encode(char *) members, such as the ones in
+     * trantor/utils/WireCodec.h.
+     * @code
+       buffer.appendFields(trantor::wire::fixed(uint32_t(42)),
+                           trantor::wire::varint(-1),
+                           trantor::wire::fixed(3.14));
+       @endcode
+     */
+    template <typename... Fields>
+    void appendFields(const Fields &...fields)
+    {
+        size_t maxLen = 0;
+        (void)std::initializer_list<int>{
+            (maxLen += fields.maxEncodedSize(), 0)...};
+        ensureWritableBytes(maxLen);
+        char *start = beginWrite();
+        char *p = start;
+        (void)std::initializer_list<int>{(p = fields.encode(p), 0)...};
+        hasWritten(static_cast<size_t>(p - start));
+    }
+
     /**
      * @brief Put new data to the beginning of the buffer.
      *
@@ -349,7 +468,7 @@ class TRANTOR_EXPORT MsgBuffer
   private:
     size_t head_;
     size_t initCap_;
-    std::vector<char> buffer_;
+    MsgBufferStorage buffer_;
     size_t tail_;
     const char *begin() const
     {
@@ -0,0 +1,152 @@
+/**
+ *
+ *  @file StringView.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#endif
+
+namespace trantor
+{
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+using StringView = std::string_view;
+#else
+/**
+ * @brief A non-owning reference to a string, a subset of std::string_view
+ * for C++14 builds. With C++17, trantor::StringView is std::string_view.
+ * @note Since the type depends on the language standard, only use it in
+ * inline code, never in the interface of functions compiled into the
+ * library.
+ */
+class StringView
+{
+  public:
+    using value_type = char;
+    using const_iterator = const char *;
+    using iterator = const_iterator;
+    using size_type = size_t;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    constexpr StringView() noexcept = default;
+    constexpr StringView(const char *data, size_t len) noexcept
+        : data_(data), len_(len)
+    {
+    }
+    StringView(const char *str) : data_(str), len_(strlen(str))
+    {
+    }
+    StringView(const std::string &str) noexcept
+        : data_(str.data()), len_(str.size())
+    {
+    }
+
+    constexpr const char *data() const noexcept
+    {
+        return data_;
+    }
+    constexpr size_t size() const noexcept
+    {
+        return len_;
+    }
+    constexpr size_t length() const noexcept
+    {
+        return len_;
+    }
+    constexpr bool empty() const noexcept
+    {
+        return len_ == 0;
+    }
+    constexpr const_iterator begin() const noexcept
+    {
+        return data_;
+    }
+    constexpr const_iterator end() const noexcept
+    {
+        return data_ + len_;
+    }
+    constexpr const char &operator[](size_t pos) const
+    {
+        return data_[pos];
+    }
+    constexpr const char &front() const
+    {
+        return data_[0];
+    }
+    constexpr const char &back() const
+    {
+        return data_[len_ - 1];
+    }
+
+    void remove_prefix(size_t n)
+    {
+        data_ += n;
+        len_ -= n;
+    }
+    void remove_suffix(size_t n)
+    {
+        len_ -= n;
+    }
+    StringView substr(size_t pos = 0, size_t n = npos) const
+    {
+        if (pos > len_)
+            throw std::out_of_range("trantor::StringView::substr");
+        return StringView(data_ + pos, (std::min)(n, len_ - pos));
+    }
+    size_t find(char c, size_t pos = 0) const noexcept
+    {
+        if (pos >= len_)
+            return npos;
+        auto p = static_cast<const char *>(memchr(data_ + pos, c, len_ - pos));
+        return p ? static_cast<size_t>(p - data_) : npos;
+    }
+    int compare(StringView other) const noexcept
+    {
+        int ret = len_ && other.len_
+                      ? memcmp(data_, other.data_, (std::min)(len_, other.len_))
+                      : 0;
+        if (ret != 0)
+            return ret;
+        return len_ == other.len_ ? 0 : (len_ < other.len_ ? -1 : 1);
+    }
+    explicit operator std::string() const
+    {
+        return std::string(data_, len_);
+    }
+
+  private:
+    const char *data_{nullptr};
+    size_t len_{0};
+};
+
+inline bool operator==(StringView lhs, StringView rhs) noexcept
+{
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+inline bool operator!=(StringView lhs, StringView rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+inline bool operator<(StringView lhs, StringView rhs) noexcept
+{
+    return lhs.compare(rhs) < 0;
+}
+#endif
+}  // namespace trantor
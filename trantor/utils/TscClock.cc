@@ -0,0 +1,183 @@
+/**
+ *
+ *  @file TscClock.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#include <trantor/utils/TscClock.h>
+#include <atomic>
+#if TRANTOR_HAS_TSC && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+using namespace trantor;
+
+namespace
+{
+#if TRANTOR_HAS_TSC
+void cpuid(unsigned int leaf, unsigned int (&regs)[4])
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, static_cast<int>(leaf));
+    for (int i = 0; i < 4; ++i)
+        regs[i] = static_cast<unsigned int>(info[i]);
+#else
+    __cpuid(leaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// The extended leaf 0x80000007 tells whether the counter is invariant (bit 8
+// of EDX), and 0x80000001 whether rdtscp is supported (bit 27 of EDX)
+bool hasExtendedFeature(unsigned int leaf, unsigned int edxBit)
+{
+    unsigned int regs[4];
+    cpuid(0x80000000, regs);
+    if (regs[0] < leaf)
+        return false;
+    cpuid(leaf, regs);
+    return (regs[3] >> edxBit) & 1;
+}
+#endif
+}  // namespace
+
+bool TscClock::hasInvariantTsc()
+{
+#if TRANTOR_HAS_TSC
+    return hasExtendedFeature(0x80000007, 8);
+#else
+    return false;
+#endif
+}
+
+bool TscClock::hasInvariantTscp()
+{
+#if TRANTOR_HAS_TSC
+    return hasInvariantTsc() && hasExtendedFeature(0x80000001, 27);
+#else
+    return false;
+#endif
+}
+
+const TscClock::Calibration &TscClock::calibration()
+{
+    static const Calibration cal = []() {
+        Calibration result;
+        if (!useTsc())
+        {
+            // The ticks are already nanoseconds of the steady clock
+            result.baseTicks = 0;
+            result.baseNanoseconds = 0;
+            result.nanosecondsPerTick = 1.0;
+            return result;
+        }
+        // Measure the ticks in 10 milliseconds of the steady clock, reading
+        // both clocks close together at both ends
+        auto sample = [](uint64_t &tsc, int64_t &ns) {
+            auto before = ticks();
+            ns = static_cast<int64_t>(steadyNanoseconds());
+            auto after = ticks();
+            tsc = before + (after - before) / 2;
+        };
+        uint64_t tsc0, tsc1;
+        int64_t ns0, ns1;
+        sample(tsc0, ns0);
+        do
+        {
+            sample(tsc1, ns1);
+        } while (ns1 - ns0 < 10 * 1000 * 1000);
+        result.baseTicks = tsc1;
+        result.baseNanoseconds = ns1;
+        result.nanosecondsPerTick =
+            static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0);
+        return result;
+    }();
+    return cal;
+}
+
+namespace
+{
+/**
+ * The point from which toSteadyNanoseconds() extrapolates, moved to a new
+ * reading of the steady clock every second so that the error of the rate
+ * doesn't add up. It's a seqlock: the readers retry while it's written.
+ */
+struct Anchor
+{
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<int64_t> nanoseconds{0};
+    std::atomic<double> nanosecondsPerTick{1.0};
+    // Taken by the thread which moves the anchor, the others keep using the
+    // current one
+    std::atomic_flag moving = ATOMIC_FLAG_INIT;
+    int64_t interval{0};
+};
+}  // namespace
+
+int64_t TscClock::toSteadyNanoseconds(uint64_t ticks)
+{
+    if (!useTsc())
+        return static_cast<int64_t>(ticks);
+    const auto &cal = calibration();
+    static Anchor anchor;
+    static const bool initialized = [&cal]() {
+        anchor.ticks.store(cal.baseTicks, std::memory_order_relaxed);
+        anchor.nanoseconds.store(cal.baseNanoseconds,
+                                 std::memory_order_relaxed);
+        anchor.nanosecondsPerTick.store(cal.nanosecondsPerTick,
+                                        std::memory_order_relaxed);
+        anchor.interval = static_cast<int64_t>(1e9 / cal.nanosecondsPerTick);
+        return true;
+    }();
+    (void)initialized;
+
+    uint32_t seq;
+    uint64_t baseTicks;
+    int64_t baseNanoseconds;
+    double nanosecondsPerTick;
+    do
+    {
+        seq = anchor.seq.load(std::memory_order_acquire);
+        baseTicks = anchor.ticks.load(std::memory_order_relaxed);
+        baseNanoseconds = anchor.nanoseconds.load(std::memory_order_relaxed);
+        nanosecondsPerTick =
+            anchor.nanosecondsPerTick.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 ||
+             seq != anchor.seq.load(std::memory_order_relaxed));
+
+    auto delta = static_cast<int64_t>(ticks - baseTicks);
+    if (delta > anchor.interval &&
+        !anchor.moving.test_and_set(std::memory_order_acquire))
+    {
+        const uint64_t nowTicks = TscClock::ticks();
+        const auto nowNanoseconds = static_cast<int64_t>(steadyNanoseconds());
+        // The rate over the whole time since the calibration
+        nanosecondsPerTick =
+            static_cast<double>(nowNanoseconds - cal.baseNanoseconds) /
+            static_cast<double>(nowTicks - cal.baseTicks);
+        baseTicks = nowTicks;
+        baseNanoseconds = nowNanoseconds;
+        // Another thread may have moved it since it was read
+        seq = anchor.seq.load(std::memory_order_relaxed);
+        anchor.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        anchor.ticks.store(baseTicks, std::memory_order_relaxed);
+        anchor.nanoseconds.store(baseNanoseconds, std::memory_order_relaxed);
+        anchor.nanosecondsPerTick.store(nanosecondsPerTick,
+                                        std::memory_order_relaxed);
+        anchor.seq.store(seq + 2, std::memory_order_release);
+        anchor.moving.clear(std::memory_order_release);
+        delta = static_cast<int64_t>(ticks - baseTicks);
+    }
+    return baseNanoseconds +
+           static_cast<int64_t>(static_cast<double>(delta) *
+                                nanosecondsPerTick);
+}
@@ -0,0 +1,161 @@
+/**
+ *
+ *  @file TscClock.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/exports.h>
+#include <stdint.h>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define TRANTOR_HAS_TSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define TRANTOR_HAS_TSC 0
+#endif
+
+namespace trantor
+{
+/**
+ * @brief A monotonic clock read from the time stamp counter of the CPU, for
+ * timestamps which cost a few nanoseconds. It's used only if the counter is
+ * invariant, which means that it runs at a constant rate in all the states of
+ * the CPU, otherwise the clock reads std::chrono::steady_clock, that is
+ * clock_gettime(CLOCK_MONOTONIC) on Linux.
+ *
+ * The ticks are converted to nanoseconds with a rate measured when the first
+ * conversion is done, which busy-waits about 10 milliseconds. Call
+ * calibrate() at startup so that this doesn't happen on a hot path.
+ *
+ * nanoseconds() is re-anchored to std::chrono::steady_clock every second,
+ * so it stays within microseconds of it, e.g. to be compared with timer
+ * deadlines. It can step back by as much when it's re-anchored, use
+ * toNanoseconds() on ticks for intervals.
+ *
+ * @code
+   auto start = TscClock::ticks();
+   handleRequest();
+   auto ns = TscClock::toNanoseconds(TscClock::ticks() - start);
+   @endcode
+ */
+class TRANTOR_EXPORT TscClock
+{
+  public:
+    /**
+     * @brief Read the clock, in ticks. The instructions before and after it
+     * may be executed out of order with it.
+     */
+    static uint64_t ticks()
+    {
+#if TRANTOR_HAS_TSC
+        if (useTsc())
+            return __rdtsc();
+#endif
+        return steadyNanoseconds();
+    }
+
+    /**
+     * @brief Read the clock, in ticks, after the instructions before it are
+     * executed, for the end of a measured interval.
+     */
+    static uint64_t ticksOrdered()
+    {
+#if TRANTOR_HAS_TSC
+        if (useTscp())
+        {
+            unsigned int aux;
+            return __rdtscp(&aux);
+        }
+#endif
+        return ticks();
+    }
+
+    /**
+     * @brief Convert a number of ticks to nanoseconds.
+     */
+    static double toNanoseconds(int64_t ticks)
+    {
+        return static_cast<double>(ticks) * calibration().nanosecondsPerTick;
+    }
+
+    /**
+     * @brief The time of the clock in nanoseconds, with the same epoch as
+     * std::chrono::steady_clock.
+     */
+    static int64_t nanoseconds()
+    {
+        return toSteadyNanoseconds(ticks());
+    }
+
+    /**
+     * @brief Convert the ticks read from the clock to nanoseconds, with the
+     * same epoch as std::chrono::steady_clock.
+     */
+    static int64_t toSteadyNanoseconds(uint64_t ticks);
+
+    /**
+     * @brief Return true if the clock reads the time stamp counter.
+     */
+    static bool usesTsc()
+    {
+        return useTsc();
+    }
+
+    /**
+     * @brief Measure the rate of the ticks now, instead of at the first
+     * conversion. Call it at startup.
+     */
+    static void calibrate()
+    {
+        calibration();
+    }
+
+  private:
+    struct Calibration
+    {
+        uint64_t baseTicks;
+        int64_t baseNanoseconds;
+        double nanosecondsPerTick;
+    };
+    static const Calibration &calibration();
+    static uint64_t steadyNanoseconds()
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    // Function-local statics, so that they are initialized before they are
+    // used, even during the static initialization of other translation units
+    static bool useTsc()
+    {
+        static const bool use = hasInvariantTsc();
+        return use;
+    }
+    static bool useTscp()
+    {
+        static const bool use = hasInvariantTscp();
+        return use;
+    }
+    static bool hasInvariantTsc();
+    static bool hasInvariantTscp();
+};
+
+}  // namespace trantor
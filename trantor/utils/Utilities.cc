@@ -35,15 +35,18 @@
 #elif defined(USE_BOTAN)
 #include <botan/auto_rng.h>
 #else
+#include <fstream>
+#include <chrono>
+#include <random>
+#endif
+#if !defined(USE_OPENSSL)
 #include "crypto/md5.h"
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
+#endif
 #include "crypto/sha3.h"
 #include "crypto/blake2.h"
-#include <fstream>
-#include <chrono>
-#include <random>
-#endif
+#include "crypto/hash_context.h"
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -54,6 +57,7 @@
 #endif
 
 #include <cassert>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <trantor/utils/Logger.h>
@@ -352,6 +356,167 @@ std::string tlsBackend()
 #undef TOSTRING
 #undef STRINGIFY
 
+namespace
+{
+// A HashContext over one of the bundled C implementations, whose state is a
+// plain struct
+template <typename Traits>
+class BuiltinHashContext : public internal::HashContext
+{
+  public:
+    using Context = typename Traits::Context;
+    explicit BuiltinHashContext(const Context &ctx) : ctx_(ctx)
+    {
+    }
+    std::unique_ptr<HashContext> clone() const override
+    {
+        return std::unique_ptr<HashContext>(new BuiltinHashContext(ctx_));
+    }
+    void copyFrom(const HashContext &other) override
+    {
+        ctx_ = static_cast<const BuiltinHashContext &>(other).ctx_;
+    }
+    void update(const void *data, size_t len) override
+    {
+        Traits::update(&ctx_, (const unsigned char *)data, len);
+    }
+    void finalize(unsigned char *out) override
+    {
+        Traits::finalize(&ctx_, out);
+    }
+
+  private:
+    Context ctx_;
+};
+
+struct Sha3Traits
+{
+    using Context = sha3_ctx_t;
+    static void update(Context *ctx, const unsigned char *data, size_t len)
+    {
+        trantor_sha3_update(ctx, data, len);
+    }
+    static void finalize(Context *ctx, unsigned char *out)
+    {
+        trantor_sha3_final(out, ctx);
+    }
+};
+
+struct Blake2bTraits
+{
+    using Context = blake2b_state;
+    static void update(Context *ctx, const unsigned char *data, size_t len)
+    {
+        trantor_blake2b_update(ctx, data, len);
+    }
+    static void finalize(Context *ctx, unsigned char *out)
+    {
+        trantor_blake2b_final(ctx, out, ctx->outlen);
+    }
+};
+}  // namespace
+
+namespace internal
+{
+std::unique_ptr<HashContext> newSha3Context()
+{
+    sha3_ctx_t ctx;
+    trantor_sha3_init(&ctx, sizeof(Hash256));
+    return std::unique_ptr<HashContext>(
+        new BuiltinHashContext<Sha3Traits>(ctx));
+}
+
+std::unique_ptr<HashContext> newBlake2bContext(const void *key, size_t keyLen)
+{
+    assert(keyLen <= BLAKE2B_KEYBYTES);
+    blake2b_state state;
+    memset(&state, 0, sizeof(state));
+    trantor_blake2b_init(&state, sizeof(Hash256), key, keyLen);
+    return std::unique_ptr<HashContext>(
+        new BuiltinHashContext<Blake2bTraits>(state));
+}
+}  // namespace internal
+
+// Botan's hash objects are not used here yet, Hmac runs on the bundled
+// implementations in both Botan and standalone builds.
+#if !defined(USE_OPENSSL)
+namespace
+{
+struct Md5Traits
+{
+    using Context = MD5_CTX;
+    static void update(Context *ctx, const unsigned char *data, size_t len)
+    {
+        trantor_md5_update(ctx, data, len);
+    }
+    static void finalize(Context *ctx, unsigned char *out)
+    {
+        trantor_md5_final(ctx, out);
+    }
+};
+
+struct Sha1Traits
+{
+    using Context = SHA1_CTX;
+    static void update(Context *ctx, const unsigned char *data, size_t len)
+    {
+        trantor_sha1_update(ctx, data, len);
+    }
+    static void finalize(Context *ctx, unsigned char *out)
+    {
+        trantor_sha1_final(out, ctx);
+    }
+};
+
+struct Sha256Traits
+{
+    using Context = SHA256_CTX;
+    static void update(Context *ctx, const unsigned char *data, size_t len)
+    {
+        trantor_sha256_update(ctx, data, len);
+    }
+    static void finalize(Context *ctx, unsigned char *out)
+    {
+        trantor_sha256_final(ctx, out);
+    }
+};
+}  // namespace
+
+std::unique_ptr<internal::HashContext> internal::newHashContext(
+    HashAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case HashAlgorithm::MD5:
+        {
+            MD5_CTX ctx;
+            trantor_md5_init(&ctx);
+            return std::unique_ptr<HashContext>(
+                new BuiltinHashContext<Md5Traits>(ctx));
+        }
+        case HashAlgorithm::SHA1:
+        {
+            SHA1_CTX ctx;
+            trantor_sha1_init(&ctx);
+            return std::unique_ptr<HashContext>(
+                new BuiltinHashContext<Sha1Traits>(ctx));
+        }
+        case HashAlgorithm::SHA256:
+        {
+            SHA256_CTX ctx;
+            trantor_sha256_init(&ctx);
+            return std::unique_ptr<HashContext>(
+                new BuiltinHashContext<Sha256Traits>(ctx));
+        }
+        case HashAlgorithm::SHA3:
+            return newSha3Context();
+        case HashAlgorithm::BLAKE2b:
+            break;
+    }
+    return newBlake2bContext(nullptr, 0);
+}
+#endif
+
 #if !defined(USE_BOTAN) && !defined(USE_OPENSSL)
 Hash128 md5(const void *data, size_t len)
 {
@@ -398,17 +563,678 @@ Hash256 blake2b(const void *data, size_t len)
 }
 #endif
 
+static size_t hmacDigestLength(HashAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case HashAlgorithm::MD5:
+            return sizeof(Hash128);
+        case HashAlgorithm::SHA1:
+            return sizeof(Hash160);
+        default:
+            return sizeof(Hash256);
+    }
+}
+
+// Clear key material in a way the compiler can't optimize away
+static void secureZero(void *data, size_t len)
+{
+    volatile unsigned char *p = (volatile unsigned char *)data;
+    while (len--)
+        *p++ = 0;
+}
+
+Hmac::Hmac(HashAlgorithm algorithm, const void *key, size_t keyLen)
+    : algorithm_(algorithm), digestLength_(hmacDigestLength(algorithm))
+{
+    if (algorithm == HashAlgorithm::BLAKE2b)
+    {
+        Hash256 hashedKey;
+        if (keyLen > BLAKE2B_KEYBYTES)
+        {
+            hashedKey = blake2b(key, keyLen);
+            key = &hashedKey;
+            keyLen = sizeof(hashedKey);
+        }
+        inner_ = internal::newBlake2bContext(key, keyLen);
+        work_ = inner_->clone();
+        secureZero(&hashedKey, sizeof(hashedKey));
+        return;
+    }
+
+    // SHA3-256 absorbs 136 bytes per block, the others 64
+    const size_t blockSize = algorithm == HashAlgorithm::SHA3 ? 136 : 64;
+    unsigned char pad[136];
+    unsigned char hashedKey[sizeof(Hash256)];
+    inner_ = internal::newHashContext(algorithm);
+    outer_ = internal::newHashContext(algorithm);
+    if (keyLen > blockSize)
+    {
+        auto ctx = inner_->clone();
+        ctx->update(key, keyLen);
+        ctx->finalize(hashedKey);
+        key = hashedKey;
+        keyLen = digestLength_;
+    }
+    memset(pad, 0x36, blockSize);
+    for (size_t i = 0; i < keyLen; ++i)
+        pad[i] ^= ((const unsigned char *)key)[i];
+    inner_->update(pad, blockSize);
+    for (size_t i = 0; i < blockSize; ++i)
+        pad[i] ^= 0x36 ^ 0x5c;
+    outer_->update(pad, blockSize);
+    work_ = inner_->clone();
+    secureZero(pad, sizeof(pad));
+    secureZero(hashedKey, sizeof(hashedKey));
+}
+
+Hmac::Hmac(const Hmac &other)
+    : algorithm_(other.algorithm_),
+      digestLength_(other.digestLength_),
+      inner_(other.inner_->clone()),
+      outer_(other.outer_ ? other.outer_->clone() : nullptr),
+      work_(other.inner_->clone())
+{
+}
+
+Hmac &Hmac::operator=(const Hmac &other)
+{
+    if (this != &other)
+        *this = Hmac(other);
+    return *this;
+}
+
+Hmac::Hmac(Hmac &&other) noexcept = default;
+Hmac &Hmac::operator=(Hmac &&other) noexcept = default;
+Hmac::~Hmac() = default;
+
+void Hmac::sign(const void *data, size_t len, void *out)
+{
+    work_->copyFrom(*inner_);
+    work_->update(data, len);
+    if (!outer_)
+    {
+        work_->finalize((unsigned char *)out);
+        return;
+    }
+    unsigned char innerHash[sizeof(Hash256)];
+    work_->finalize(innerHash);
+    work_->copyFrom(*outer_);
+    work_->update(innerHash, digestLength_);
+    work_->finalize((unsigned char *)out);
+}
+
+void Hmac::signBatch(const void *const *data,
+                     const size_t *lens,
+                     size_t count,
+                     void *out)
+{
+    unsigned char *dst = (unsigned char *)out;
+    for (size_t i = 0; i < count; ++i, dst += digestLength_)
+        sign(data[i], lens[i], dst);
+}
+
+std::vector<std::string> Hmac::signBatch(const std::vector<std::string> &data)
+{
+    std::vector<std::string> macs;
+    macs.reserve(data.size());
+    for (auto &message : data)
+        macs.push_back(sign(message));
+    return macs;
+}
+
+bool Hmac::verify(const void *data, size_t len, const void *mac, size_t macLen)
+{
+    if (macLen != digestLength_)
+        return false;
+    unsigned char expected[sizeof(Hash256)];
+    sign(data, len, expected);
+    unsigned char diff = 0;
+    for (size_t i = 0; i < macLen; ++i)
+        diff |= expected[i] ^ ((const unsigned char *)mac)[i];
+    return diff == 0;
+}
+
+// wyhash final version 4, by Wang Yi (public domain / The Unlicense)
+// https://github.com/wangyi-fudan/wyhash
+static inline void wyMum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = *a;
+    r *= *b;
+    *a = static_cast<uint64_t>(r);
+    *b = static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static inline uint64_t wyMix(uint64_t a, uint64_t b)
+{
+    wyMum(&a, &b);
+    return a ^ b;
+}
+
+// Reads are little endian on every platform so that hashes are portable
+static inline uint64_t wyRead8(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint64_t wyRead4(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline uint64_t wyRead3(const uint8_t *p, size_t k)
+{
+    return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+static uint64_t wyHash(const void *key,
+                       size_t len,
+                       uint64_t seed,
+                       const uint64_t *secret)
+{
+    const uint8_t *p = (const uint8_t *)key;
+    seed ^= wyMix(seed ^ secret[0], secret[1]);
+    uint64_t a, b;
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (wyRead4(p) << 32) | wyRead4(p + ((len >> 3) << 2));
+            b = (wyRead4(p + len - 4) << 32) |
+                wyRead4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = wyRead3(p, len);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if (i >= 48)
+        {
+            // three independent lanes keep the multipliers busy
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = wyMix(wyRead8(p) ^ secret[1], wyRead8(p + 8) ^ seed);
+                see1 =
+                    wyMix(wyRead8(p + 16) ^ secret[2], wyRead8(p + 24) ^ see1);
+                see2 =
+                    wyMix(wyRead8(p + 32) ^ secret[3], wyRead8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = wyMix(wyRead8(p) ^ secret[1], wyRead8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyRead8(p + i - 16);
+        b = wyRead8(p + i - 8);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    wyMum(&a, &b);
+    return wyMix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+static const uint64_t kWySecret[4] = {0x2d358dccaa6c78a5ull,
+                                      0x8bb84b93962eacc9ull,
+                                      0x4b33a62ed433d4a3ull,
+                                      0x4d5a2da51de1aa47ull};
+// Secret of the upper half of fastHash128()
+static const uint64_t kWySecretHigh[4] = {0xa0761d6478bd642full,
+                                          0xe7037ed1a0b428dbull,
+                                          0x8ebc6af09c88c6e3ull,
+                                          0x589965cc75374cc3ull};
+
+uint64_t fastHash64(const void *data, size_t len, uint64_t seed)
+{
+    return wyHash(data, len, seed, kWySecret);
+}
+
+Hash128 fastHash128(const void *data, size_t len, uint64_t seed)
+{
+    uint64_t low = wyHash(data, len, seed, kWySecret);
+    uint64_t high = wyHash(data, len, seed, kWySecretHigh);
+    Hash128 hash;
+    for (int i = 0; i < 8; ++i)
+    {
+        hash.bytes[i] = static_cast<unsigned char>(low >> (8 * i));
+        hash.bytes[i + 8] = static_cast<unsigned char>(high >> (8 * i));
+    }
+    return hash;
+}
+
+// Vectorized hex and base64 codecs. The SSSE3 kernels process whole blocks
+// and return how much input they consumed, the scalar code finishes the tail
+// (and reports errors precisely when a block contains invalid characters).
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define TRANTOR_SSSE3_CODEC 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TRANTOR_TARGET_SSSE3
+#else
+#define TRANTOR_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+static bool cpuHasSsse3()
+{
+    static const bool hasSsse3 = []() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+#endif
+    }();
+    return hasSsse3;
+}
+
+TRANTOR_TARGET_SSSE3
+static size_t hexEncodeSsse3(const unsigned char *src,
+                             size_t len,
+                             char *dst,
+                             const char *digits)
+{
+    const __m128i table = _mm_loadu_si128((const __m128i *)digits);
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+        __m128i lo = _mm_and_si128(in, mask);
+        hi = _mm_shuffle_epi8(table, hi);
+        lo = _mm_shuffle_epi8(table, lo);
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 16),
+                         _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// Convert 16 hex digits to their values, set valid to false on bad input
+TRANTOR_TARGET_SSSE3
+static inline __m128i hexDigitsSsse3(__m128i in, bool &valid)
+{
+    const __m128i lower = _mm_or_si128(in, _mm_set1_epi8(0x20));
+    const __m128i isDigit =
+        _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)),
+                      _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+    const __m128i isAlpha =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    valid = _mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) == 0xffff;
+    return _mm_or_si128(
+        _mm_and_si128(isDigit, _mm_sub_epi8(in, _mm_set1_epi8('0'))),
+        _mm_and_si128(isAlpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+TRANTOR_TARGET_SSSE3
+static size_t hexDecodeSsse3(const char *src, size_t len, unsigned char *dst)
+{
+    // (high, low) digit pairs become high * 16 + low
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        bool valid0, valid1;
+        __m128i v0 = hexDigitsSsse3(
+            _mm_loadu_si128((const __m128i *)(src + i)), valid0);
+        __m128i v1 = hexDigitsSsse3(
+            _mm_loadu_si128((const __m128i *)(src + i + 16)), valid1);
+        if (!valid0 || !valid1)
+            break;
+        v0 = _mm_maddubs_epi16(v0, weights);
+        v1 = _mm_maddubs_epi16(v1, weights);
+        _mm_storeu_si128((__m128i *)(dst + i / 2), _mm_packus_epi16(v0, v1));
+    }
+    return i;
+}
+
+// Based on the SSE base64 codecs by Wojciech Mula and Daniel Lemire,
+// see "Faster Base64 Encoding and Decoding using AVX2 Instructions" (2018).
+TRANTOR_TARGET_SSSE3
+static size_t base64EncodeSsse3(const unsigned char *src,
+                                size_t len,
+                                char *dst,
+                                bool urlSafe)
+{
+    const __m128i shuffle =
+        _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    // offsets added to the 6-bit indices, selected by range
+    const __m128i offsets = _mm_setr_epi8('a' - 26,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          '0' - 52,
+                                          urlSafe ? '-' - 62 : '+' - 62,
+                                          urlSafe ? '_' - 63 : '/' - 63,
+                                          'A',
+                                          0,
+                                          0);
+    size_t i = 0;
+    size_t o = 0;
+    // 12 bytes are encoded per block, but 16 are loaded
+    for (; i + 16 <= len; i += 12, o += 16)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        in = _mm_shuffle_epi8(in, shuffle);
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        const __m128i out =
+            _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+        _mm_storeu_si128((__m128i *)(dst + o), out);
+    }
+    return i;
+}
+
+TRANTOR_TARGET_SSSE3
+static size_t base64DecodeSsse3(const char *src, size_t len, unsigned char *dst)
+{
+    const __m128i lutLo = _mm_setr_epi8(0x15,
+                                        0x11,
+                                        0x11,
+                                        0x11,
+                                        0x11,
+                                        0x11,
+                                        0x11,
+                                        0x11,
+                                        0x11,
+                                        0x11,
+                                        0x13,
+                                        0x1A,
+                                        0x1B,
+                                        0x1B,
+                                        0x1B,
+                                        0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10,
+                                        0x10,
+                                        0x01,
+                                        0x02,
+                                        0x04,
+                                        0x08,
+                                        0x04,
+                                        0x08,
+                                        0x10,
+                                        0x10,
+                                        0x10,
+                                        0x10,
+                                        0x10,
+                                        0x10,
+                                        0x10,
+                                        0x10);
+    const __m128i lutRoll =
+        _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2f);
+    const __m128i pack = _mm_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+    size_t o = 0;
+    // 16 bytes are stored per block but only 12 are valid. Keep at least 8
+    // characters (at least 4 decoded bytes) behind so the extra stores stay
+    // inside the output buffer.
+    for (; i + 24 <= len; i += 16, o += 12)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        // map the URL safe alphabet to the standard one
+        const __m128i isMinus = _mm_cmpeq_epi8(in, _mm_set1_epi8('-'));
+        const __m128i isUnderscore = _mm_cmpeq_epi8(in, _mm_set1_epi8('_'));
+        in = _mm_add_epi8(in, _mm_and_si128(isMinus, _mm_set1_epi8('+' - '-')));
+        in = _mm_add_epi8(
+            in, _mm_and_si128(isUnderscore, _mm_set1_epi8('/' - '_')));
+
+        const __m128i hiNibbles =
+            _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+        const __m128i loNibbles = _mm_and_si128(in, mask2F);
+        const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi),
+                                             _mm_setzero_si128())) != 0xffff)
+            break;
+        const __m128i eq2F = _mm_cmpeq_epi8(in, mask2F);
+        const __m128i roll =
+            _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+        in = _mm_add_epi8(in, roll);
+
+        const __m128i mergedAB =
+            _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+        __m128i out = _mm_madd_epi16(mergedAB, _mm_set1_epi32(0x00011000));
+        out = _mm_shuffle_epi8(out, pack);
+        _mm_storeu_si128((__m128i *)(dst + o), out);
+    }
+    return i;
+}
+#endif  // x86
+
+static const char kHexUpper[] = "0123456789ABCDEF";
+static const char kHexLower[] = "0123456789abcdef";
+
+void toHexString(const void *data, size_t len, char *out, bool lowerCase)
+{
+    const unsigned char *src = (const unsigned char *)data;
+    const char *digits = lowerCase ? kHexLower : kHexUpper;
+    size_t i = 0;
+#ifdef TRANTOR_SSSE3_CODEC
+    if (len >= 16 && cpuHasSsse3())
+        i = hexEncodeSsse3(src, len, out, digits);
+#endif
+    for (; i < len; i++)
+    {
+        unsigned char c = src[i];
+        out[i * 2] = digits[c >> 4];
+        out[i * 2 + 1] = digits[c & 0xf];
+    }
+}
+
 std::string toHexString(const void *data, size_t len)
 {
     std::string str;
     str.resize(len * 2);
-    for (size_t i = 0; i < len; i++)
+    if (len > 0)
+        toHexString(data, len, &str[0]);
+    return str;
+}
+
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool fromHexString(const char *str, size_t len, void *out)
+{
+    if (len % 2 != 0)
+        return false;
+    unsigned char *dst = (unsigned char *)out;
+    size_t i = 0;
+#ifdef TRANTOR_SSSE3_CODEC
+    if (len >= 32 && cpuHasSsse3())
+        i = hexDecodeSsse3(str, len, dst);
+#endif
+    for (; i < len; i += 2)
     {
-        unsigned char c = ((const unsigned char *)data)[i];
-        str[i * 2] = "0123456789ABCDEF"[c >> 4];
-        str[i * 2 + 1] = "0123456789ABCDEF"[c & 0xf];
+        int hi = hexValue(str[i]);
+        int lo = hexValue(str[i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        dst[i / 2] = static_cast<unsigned char>(hi << 4 | lo);
     }
-    return str;
+    return true;
+}
+
+static const char kBase64Chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char kBase64UrlChars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+size_t base64Encode(const void *data,
+                    size_t len,
+                    char *out,
+                    bool urlSafe,
+                    bool padded)
+{
+    const unsigned char *src = (const unsigned char *)data;
+    const char *chars = urlSafe ? kBase64UrlChars : kBase64Chars;
+    size_t i = 0;
+    size_t o = 0;
+#ifdef TRANTOR_SSSE3_CODEC
+    if (len >= 16 && cpuHasSsse3())
+    {
+        i = base64EncodeSsse3(src, len, out, urlSafe);
+        o = i / 3 * 4;
+    }
+#endif
+    for (; i + 3 <= len; i += 3)
+    {
+        uint32_t n = (uint32_t)src[i] << 16 | (uint32_t)src[i + 1] << 8 |
+                     src[i + 2];
+        out[o++] = chars[n >> 18];
+        out[o++] = chars[(n >> 12) & 0x3f];
+        out[o++] = chars[(n >> 6) & 0x3f];
+        out[o++] = chars[n & 0x3f];
+    }
+    if (i < len)
+    {
+        uint32_t n = (uint32_t)src[i] << 16;
+        if (i + 1 < len)
+            n |= (uint32_t)src[i + 1] << 8;
+        out[o++] = chars[n >> 18];
+        out[o++] = chars[(n >> 12) & 0x3f];
+        if (i + 1 < len)
+            out[o++] = chars[(n >> 6) & 0x3f];
+        else if (padded)
+            out[o++] = '=';
+        if (padded)
+            out[o++] = '=';
+    }
+    return o;
+}
+
+namespace
+{
+struct Base64DecodeTable
+{
+    Base64DecodeTable()
+    {
+        memset(values, 0xff, sizeof(values));
+        for (unsigned char i = 0; i < 64; ++i)
+        {
+            values[(unsigned char)kBase64Chars[i]] = i;
+            values[(unsigned char)kBase64UrlChars[i]] = i;
+        }
+    }
+    unsigned char values[256];
+};
+}  // namespace
+
+bool base64Decode(const char *str, size_t len, void *out, size_t &outLen)
+{
+    static const Base64DecodeTable table;
+    // at most two padding characters, and only at the end of a full quantum
+    if (len > 0 && str[len - 1] == '=')
+    {
+        if (len % 4 != 0)
+            return false;
+        --len;
+        if (str[len - 1] == '=')
+            --len;
+    }
+    if (len % 4 == 1)
+        return false;
+
+    unsigned char *dst = (unsigned char *)out;
+    size_t i = 0;
+    size_t o = 0;
+#ifdef TRANTOR_SSSE3_CODEC
+    if (len >= 24 && cpuHasSsse3())
+    {
+        i = base64DecodeSsse3(str, len, dst);
+        o = i / 4 * 3;
+    }
+#endif
+    for (; i + 4 <= len; i += 4)
+    {
+        unsigned char a = table.values[(unsigned char)str[i]];
+        unsigned char b = table.values[(unsigned char)str[i + 1]];
+        unsigned char c = table.values[(unsigned char)str[i + 2]];
+        unsigned char d = table.values[(unsigned char)str[i + 3]];
+        if ((a | b | c | d) & 0x80)
+            return false;
+        uint32_t n = (uint32_t)a << 18 | (uint32_t)b << 12 |
+                     (uint32_t)c << 6 | d;
+        dst[o++] = static_cast<unsigned char>(n >> 16);
+        dst[o++] = static_cast<unsigned char>(n >> 8);
+        dst[o++] = static_cast<unsigned char>(n);
+    }
+    if (i < len)
+    {
+        // 2 or 3 characters left
+        unsigned char a = table.values[(unsigned char)str[i]];
+        unsigned char b = table.values[(unsigned char)str[i + 1]];
+        unsigned char c =
+            (i + 2 < len) ? table.values[(unsigned char)str[i + 2]] : 0;
+        if ((a | b | c) & 0x80)
+            return false;
+        uint32_t n = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6;
+        dst[o++] = static_cast<unsigned char>(n >> 16);
+        if (i + 2 < len)
+            dst[o++] = static_cast<unsigned char>(n >> 8);
+    }
+    outLen = o;
+    return true;
 }
 
 #if !defined(USE_BOTAN) && !defined(USE_OPENSSL)
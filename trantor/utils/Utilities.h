@@ -15,7 +15,11 @@
 #pragma once
 
 #include <trantor/exports.h>
+#include <trantor/utils/StringView.h>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace trantor
 {
@@ -252,6 +256,163 @@ inline Hash256 blake2b(const std::string &str)
     return blake2b(str.data(), str.size());
 }
 
+/**
+ * @brief The hash functions usable with Hmac
+ */
+enum class HashAlgorithm
+{
+    MD5,
+    SHA1,
+    SHA256,
+    SHA3,
+    BLAKE2b
+};
+
+namespace internal
+{
+class HashContext;
+}
+
+/**
+ * @brief Keyed message authentication with one of the hash functions above.
+ * @details HMAC (RFC 2104) is used for MD5, SHA1, SHA256 and SHA3(256). For
+ * BLAKE2b the native keyed mode of BLAKE2b-256 is used instead, keys longer
+ * than 64 bytes are hashed with BLAKE2b-256 first.
+ *
+ * The key is processed once in the constructor, signing a message only hashes
+ * the message itself. So keep the object around for keys used repeatedly.
+ * @code
+   trantor::utils::Hmac hmac(trantor::utils::HashAlgorithm::SHA256, secret);
+   auto mac = hmac.sign(payload);
+   bool ok = hmac.verify(payload, mac);
+   @endcode
+ * @note An Hmac object is not thread safe, give each thread its own copy.
+ */
+class TRANTOR_EXPORT Hmac
+{
+  public:
+    Hmac(HashAlgorithm algorithm, const void *key, size_t keyLen);
+    Hmac(HashAlgorithm algorithm, const std::string &key)
+        : Hmac(algorithm, key.data(), key.size())
+    {
+    }
+    Hmac(const Hmac &other);
+    Hmac &operator=(const Hmac &other);
+    Hmac(Hmac &&other) noexcept;
+    Hmac &operator=(Hmac &&other) noexcept;
+    ~Hmac();
+
+    HashAlgorithm algorithm() const
+    {
+        return algorithm_;
+    }
+
+    /**
+     * @brief The length of the MACs in bytes, 16 for MD5, 20 for SHA1 and 32
+     * for the others.
+     */
+    size_t digestLength() const
+    {
+        return digestLength_;
+    }
+
+    /**
+     * @brief Compute the MAC of the data into out, which must have room for
+     * digestLength() bytes.
+     */
+    void sign(const void *data, size_t len, void *out);
+    std::string sign(const std::string &data)
+    {
+        std::string mac(digestLength_, '\0');
+        sign(data.data(), data.size(), &mac[0]);
+        return mac;
+    }
+
+    /**
+     * @brief Compute the MACs of count messages. The MAC of the i-th message
+     * is written at out + i * digestLength().
+     */
+    void signBatch(const void *const *data,
+                   const size_t *lens,
+                   size_t count,
+                   void *out);
+    std::vector<std::string> signBatch(const std::vector<std::string> &data);
+
+    /**
+     * @brief Check the MAC of the data in constant time.
+     * @note Truncated MACs are not accepted, macLen must be digestLength().
+     */
+    bool verify(const void *data, size_t len, const void *mac, size_t macLen);
+    bool verify(const std::string &data, const std::string &mac)
+    {
+        return verify(data.data(), data.size(), mac.data(), mac.size());
+    }
+
+  private:
+    HashAlgorithm algorithm_;
+    size_t digestLength_;
+    // state after absorbing the padded key, copied into work_ for each message
+    std::unique_ptr<internal::HashContext> inner_;
+    std::unique_ptr<internal::HashContext> outer_;
+    std::unique_ptr<internal::HashContext> work_;
+};
+
+/**
+ * @brief Compute a fast 64-bit non-cryptographic hash of the given data
+ * @param seed Different seeds give independent hash functions. Use a random
+ * seed for tables keyed by untrusted input.
+ * @note The algorithm is wyhash (final version 4), the results are the same on
+ * all platforms. Never use it where a cryptographic hash is required.
+ */
+TRANTOR_EXPORT uint64_t fastHash64(const void *data,
+                                   size_t len,
+                                   uint64_t seed = 0);
+/**
+ * @brief Compute fastHash64() of a string with the seed 0.
+ * @note There is no seed parameter on purpose: fastHash64("key", 1) calls the
+ * overload above and hashes 1 byte. Call fastHash64(str.data(), str.size(),
+ * seed) to give a seed.
+ */
+inline uint64_t fastHash64(StringView str)
+{
+    return fastHash64(str.data(), str.size());
+}
+
+/**
+ * @brief Compute a fast 128-bit non-cryptographic hash of the given data
+ * @note The two halves are computed with independent secrets. Suitable for
+ * sharding, fingerprints and deduplication, not for security.
+ */
+TRANTOR_EXPORT Hash128 fastHash128(const void *data,
+                                   size_t len,
+                                   uint64_t seed = 0);
+/**
+ * @brief Compute fastHash128() of a string with the seed 0, see
+ * fastHash64(StringView).
+ */
+inline Hash128 fastHash128(StringView str)
+{
+    return fastHash128(str.data(), str.size());
+}
+
+/**
+ * @brief A hasher for unordered containers with string keys, using
+ * fastHash64() instead of std::hash.
+ * @code
+   std::unordered_map<std::string, int, trantor::utils::StringHash> map;
+   @endcode
+ */
+struct StringHash
+{
+    // Not noexcept on purpose: libstdc++ only caches hash codes in the nodes
+    // of unordered containers when the hasher may throw, and without the
+    // cache every bucket walk would rehash the keys.
+    size_t operator()(const std::string &str) const
+    {
+        return static_cast<size_t>(fastHash64(str.data(), str.size()));
+    }
+};
+
 /**
  * @brief hex encode the given data
  * @note When in doubt, use SHA3 or BLAKE2b. Both are safe and SHA3 is faster if
@@ -274,6 +435,106 @@ inline std::string toHexString(const Hash256 &hash)
     return toHexString(hash.bytes, sizeof(hash.bytes));
 }
 
+/**
+ * @brief hex encode the given data into a caller provided buffer
+ * @param out The buffer must have room for 2 * len characters. No null
+ * terminator is written.
+ * @param lowerCase Use lower case digits instead of upper case ones.
+ */
+TRANTOR_EXPORT void toHexString(const void *data,
+                                size_t len,
+                                char *out,
+                                bool lowerCase = false);
+
+/**
+ * @brief Decode a hex string (upper or lower case digits)
+ * @param out The buffer must have room for len / 2 bytes.
+ * @return false if len is odd or a character is not a hex digit.
+ */
+TRANTOR_EXPORT bool fromHexString(const char *str, size_t len, void *out);
+inline bool fromHexString(const std::string &str, std::string &out)
+{
+    out.resize(str.size() / 2);
+    if (fromHexString(str.data(), str.size(), &out[0]))
+        return true;
+    out.clear();
+    return false;
+}
+
+/**
+ * @brief Return the length of the base64 encoding of len bytes
+ */
+inline size_t base64EncodedLength(size_t len, bool padded = true)
+{
+    return padded ? (len + 2) / 3 * 4 : (len * 4 + 2) / 3;
+}
+
+/**
+ * @brief Return the maximum number of bytes decoded from len base64
+ * characters
+ */
+inline size_t base64DecodedMaxLength(size_t len)
+{
+    return (len + 3) / 4 * 3;
+}
+
+/**
+ * @brief base64 encode the given data into a caller provided buffer
+ * @param out The buffer must have room for base64EncodedLength(len, padded)
+ * characters. No null terminator is written.
+ * @param urlSafe Use the URL and filename safe alphabet ('-' and '_' instead
+ * of '+' and '/') defined in RFC 4648.
+ * @param padded Append '=' padding characters.
+ * @return The number of characters written.
+ */
+TRANTOR_EXPORT size_t base64Encode(const void *data,
+                                   size_t len,
+                                   char *out,
+                                   bool urlSafe = false,
+                                   bool padded = true);
+inline std::string base64Encode(const void *data,
+                                size_t len,
+                                bool urlSafe = false,
+                                bool padded = true)
+{
+    std::string str;
+    str.resize(base64EncodedLength(len, padded));
+    if (!str.empty())
+        base64Encode(data, len, &str[0], urlSafe, padded);
+    return str;
+}
+inline std::string base64Encode(const std::string &str,
+                                bool urlSafe = false,
+                                bool padded = true)
+{
+    return base64Encode(str.data(), str.size(), urlSafe, padded);
+}
+
+/**
+ * @brief Decode base64 data into a caller provided buffer
+ * @details Both the standard and the URL safe alphabets are accepted, with or
+ * without padding.
+ * @param out The buffer must have room for base64DecodedMaxLength(len) bytes.
+ * @param outLen The number of bytes written.
+ * @return false if the input is not valid base64.
+ */
+TRANTOR_EXPORT bool base64Decode(const char *str,
+                                 size_t len,
+                                 void *out,
+                                 size_t &outLen);
+inline bool base64Decode(const std::string &str, std::string &out)
+{
+    size_t outLen = 0;
+    out.resize(base64DecodedMaxLength(str.size()));
+    if (base64Decode(str.data(), str.size(), &out[0], outLen))
+    {
+        out.resize(outLen);
+        return true;
+    }
+    out.clear();
+    return false;
+}
+
 /**
  * @brief Generates cryptographically secure random bytes
  * @param ptr Pointer to the buffer to fill
@@ -0,0 +1,490 @@
+/**
+ *
+ *  @file WireCodec.h
+ *  @author An Tao
+ *
+ *  Public header file in trantor lib.
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the License file.
+ *
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/MsgBuffer.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANTOR_WIRE_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
+namespace trantor
+{
+/**
+ * @brief Binary encoding of integers, floating point numbers and arrays.
+ * @details Fixed width values are big endian (network byte order) like
+ * MsgBuffer::appendInt32(). Varints use the LEB128 encoding of protobuf,
+ * signed integers are zigzag encoded first so small negative numbers stay
+ * short.
+ *
+ * Encoding goes through MsgBuffer::appendFields(), which reserves room for
+ * all the fields at once and then writes them without further checks:
+ * @code
+   using namespace trantor;
+   buffer.appendFields(wire::fixed(uint16_t(1)),
+                       wire::varint(id),
+                       wire::varint(uint32_t(values.size())),
+                       wire::array(values.data(), values.size()));
+
+   wire::Reader reader(buffer);
+   uint16_t version;
+   uint64_t id;
+   uint32_t count;
+   if (!reader.readFixed(version) || !reader.readVarint(id) ||
+       !reader.readVarint(count) || count > kMaxCount)
+       return false;
+   std::vector<double> decoded(count);
+   if (!reader.readArray(decoded.data(), count))
+       return false;
+   buffer.retrieve(reader.consumed());
+   @endcode
+ */
+namespace wire
+{
+namespace internal
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static constexpr bool kBigEndianHost = true;
+#else
+static constexpr bool kBigEndianHost = false;
+#endif
+
+inline uint8_t byteSwap(uint8_t v)
+{
+    return v;
+}
+inline uint16_t byteSwap(uint16_t v)
+{
+#ifdef _MSC_VER
+    return _byteswap_ushort(v);
+#else
+    return __builtin_bswap16(v);
+#endif
+}
+inline uint32_t byteSwap(uint32_t v)
+{
+#ifdef _MSC_VER
+    return _byteswap_ulong(v);
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+inline uint64_t byteSwap(uint64_t v)
+{
+#ifdef _MSC_VER
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+// The unsigned integer with the same size as T, for integers, float and
+// double
+template <size_t N>
+struct UIntOfSize;
+template <>
+struct UIntOfSize<1>
+{
+    using type = uint8_t;
+};
+template <>
+struct UIntOfSize<2>
+{
+    using type = uint16_t;
+};
+template <>
+struct UIntOfSize<4>
+{
+    using type = uint32_t;
+};
+template <>
+struct UIntOfSize<8>
+{
+    using type = uint64_t;
+};
+template <typename T>
+using Bits = typename UIntOfSize<sizeof(T)>::type;
+
+template <typename T>
+inline void storeBigEndian(char *p, T value)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "only integers and floating point numbers are supported");
+    Bits<T> bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (!kBigEndianHost)
+        bits = byteSwap(bits);
+    memcpy(p, &bits, sizeof(bits));
+}
+
+template <typename T>
+inline T loadBigEndian(const char *p)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "only integers and floating point numbers are supported");
+    Bits<T> bits;
+    memcpy(&bits, p, sizeof(bits));
+    if (!kBigEndianHost)
+        bits = byteSwap(bits);
+    T value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#ifdef TRANTOR_WIRE_SSE2
+// Reverse the bytes of each N byte lane, SSE2 only so no dispatch is needed
+template <size_t N>
+inline __m128i byteSwapLanes(__m128i v);
+template <>
+inline __m128i byteSwapLanes<2>(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+template <>
+inline __m128i byteSwapLanes<4>(__m128i v)
+{
+    v = byteSwapLanes<2>(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+template <>
+inline __m128i byteSwapLanes<8>(__m128i v)
+{
+    v = byteSwapLanes<2>(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+#endif
+
+// Copy count values of N bytes each, converting between host and big endian
+template <size_t N>
+inline void copyBigEndian(char *dst, const char *src, size_t count)
+{
+    if (kBigEndianHost || N == 1)
+    {
+        if (count > 0)
+            memcpy(dst, src, count * N);
+        return;
+    }
+    size_t i = 0;
+#ifdef TRANTOR_WIRE_SSE2
+    const size_t bytes = count * N;
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         byteSwapLanes<N>(v));
+    }
+    i /= N;
+#endif
+    using U = typename UIntOfSize<N>::type;
+    for (; i < count; ++i)
+    {
+        U v;
+        memcpy(&v, src + i * N, N);
+        v = byteSwap(v);
+        memcpy(dst + i * N, &v, N);
+    }
+}
+}  // namespace internal
+
+/**
+ * @brief A fixed width big endian integer, float or double.
+ */
+template <typename T>
+class Fixed
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "only integers and floating point numbers are supported");
+
+  public:
+    explicit Fixed(T value) : value_(value)
+    {
+    }
+    static constexpr size_t maxEncodedSize()
+    {
+        return sizeof(T);
+    }
+    char *encode(char *p) const
+    {
+        internal::storeBigEndian(p, value_);
+        return p + sizeof(T);
+    }
+
+  private:
+    T value_;
+};
+
+/**
+ * @brief A variable length integer, 1 byte for values below 128 and at most
+ * 10 bytes for 64 bit values. Signed values are zigzag encoded.
+ */
+template <typename T>
+class Varint
+{
+    static_assert(std::is_integral<T>::value, "only integers are supported");
+    using U = typename std::make_unsigned<T>::type;
+
+  public:
+    explicit Varint(T value) : value_(zigzag(value))
+    {
+    }
+    static constexpr size_t maxEncodedSize()
+    {
+        return (sizeof(T) * 8 + 6) / 7;
+    }
+    char *encode(char *p) const
+    {
+        U v = value_;
+        while (v >= 0x80)
+        {
+            *p++ = static_cast<char>(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = static_cast<char>(v);
+        return p;
+    }
+
+    static U zigzag(T value)
+    {
+        if (!std::is_signed<T>::value)
+            return static_cast<U>(value);
+        return static_cast<U>(static_cast<U>(value) << 1) ^
+               static_cast<U>(value >> (sizeof(T) * 8 - 1));
+    }
+    static T unzigzag(U value)
+    {
+        if (!std::is_signed<T>::value)
+            return static_cast<T>(value);
+        return static_cast<T>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+  private:
+    U value_;
+};
+
+/**
+ * @brief count fixed width values, without a length prefix. Converting to big
+ * endian is done 16 bytes at a time.
+ */
+template <typename T>
+class Array
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "only integers and floating point numbers are supported");
+
+  public:
+    Array(const T *data, size_t count) : data_(data), count_(count)
+    {
+    }
+    size_t maxEncodedSize() const
+    {
+        return count_ * sizeof(T);
+    }
+    char *encode(char *p) const
+    {
+        internal::copyBigEndian<sizeof(T)>(p,
+                                           reinterpret_cast<const char *>(
+                                               data_),
+                                           count_);
+        return p + count_ * sizeof(T);
+    }
+
+  private:
+    const T *data_;
+    size_t count_;
+};
+
+/**
+ * @brief Raw bytes, without a length prefix.
+ */
+class Bytes
+{
+  public:
+    Bytes(const void *data, size_t len) : data_(data), len_(len)
+    {
+    }
+    size_t maxEncodedSize() const
+    {
+        return len_;
+    }
+    char *encode(char *p) const
+    {
+        if (len_ > 0)
+            memcpy(p, data_, len_);
+        return p + len_;
+    }
+
+  private:
+    const void *data_;
+    size_t len_;
+};
+
+template <typename T>
+inline Fixed<T> fixed(T value)
+{
+    return Fixed<T>(value);
+}
+template <typename T>
+inline Varint<T> varint(T value)
+{
+    return Varint<T>(value);
+}
+template <typename T>
+inline Array<T> array(const T *data, size_t count)
+{
+    return Array<T>(data, count);
+}
+inline Bytes bytes(const void *data, size_t len)
+{
+    return Bytes(data, len);
+}
+inline Bytes bytes(const std::string &str)
+{
+    return Bytes(str.data(), str.size());
+}
+
+/**
+ * @brief Decodes the encodings above from a memory range. Every read either
+ * succeeds completely and advances, or returns false and consumes nothing.
+ * @note The reader doesn't own the data. When reading from a MsgBuffer,
+ * retrieve consumed() bytes once done.
+ */
+class Reader
+{
+  public:
+    Reader(const char *data, size_t len)
+        : begin_(data), pos_(data), end_(data + len)
+    {
+    }
+    explicit Reader(const MsgBuffer &buffer)
+        : Reader(buffer.peek(), buffer.readableBytes())
+    {
+    }
+
+    size_t consumed() const
+    {
+        return static_cast<size_t>(pos_ - begin_);
+    }
+    size_t remaining() const
+    {
+        return static_cast<size_t>(end_ - pos_);
+    }
+
+    /**
+     * @brief Read one or more fixed width values with a single bounds check.
+     */
+    template <typename... Ts>
+    bool readFixed(Ts &...values)
+    {
+        const size_t total = sumOfSizes<Ts...>();
+        if (remaining() < total)
+            return false;
+        (void)std::initializer_list<int>{
+            (values = internal::loadBigEndian<Ts>(pos_),
+             pos_ += sizeof(Ts),
+             0)...};
+        return true;
+    }
+
+    template <typename T>
+    bool readVarint(T &value)
+    {
+        static_assert(std::is_integral<T>::value,
+                      "only integers are supported");
+        using U = typename std::make_unsigned<T>::type;
+        constexpr size_t maxLen = Varint<T>::maxEncodedSize();
+        const char *p = pos_;
+        // no bounds checks per byte when the longest encoding fits
+        const char *limit = remaining() >= maxLen ? p + maxLen : end_;
+        constexpr unsigned bitsOfT = sizeof(U) * 8;
+        U result = 0;
+        for (unsigned shift = 0; p < limit; shift += 7)
+        {
+            const auto byte = static_cast<uint8_t>(*p++);
+            const U bits = static_cast<U>(byte & 0x7f);
+            // reject values that don't fit into T
+            if (bitsOfT - shift < 7 && (bits >> (bitsOfT - shift)) != 0)
+                return false;
+            result |= static_cast<U>(bits << shift);
+            if ((byte & 0x80) == 0)
+            {
+                // reject non-canonical encodings with trailing zero groups,
+                // so each value has a single encoding
+                if (byte == 0 && shift > 0)
+                    return false;
+                value = Varint<T>::unzigzag(result);
+                pos_ = p;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool readArray(T *out, size_t count)
+    {
+        static_assert(std::is_arithmetic<T>::value,
+                      "only integers and floating point numbers are supported");
+        if (count > remaining() / sizeof(T))
+            return false;
+        internal::copyBigEndian<sizeof(T)>(reinterpret_cast<char *>(out),
+                                           pos_,
+                                           count);
+        pos_ += count * sizeof(T);
+        return true;
+    }
+
+    bool readBytes(void *out, size_t len)
+    {
+        if (len > remaining())
+            return false;
+        if (len > 0)
+            memcpy(out, pos_, len);
+        pos_ += len;
+        return true;
+    }
+
+    bool skip(size_t len)
+    {
+        if (len > remaining())
+            return false;
+        pos_ += len;
+        return true;
+    }
+
+  private:
+    template <typename... Ts>
+    static constexpr size_t sumOfSizes()
+    {
+        size_t sum = 0;
+        (void)std::initializer_list<int>{(sum += sizeof(Ts), 0)...};
+        return sum;
+    }
+
+    const char *begin_;
+    const char *pos_;
+    const char *end_;
+};
+}  // namespace wire
+}  // namespace trantor
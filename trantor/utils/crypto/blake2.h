@@ -1,3 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum blake2b_constant
+{
+    BLAKE2B_BLOCKBYTES = 128,
+    BLAKE2B_OUTBYTES = 64,
+    BLAKE2B_KEYBYTES = 64,
+    BLAKE2B_SALTBYTES = 16,
+    BLAKE2B_PERSONALBYTES = 16
+};
+
+typedef struct blake2b_param
+{
+    uint8_t digest_length;                   /* 1 */
+    uint8_t key_length;                      /* 2 */
+    uint8_t fanout;                          /* 3 */
+    uint8_t depth;                           /* 4 */
+    uint32_t leaf_length;                    /* 8 */
+    uint64_t node_offset;                    /* 16 */
+    uint8_t node_depth;                      /* 17 */
+    uint8_t inner_length;                    /* 18 */
+    uint8_t reserved[14];                    /* 32 */
+    uint8_t salt[BLAKE2B_SALTBYTES];         /* 48 */
+    uint8_t personal[BLAKE2B_PERSONALBYTES]; /* 64 */
+} blake2b_param;
+
+typedef struct blake2b_state
+{
+    uint64_t h[8];                   /* chained state */
+    uint64_t t[2];                   /* total number of bytes */
+    uint64_t f[2];                   /* last block flag */
+    uint8_t buf[BLAKE2B_BLOCKBYTES]; /* input buffer */
+    size_t buflen;                   /* size of buffer */
+    size_t outlen;                   /* digest size */
+} blake2b_state;
+
+void trantor_blake2b_init(blake2b_state* state,
+                          size_t outlen,
+                          const void* key,
+                          size_t keylen);
+void trantor_blake2b_update(blake2b_state* state,
+                            const unsigned char* input_buffer,
+                            size_t inlen);
+void trantor_blake2b_final(blake2b_state* state, void* out, size_t outlen);
 void trantor_blake2b(void* output,
                      size_t outlen,
                      const void* input,
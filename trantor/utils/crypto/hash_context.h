@@ -0,0 +1,36 @@
+#pragma once
+
+#include <trantor/utils/Utilities.h>
+#include <memory>
+
+namespace trantor
+{
+namespace utils
+{
+namespace internal
+{
+/**
+ * @brief An incremental hash computation whose state can be copied, which is
+ * what Hmac needs to reuse the state after absorbing the key.
+ */
+class HashContext
+{
+  public:
+    virtual ~HashContext() = default;
+    virtual std::unique_ptr<HashContext> clone() const = 0;
+    // other is always a context of the same algorithm
+    virtual void copyFrom(const HashContext &other) = 0;
+    virtual void update(const void *data, size_t len) = 0;
+    // writes the digest, the context must be reset by copyFrom() afterwards
+    virtual void finalize(unsigned char *out) = 0;
+};
+
+// Implemented by the crypto backend
+std::unique_ptr<HashContext> newHashContext(HashAlgorithm algorithm);
+
+// The bundled implementations, usable with every backend
+std::unique_ptr<HashContext> newSha3Context();
+std::unique_ptr<HashContext> newBlake2bContext(const void *key, size_t keyLen);
+}  // namespace internal
+}  // namespace utils
+}  // namespace trantor
@@ -1,6 +1,7 @@
 #include <trantor/utils/Utilities.h>
 
 #include <openssl/evp.h>
+#include <cassert>
 
 #if OPENSSL_VERSION_MAJOR < 3
 #include <openssl/md5.h>
@@ -15,6 +16,8 @@
 #include "blake2.h"
 #include "blake2.cc"
 
+#include "hash_context.h"
+
 namespace trantor
 {
 namespace utils
@@ -136,5 +139,105 @@ Hash256 blake2b(const void* data, size_t len)
     return hash;
 }
 
+namespace
+{
+class OpenSSLHashContext : public internal::HashContext
+{
+  public:
+    explicit OpenSSLHashContext(const EVP_MD* md) : ctx_(EVP_MD_CTX_new())
+    {
+        if (md != nullptr)
+            EVP_DigestInit_ex(ctx_, md, nullptr);
+    }
+    ~OpenSSLHashContext() override
+    {
+        EVP_MD_CTX_free(ctx_);
+    }
+    std::unique_ptr<HashContext> clone() const override
+    {
+        auto ctx = new OpenSSLHashContext(nullptr);
+        EVP_MD_CTX_copy_ex(ctx->ctx_, ctx_);
+        return std::unique_ptr<HashContext>(ctx);
+    }
+    void copyFrom(const HashContext& other) override
+    {
+        EVP_MD_CTX_copy_ex(ctx_,
+                           static_cast<const OpenSSLHashContext&>(other).ctx_);
+    }
+    void update(const void* data, size_t len) override
+    {
+        EVP_DigestUpdate(ctx_, data, len);
+    }
+    void finalize(unsigned char* out) override
+    {
+        EVP_DigestFinal_ex(ctx_, out, nullptr);
+    }
+
+  private:
+    EVP_MD_CTX* ctx_;
+};
+}  // namespace
+
+std::unique_ptr<internal::HashContext> internal::newHashContext(
+    HashAlgorithm algorithm)
+{
+    // The digests are fetched once, fetching is expensive in OpenSSL 3
+    const EVP_MD* md = nullptr;
+    switch (algorithm)
+    {
+#if OPENSSL_VERSION_MAJOR >= 3
+        case HashAlgorithm::MD5:
+        {
+            static const EVP_MD* md5 = EVP_MD_fetch(nullptr, "MD5", nullptr);
+            md = md5;
+            break;
+        }
+        case HashAlgorithm::SHA1:
+        {
+            static const EVP_MD* sha1 = EVP_MD_fetch(nullptr, "SHA1", nullptr);
+            md = sha1;
+            break;
+        }
+        case HashAlgorithm::SHA256:
+        {
+            static const EVP_MD* sha256 =
+                EVP_MD_fetch(nullptr, "SHA256", nullptr);
+            md = sha256;
+            break;
+        }
+        case HashAlgorithm::SHA3:
+        {
+            static const EVP_MD* sha3 =
+                EVP_MD_fetch(nullptr, "SHA3-256", nullptr);
+            md = sha3;
+            break;
+        }
+#else
+        case HashAlgorithm::MD5:
+            md = EVP_md5();
+            break;
+        case HashAlgorithm::SHA1:
+            md = EVP_sha1();
+            break;
+        case HashAlgorithm::SHA256:
+            md = EVP_sha256();
+            break;
+        case HashAlgorithm::SHA3:
+#if !defined(LIBRESSL_VERSION_NUMBER)
+            md = EVP_sha3_256();
+#endif
+            break;
+#endif
+        case HashAlgorithm::BLAKE2b:
+            return newBlake2bContext(nullptr, 0);
+    }
+    if (md == nullptr)
+    {
+        assert(algorithm == HashAlgorithm::SHA3);
+        return newSha3Context();
+    }
+    return std::unique_ptr<HashContext>(new OpenSSLHashContext(md));
+}
+
 }  // namespace utils
 }  // namespace trantor